@@ -352,6 +352,7 @@ if(UNIX)
     unset(FLTK_USE_XFT CACHE)
     unset(FLTK_USE_XCURSOR CACHE)
     unset(FLTK_USE_XFIXES CACHE)
+    unset(FLTK_USE_XSHM CACHE)
     if(X11_FOUND)
       if(NOT X11_Xfixes_FOUND)
         message(WARNING "Install development headers for libXfixes (e.g., libxfixes-dev)")
@@ -914,6 +915,19 @@ else()
   set(FLTK_XFIXES_FOUND FALSE)
 endif(FLTK_USE_XFIXES)
 
+#######################################################################
+if(X11_XShm_FOUND AND X11_Xext_FOUND)
+  option(FLTK_USE_XSHM "use MIT-SHM shared memory for drawing images" ON)
+endif(X11_XShm_FOUND AND X11_Xext_FOUND)
+
+if(FLTK_USE_XSHM)
+  set(HAVE_XSHM ${X11_XShm_FOUND})
+  list(APPEND FLTK_BUILD_INCLUDE_DIRECTORIES ${X11_XShm_INCLUDE_PATH})
+  set(FLTK_XSHM_FOUND TRUE)
+else()
+  set(FLTK_XSHM_FOUND FALSE)
+endif(FLTK_USE_XSHM)
+
 #######################################################################
 if(X11_Xcursor_FOUND)
   option(FLTK_USE_XCURSOR "use lib Xcursor" ON)
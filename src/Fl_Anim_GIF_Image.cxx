@@ -240,13 +240,14 @@ void Fl_Anim_GIF_Image::FrameInfo::dispose(int frame) {
         int pw = frames[prev].w;
         int ph = frames[prev].h;
         const char *src = frames[prev].rgb->data()[0];
-        if (px == 0 && py == 0 && pw == canvas_w && ph == canvas_h)
+        // frames are stored with the canvas size unless memory is optimized
+        if (frames[prev].rgb->data_w() == canvas_w && frames[prev].rgb->data_h() == canvas_h)
           memcpy((char *)dst, (char *)src, canvas_w * canvas_h * 4);
         else {
           if ( px + pw > canvas_w ) pw = canvas_w - px;
           if ( py + ph > canvas_h ) ph = canvas_h - py;
           for (int y = 0; y < ph; y++) {
-            memcpy(dst + ( y + py ) * canvas_w * 4 + px, src + y * frames[prev].w * 4, pw * 4);
+            memcpy(dst + ( ( y + py ) * canvas_w + px ) * 4, src + y * frames[prev].w * 4, pw * 4);
           }
         }
         break;
@@ -343,36 +344,37 @@ void Fl_Anim_GIF_Image::FrameInfo::on_frame_data(Fl_GIF_Image::GIF_FRAME &gf) {
   // we know now everything we need about the frame..
   dispose(frames_size - 1);
 
-  // copy image data to offscreen
-  const uchar *bits = gf.bptr;
-  const uchar *endp = offscreen + canvas_w * canvas_h * 4;
-  for (int y = frame.y; y < frame.y + frame.h; y++) {
-    for (int x = frame.x; x < frame.x + frame.w; x++) {
-      uchar c = *bits++;
-      if (c == gf.trans)
-        continue;
-      uchar *buf = offscreen;
-      buf += (y * canvas_w * 4 + (x * 4));
-      if (buf >= endp)
-        continue;
-      *buf++ = gf.cpal[c].r;
-      *buf++ = gf.cpal[c].g;
-      *buf++ = gf.cpal[c].b;
-      *buf = T_NONE;
+  // the part of the frame that is inside the canvas
+  int clip_w = frame.x < canvas_w ? canvas_w - frame.x : 0;
+  int clip_h = frame.y < canvas_h ? canvas_h - frame.y : 0;
+  if (clip_w > frame.w) clip_w = frame.w;
+  if (clip_h > frame.h) clip_h = frame.h;
+
+  // convert the color table to RGBA once, then copy image data to offscreen
+  RGBA_Color pal[256];
+  for (int i = 0; i < 256; i++)
+    pal[i] = RGBA_Color(gf.cpal[i].r, gf.cpal[i].g, gf.cpal[i].b);
+  for (int y = 0; y < clip_h; y++) {
+    const uchar *bits = gf.bptr + y * frame.w;
+    uchar *buf = offscreen + ((frame.y + y) * canvas_w + frame.x) * 4;
+    if (gf.trans < 0) {
+      for (int x = 0; x < clip_w; x++, buf += 4)
+        memcpy(buf, &pal[bits[x]], 4);
+    } else {
+      for (int x = 0; x < clip_w; x++, buf += 4)
+        if (bits[x] != gf.trans)
+          memcpy(buf, &pal[bits[x]], 4);
     }
   }
 
   // create RGB image from offscreen
   if (optimize_mem) {
     uchar *buf = new uchar[frame.w * frame.h * 4];
-    uchar *dest = buf;
-    for (int y = frame.y; y < frame.y + frame.h; y++) {
-      for (int x = frame.x; x < frame.x + frame.w; x++) {
-        if (offscreen + y * canvas_w * 4 + x * 4 < endp)
-          memcpy(dest, &offscreen[y * canvas_w * 4 + x * 4], 4);
-        dest += 4;
-      }
-    }
+    if (clip_w < frame.w || clip_h < frame.h)
+      memset(buf, 0, frame.w * frame.h * 4);
+    for (int y = 0; y < clip_h; y++)
+      memcpy(buf + y * frame.w * 4,
+             offscreen + ((frame.y + y) * canvas_w + frame.x) * 4, clip_w * 4);
     frame.rgb = new Fl_RGB_Image(buf, frame.w, frame.h, 4);
   }
   else {
@@ -737,17 +739,8 @@ void Fl_Anim_GIF_Image::color_average(Fl_Color c, float i) /* override */ {
  */
 Fl_Image *Fl_Anim_GIF_Image::copy(int W, int H) const /* override */ {
   Fl_Anim_GIF_Image *copied = new Fl_Anim_GIF_Image();
-  // copy/resize the base image (Fl_Pixmap)
-  // Note: this is not really necessary, if the draw()
-  //       method never calls the base class.
-  if (fi_->frames_size) {
-    Fl_Pixmap *gif = (Fl_Pixmap *)Fl_GIF_Image::copy(W, H);
-    copied->Fl_GIF_Image::data(gif->data(), gif->count());
-    copied->alloc_data = gif->alloc_data;
-    gif->alloc_data = 0;
-    delete gif;
-  }
-
+  // Note: the base image (Fl_Pixmap) holds no pixel data, all frames
+  //       are stored as RGB images, so there is nothing to copy here.
   if (name_) copied->name_ = fl_strdup(name_);
   copied->flags_ = flags_;
   copied->frame_ = frame_;
@@ -755,6 +748,7 @@ Fl_Image *Fl_Anim_GIF_Image::copy(int W, int H) const /* override */ {
 
   copied->w(W);
   copied->h(H);
+  copied->d(d());
   copied->fi_->canvas_w = W;
   copied->fi_->canvas_h = H;
   copied->fi_->copy(*fi_); // copy the meta data
@@ -833,10 +827,8 @@ void Fl_Anim_GIF_Image::draw(int x, int y, int w, int h,
       this->image()->draw(x, y, w, h, cx, cy);
     }
   } else {
-    // Note: should the base class be called here?
-    //       If it is, then the copy() method must also
-    //       copy the base image!
-    Fl_GIF_Image::draw(x, y, w, h, cx, cy);
+    // Note: the base class (Fl_Pixmap) holds no pixel data, see load_gif_()
+    draw_empty(x, y);
   }
 }
 
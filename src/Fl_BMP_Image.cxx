@@ -152,6 +152,9 @@ void Fl_BMP_Image::load_bmp_(Fl_Image_Reader &rdr, int ico_height, int ico_width
   uchar bit,              // Bit in image
         byte;             // Byte in image
   uchar *ptr;             // Pointer into pixels
+  uchar *row = 0;         // Line buffer for 16, 24 and 32 bit images
+  const uchar *src;       // Pointer into line buffer
+  int   row_size = 0;     // Size of one line including padding
   uchar colormap[256][3]; // Colormap
   uchar havemask;         // Single bit mask follows image data
   int   use_5_6_5;        // Use 5:6:5 for R:G:B channels in 16 bit images
@@ -322,6 +325,13 @@ void Fl_BMP_Image::load_bmp_(Fl_Image_Reader &rdr, int ico_height, int ico_width
   array = new uchar[width * height * dstBDepth];
   alloc_array = 1;
 
+  // Uncompressed lines of 16 bits per pixel or more are read as a whole,
+  // including the padding to 32 bits
+  if (depth >= 16) {
+    row_size = ((width * depth / 8) + 3) & ~3;
+    row = new uchar[row_size];
+  }
+
   // Read the image data...
   color = 0;
   repcount = 0;
@@ -499,8 +509,9 @@ void Fl_BMP_Image::load_bmp_(Fl_Image_Reader &rdr, int ico_height, int ico_width
         break;
 
       case 16 : // 16-bit 5:5:5 or 5:6:5 RGB
-        for (x = width; x > 0; x --, ptr += dstBDepth) {
-          uchar b = rdr.read_byte(), a = rdr.read_byte() ;
+        rdr.read(row, row_size);
+        for (x = width, src = row; x > 0; x --, ptr += dstBDepth, src += 2) {
+          uchar b = src[0], a = src[1];
           if (use_5_6_5) {
             ptr[2] = (uchar)(( b << 3 ) & 0xf8);
             ptr[1] = (uchar)(((a << 5) & 0xe0) | ((b >> 3) & 0x1c));
@@ -511,46 +522,39 @@ void Fl_BMP_Image::load_bmp_(Fl_Image_Reader &rdr, int ico_height, int ico_width
             ptr[0] = (uchar)((a<<1) & 0xf8);
           }
         }
-
-        // Read remaining bytes to align to 32 bits...
-        for (temp = width * 2; temp & 3; temp ++) {
-          rdr.read_byte();
-        }
         break;
 
       case 24 : // 24-bit RGB
-        for (x = width; x > 0; x --, ptr += dstBDepth) {
-          ptr[2] = rdr.read_byte();
-          ptr[1] = rdr.read_byte();
-          ptr[0] = rdr.read_byte();
-        }
-
-        // Read remaining bytes to align to 32 bits...
-        for (temp = width * 3; temp & 3; temp ++) {
-          rdr.read_byte();
+        rdr.read(row, row_size);
+        for (x = width, src = row; x > 0; x --, ptr += dstBDepth, src += 3) {
+          ptr[2] = src[0];
+          ptr[1] = src[1];
+          ptr[0] = src[2];
         }
         break;
 
       case 32 : // 32-bit RGBA
+        rdr.read(row, row_size);
         if (dstBDepth == 3) { // BI_RGB
-          for (x = width; x > 0; x --, ptr += dstBDepth) {
-            ptr[2] = rdr.read_byte();
-            ptr[1] = rdr.read_byte();
-            ptr[0] = rdr.read_byte();
-            rdr.read_byte();
+          for (x = width, src = row; x > 0; x --, ptr += dstBDepth, src += 4) {
+            ptr[2] = src[0];
+            ptr[1] = src[1];
+            ptr[0] = src[2];
           }
         } else {
-          for (x = width; x > 0; x --, ptr += dstBDepth) {
-            ptr[2] = rdr.read_byte();
-            ptr[1] = rdr.read_byte();
-            ptr[0] = rdr.read_byte();
-            ptr[3] = rdr.read_byte();
+          for (x = width, src = row; x > 0; x --, ptr += dstBDepth, src += 4) {
+            ptr[2] = src[0];
+            ptr[1] = src[1];
+            ptr[0] = src[2];
+            ptr[3] = src[3];
           }
         }
         break;
     }
+    if (rdr.error()) delete[] row;
     CHECK_ERROR
   }
+  delete[] row;
 
   if (havemask) {
     for (y = height - 1; y >= 0; y --) {
@@ -20,24 +20,28 @@
 #include "flstring.h"
 #include <stdlib.h>
 #include <math.h>
+#include <vector>
 
 #include <FL/Fl_Hold_Browser.H>
 #include <FL/Fl_Multi_Browser.H>
 #include <FL/Fl_Select_Browser.H>
 
 
-// I modified this from the original Forms data to use a linked list
-// so that the number of items in the browser and size of those items
-// is unlimited. The only problem is that the old browser used an
-// index number to identify a line, and it is slow to convert from/to
-// a pointer. I use a cache of the last match to try to speed this up.
+// I modified this from the original Forms data so that the number of
+// items in the browser and size of those items is unlimited. The old
+// browser used an index number to identify a line, so lines are kept
+// in an array of blocks (see Fl_Browser_Index below) that converts
+// between line numbers, pointers and vertical positions quickly.
 
 // Also added the ability to "hide" a line. This sets its height to
 // zero, so the Fl_Browser_ cannot pick it.
 
-struct FL_BLINE {       // data is in a linked list of these
-  FL_BLINE* prev;
-  FL_BLINE* next;
+struct FL_BLINE_BLOCK;
+
+struct FL_BLINE {       // data is in an Fl_Browser_Index of these
+  FL_BLINE_BLOCK* block; // block containing this line
+  int pos;              // position of this line in block
+  int height;           // item_height() + linespacing(), 0 if hidden
   void* data;
   Fl_Image* icon;
   short length;         // allocated size of txt[] (excl. null terminator); current string may be shorter
@@ -45,6 +49,259 @@ struct FL_BLINE {       // data is in a linked list of these
   char txt[1];          // start of allocated array
 };
 
+#define FL_BLINE_BLOCK_SIZE 256
+
+struct FL_BLINE_BLOCK {
+  int index;            // position of this block in Fl_Browser_Index::blocks
+  int count;            // number of lines in this block
+  int height;           // sum of the heights of these lines
+  FL_BLINE* line[FL_BLINE_BLOCK_SIZE];
+};
+
+// The lines of an Fl_Browser are kept in a list of blocks of up to
+// FL_BLINE_BLOCK_SIZE lines. Each line knows its block and position in
+// it, and two Fenwick trees over the blocks hold the number of lines and
+// the height of all blocks before any block. Line numbers, lines and
+// vertical positions can thus be converted into each other in O(log n),
+// plus a scan of a single block. Blocks are split when full and merged
+// with a neighbor when they become mostly empty, which rebuilds the trees.
+
+struct Fl_Browser_Index {
+  std::vector<FL_BLINE_BLOCK*> blocks;
+  std::vector<int> count_tree;  // Fenwick tree of the block line counts
+  std::vector<int> height_tree; // Fenwick tree of the block heights
+  int height;                   // total height of all lines
+
+  Fl_Browser_Index() : height(0) { count_tree.push_back(0); height_tree.push_back(0); }
+  ~Fl_Browser_Index() { clear(); }
+
+  int nblocks() const { return (int)blocks.size(); }
+
+  static void tree_add(std::vector<int> &t, int b, int d) {
+    for (b++; b < (int)t.size(); b += b & -b) t[b] += d;
+  }
+  // sum over the blocks before block b:
+  static int tree_sum(const std::vector<int> &t, int b) {
+    int s = 0;
+    for (; b > 0; b -= b & -b) s += t[b];
+    return s;
+  }
+  // index of the block containing v, v is made relative to that block.
+  // Returns nblocks() if v is past the end:
+  static int tree_find(const std::vector<int> &t, int &v) {
+    int n = (int)t.size() - 1, b = 0, step = 1;
+    while (step * 2 <= n) step *= 2;
+    for (; step; step /= 2) {
+      if (b + step <= n && t[b + step] <= v) {
+        b += step;
+        v -= t[b];
+      }
+    }
+    return b;
+  }
+
+  void rebuild() {
+    int n = nblocks();
+    count_tree.assign(n + 1, 0);
+    height_tree.assign(n + 1, 0);
+    for (int b = 0; b < n; b++) {
+      blocks[b]->index = b;
+      count_tree[b + 1] = blocks[b]->count;
+      height_tree[b + 1] = blocks[b]->height;
+    }
+    for (int b = 1; b <= n; b++) {
+      int p = b + (b & -b);
+      if (p <= n) {
+        count_tree[p] += count_tree[b];
+        height_tree[p] += height_tree[b];
+      }
+    }
+  }
+
+  void clear() {
+    for (int b = 0; b < nblocks(); b++) delete blocks[b];
+    blocks.clear();
+    height = 0;
+    rebuild();
+  }
+
+  FL_BLINE *first() const { return blocks.empty() ? 0 : blocks.front()->line[0]; }
+  FL_BLINE *last() const {
+    if (blocks.empty()) return 0;
+    FL_BLINE_BLOCK *k = blocks.back();
+    return k->line[k->count - 1];
+  }
+  FL_BLINE *next(const FL_BLINE *l) const {
+    FL_BLINE_BLOCK *k = l->block;
+    if (l->pos + 1 < k->count) return k->line[l->pos + 1];
+    return k->index + 1 < nblocks() ? blocks[k->index + 1]->line[0] : 0;
+  }
+  FL_BLINE *prev(const FL_BLINE *l) const {
+    FL_BLINE_BLOCK *k = l->block;
+    if (l->pos > 0) return k->line[l->pos - 1];
+    if (k->index == 0) return 0;
+    k = blocks[k->index - 1];
+    return k->line[k->count - 1];
+  }
+
+  // line n, 0 based:
+  FL_BLINE *at(int n) const {
+    int b = tree_find(count_tree, n);
+    return b < nblocks() ? blocks[b]->line[n] : 0;
+  }
+  // line number of l, 0 based:
+  int index_of(const FL_BLINE *l) const {
+    return tree_sum(count_tree, l->block->index) + l->pos;
+  }
+  // vertical position of the top of l:
+  int position_of(const FL_BLINE *l) const {
+    FL_BLINE_BLOCK *k = l->block;
+    int y = tree_sum(height_tree, k->index);
+    for (int i = 0; i < l->pos; i++) y += k->line[i]->height;
+    return y;
+  }
+  // line containing vertical position y, or the last displayed line if y
+  // is past the end. ly is set to the top of the line:
+  FL_BLINE *at_position(int y, int &ly) const {
+    if (height <= 0) return 0;
+    if (y < 0) y = 0;
+    if (y >= height) { // find the last displayed line
+      int b = nblocks() - 1;
+      while (!blocks[b]->height) b--;
+      FL_BLINE_BLOCK *k = blocks[b];
+      int i = k->count - 1;
+      while (!k->line[i]->height) i--;
+      ly = height - k->line[i]->height;
+      return k->line[i];
+    }
+    int v = y;
+    FL_BLINE_BLOCK *k = blocks[tree_find(height_tree, v)];
+    int i = 0;
+    for (; v >= k->line[i]->height; i++) v -= k->line[i]->height;
+    ly = y - v;
+    return k->line[i];
+  }
+
+  void set_height(FL_BLINE *l, int h) {
+    int d = h - l->height;
+    if (!d) return;
+    l->height = h;
+    l->block->height += d;
+    height += d;
+    tree_add(height_tree, l->block->index, d);
+  }
+
+  // inserts l before line n (0 based), n may be the number of lines:
+  void insert(int n, FL_BLINE *l) {
+    if (blocks.empty()) {
+      blocks.push_back(new FL_BLINE_BLOCK);
+      blocks[0]->count = blocks[0]->height = 0;
+      rebuild();
+    }
+    int b, i = n;
+    if (n >= count_tree_total()) { // append
+      b = nblocks() - 1;
+      i = blocks[b]->count;
+    } else {
+      b = tree_find(count_tree, i);
+    }
+    FL_BLINE_BLOCK *k = blocks[b];
+    if (k->count == FL_BLINE_BLOCK_SIZE) {
+      FL_BLINE_BLOCK *k2 = new FL_BLINE_BLOCK;
+      // start a new block when appending, else split this one:
+      int keep = (i == k->count && b == nblocks() - 1) ? k->count : k->count / 2;
+      k2->count = k->count - keep;
+      k2->height = 0;
+      for (int j = 0; j < k2->count; j++) {
+        FL_BLINE *m = k2->line[j] = k->line[keep + j];
+        m->block = k2;
+        m->pos = j;
+        k2->height += m->height;
+      }
+      k->count = keep;
+      k->height -= k2->height;
+      blocks.insert(blocks.begin() + b + 1, k2);
+      rebuild();
+      if (i >= keep) {
+        k = k2;
+        i -= keep;
+      }
+    }
+    memmove(k->line + i + 1, k->line + i, (k->count - i) * sizeof(FL_BLINE*));
+    k->line[i] = l;
+    k->count++;
+    for (int j = i; j < k->count; j++) k->line[j]->pos = j;
+    l->block = k;
+    k->height += l->height;
+    height += l->height;
+    tree_add(count_tree, k->index, 1);
+    tree_add(height_tree, k->index, l->height);
+  }
+
+  void remove(FL_BLINE *l) {
+    FL_BLINE_BLOCK *k = l->block;
+    k->count--;
+    memmove(k->line + l->pos, k->line + l->pos + 1, (k->count - l->pos) * sizeof(FL_BLINE*));
+    for (int j = l->pos; j < k->count; j++) k->line[j]->pos = j;
+    k->height -= l->height;
+    height -= l->height;
+    tree_add(count_tree, k->index, -1);
+    tree_add(height_tree, k->index, -l->height);
+    if (k->count >= FL_BLINE_BLOCK_SIZE / 4) return;
+    // merge mostly empty blocks with the next or previous one:
+    int b = k->index;
+    if (b + 1 < nblocks() && k->count + blocks[b + 1]->count <= FL_BLINE_BLOCK_SIZE / 2) {
+      merge(b);
+    } else if (b > 0 && k->count + blocks[b - 1]->count <= FL_BLINE_BLOCK_SIZE / 2) {
+      merge(b - 1);
+    } else if (!k->count) {
+      blocks.erase(blocks.begin() + b);
+      delete k;
+      rebuild();
+    }
+  }
+
+  // moves the lines of block b+1 to the end of block b:
+  void merge(int b) {
+    FL_BLINE_BLOCK *k = blocks[b], *k2 = blocks[b + 1];
+    for (int j = 0; j < k2->count; j++) {
+      FL_BLINE *m = k->line[k->count] = k2->line[j];
+      m->block = k;
+      m->pos = k->count++;
+    }
+    k->height += k2->height;
+    blocks.erase(blocks.begin() + b + 1);
+    delete k2;
+    rebuild();
+  }
+
+  // puts n at the place of l:
+  void replace(FL_BLINE *l, FL_BLINE *n) {
+    n->block = l->block;
+    n->pos = l->pos;
+    n->height = l->height;
+    n->block->line[n->pos] = n;
+  }
+
+  void swap(FL_BLINE *a, FL_BLINE *b) {
+    FL_BLINE_BLOCK *ka = a->block, *kb = b->block;
+    int pa = a->pos;
+    ka->line[pa] = b;
+    kb->line[b->pos] = a;
+    a->block = kb; a->pos = b->pos;
+    b->block = ka; b->pos = pa;
+    int d = b->height - a->height;
+    if (ka != kb && d) {
+      ka->height += d;
+      kb->height -= d;
+      tree_add(height_tree, ka->index, d);
+      tree_add(height_tree, kb->index, -d);
+    }
+  }
+
+  int count_tree_total() const { return tree_sum(count_tree, nblocks()); }
+};
+
 /** Get writable reference to FL_BLINE data. */
 void*& Fl_Browser::bline_data(FL_BLINE* b) const {
   return b->data;
@@ -103,7 +360,7 @@ short Fl_Browser::bline_length(const FL_BLINE* b) const {
   \returns The first item, or NULL if list is empty.
   \see item_first(), item_last(), item_next(), item_prev()
 */
-void* Fl_Browser::item_first() const {return first;}
+void* Fl_Browser::item_first() const {return index_->first();}
 
 /**
   Returns the next item after \p item.
@@ -111,7 +368,7 @@ void* Fl_Browser::item_first() const {return first;}
   \returns The next item after \p item, or NULL if there are none after this one.
   \see item_first(), item_last(), item_next(), item_prev()
 */
-void* Fl_Browser::item_next(void* item) const {return ((FL_BLINE*)item)->next;}
+void* Fl_Browser::item_next(void* item) const {return index_->next((FL_BLINE*)item);}
 
 /**
   Returns the previous item before \p item.
@@ -119,7 +376,7 @@ void* Fl_Browser::item_next(void* item) const {return ((FL_BLINE*)item)->next;}
   \returns The previous item before \p item, or NULL if there are none before this one.
   \see item_first(), item_last(), item_next(), item_prev()
 */
-void* Fl_Browser::item_prev(void* item) const {return ((FL_BLINE*)item)->prev;}
+void* Fl_Browser::item_prev(void* item) const {return index_->prev((FL_BLINE*)item);}
 
 /**
   Returns the very last item in the list.
@@ -133,7 +390,7 @@ void* Fl_Browser::item_prev(void* item) const {return ((FL_BLINE*)item)->prev;}
   \returns The last item, or NULL if list is empty.
   \see item_first(), item_last(), item_next(), item_prev()
 */
-void* Fl_Browser::item_last() const {return last;}
+void* Fl_Browser::item_last() const {return index_->last();}
 
 /**
   See if \p item is selected.
@@ -167,13 +424,8 @@ const char *Fl_Browser::item_text(void *item) const {
 /**
   Returns the item for specified \p line.
 
-  Note: This call is slow. It's fine for e.g. responding to user
-  clicks, but slow if called often, such as in a tight sorting loop.
-  Finding an item 'by line' involves a linear lookup on the internal
-  linked list. The performance hit can be significant if the browser's
-  contents is large, and the method is called often (e.g. during a sort).
-  If you're writing a subclass, use the protected methods item_first(),
-  item_next(), etc. to access the internal linked list more efficiently.
+  This takes logarithmic time in the number of lines. When walking
+  through all items, item_first() and item_next() are still faster.
 
   \param[in] line The line number of the item to return. (1 based)
   \retval item that was found.
@@ -181,25 +433,13 @@ const char *Fl_Browser::item_text(void *item) const {
   \see item_at(), find_line(), lineno()
 */
 FL_BLINE* Fl_Browser::find_line(int line) const {
-  int n; FL_BLINE* l;
-  if (line == cacheline) return cache;
-  if (cacheline && line > (cacheline/2) && line < ((cacheline+lines)/2)) {
-    n = cacheline; l = cache;
-  } else if (line <= (lines/2)) {
-    n = 1; l = first;
-  } else {
-    n = lines; l = last;
-  }
-  for (; n < line && l; n++) l = l->next;
-  for (; n > line && l; n--) l = l->prev;
-  ((Fl_Browser*)this)->cacheline = line;
-  ((Fl_Browser*)this)->cache = l;
-  return l;
+  if (line < 1 || line > lines) return 0;
+  return index_->at(line-1);
 }
 
 /**
   Returns line number corresponding to \p item, or zero if not found.
-  Caveat: See efficiency note in find_line().
+  This takes logarithmic time in the number of lines.
   \param[in] item The item to be found
   \returns The line number of the item, or 0 if not found.
   \see item_at(), find_line(), lineno()
@@ -207,33 +447,44 @@ FL_BLINE* Fl_Browser::find_line(int line) const {
 int Fl_Browser::lineno(void *item) const {
   FL_BLINE* l = (FL_BLINE*)item;
   if (!l) return 0;
-  if (l == cache) return cacheline;
-  if (l == first) return 1;
-  if (l == last) return lines;
-  if (!cache) {
-    ((Fl_Browser*)this)->cache = first;
-    ((Fl_Browser*)this)->cacheline = 1;
-  }
-  // assume it is near cache, search both directions:
-  FL_BLINE* b = cache->prev;
-  int bnum = cacheline-1;
-  FL_BLINE* f = cache->next;
-  int fnum = cacheline+1;
-  int n = 0;
-  for (;;) {
-    if (b == l) {n = bnum; break;}
-    if (f == l) {n = fnum; break;}
-    if (b) {b = b->prev; bnum--;}
-    if (f) {f = f->next; fnum++;}
-  }
-  ((Fl_Browser*)this)->cache = l;
-  ((Fl_Browser*)this)->cacheline = n;
-  return n;
+  return index_->index_of(l) + 1;
+}
+
+/**
+  Returns the item at vertical position \p ypos of the list and the
+  position of its top in \p item_y, using the heights kept in the index.
+  \see Fl_Browser_::item_at_position()
+*/
+void *Fl_Browser::item_at_position(int ypos, int &item_y) const {
+  return index_->at_position(ypos, item_y);
+}
+
+/**
+  Returns the vertical position of the top of \p item in the list.
+  \see Fl_Browser_::item_position()
+*/
+int Fl_Browser::item_position(void *item) const {
+  return index_->position_of((FL_BLINE*)item);
+}
+
+// Stores the current height of line b in the index:
+void Fl_Browser::update_height(FL_BLINE *b) {
+  index_->set_height(b, (b->flags & BLINE_NOTDISPLAYED) ? 0 : item_height(b) + linespacing());
+}
+
+/**
+  Recalculates the cached heights of all lines.
+  Subclasses must call this when something other than the line contents
+  changes the value returned by item_height(), for instance an icon size.
+  You must call redraw() to make any changes visible.
+*/
+void Fl_Browser::update_heights() {
+  for (FL_BLINE* itm = index_->first(); itm; itm = index_->next(itm))
+    update_height(itm);
 }
 
 /**
   Removes the item at the specified \p line.
-  Caveat: See efficiency note in find_line().
   You must call redraw() to make any changes visible.
   \param[in] line The line number to be removed. (1 based) Must be in range!
   \returns Pointer to browser item that was removed (and is no longer valid).
@@ -242,16 +493,8 @@ int Fl_Browser::lineno(void *item) const {
 FL_BLINE* Fl_Browser::_remove(int line) {
   FL_BLINE* ttt = find_line(line);
   deleting(ttt);
-
-  cacheline = line-1;
-  cache = ttt->prev;
   lines--;
-  full_height_ -= item_height(ttt) + linespacing();
-  if (ttt->prev) ttt->prev->next = ttt->next;
-  else first = ttt->next;
-  if (ttt->next) ttt->next->prev = ttt->prev;
-  else last = ttt->prev;
-
+  index_->remove(ttt);
   return(ttt);
 }
 
@@ -271,38 +514,21 @@ void Fl_Browser::remove(int line) {
   Insert specified \p item above \p line.
   If \p line > size() then the line is added to the end.
 
-  Caveat: See efficiency note in find_line().
 
   \param[in] line  The new line will be inserted above this line (1 based).
   \param[in] item  The item to be added.
 */
 void Fl_Browser::insert(int line, FL_BLINE* item) {
-  if (!first) {
-    item->prev = item->next = 0;
-    first = last = item;
-  } else if (line <= 1) {
-    inserting(first, item);
-    item->prev = 0;
-    item->next = first;
-    item->next->prev = item;
-    first = item;
-  } else if (line > lines) {
-    item->prev = last;
-    item->prev->next = item;
-    item->next = 0;
-    last = item;
+  if (line > lines || !lines) {
+    line = lines+1;
   } else {
-    FL_BLINE* n = find_line(line);
-    inserting(n, item);
-    item->next = n;
-    item->prev = n->prev;
-    item->prev->next = item;
-    n->prev = item;
-  }
-  cacheline = line;
-  cache = item;
+    if (line < 1) line = 1;
+    inserting(find_line(line), item);
+  }
+  item->height = 0;
+  index_->insert(line-1, item);
   lines++;
-  full_height_ += item_height(item) + linespacing();
+  update_height(item);
   redraw_line(item);
 }
 
@@ -361,20 +587,19 @@ void Fl_Browser::text(int line, const char* newtext) {
   if (l > t->length) {
     FL_BLINE* n = (FL_BLINE*)malloc(sizeof(FL_BLINE)+l);
     replacing(t, n);
-    cache = n;
     n->data = t->data;
     n->icon = t->icon;
     n->length = (short)l;
     n->flags = t->flags;
-    n->prev = t->prev;
-    if (n->prev) n->prev->next = n; else first = n;
-    n->next = t->next;
-    if (n->next) n->next->prev = n; else last = n;
+    index_->replace(t, n);
     free(t);
     t = n;
   }
   strcpy(t->txt, newtext);
-  redraw_line(t);
+  int h = t->height;
+  update_height(t);
+  if (t->height != h) redraw(); // lines below have moved
+  else redraw_line(t);
 }
 
 /**
@@ -516,7 +741,7 @@ int Fl_Browser::item_width(void *item) const {
        incr_height(), full_height()
 */
 int Fl_Browser::full_height() const {
-  return full_height_;
+  return index_->height;
 }
 
 /**
@@ -638,11 +863,17 @@ Fl_Browser::Fl_Browser(int X, int Y, int W, int H, const char *L)
 : Fl_Browser_(X, Y, W, H, L) {
   column_widths_ = no_columns;
   lines = 0;
-  full_height_ = 0;
-  cacheline = 0;
+  index_ = new Fl_Browser_Index;
   format_char_ = '@';
   column_char_ = '\t';
-  first = last = cache = 0;
+}
+
+/**
+  The destructor deletes all list items and destroys the browser.
+*/
+Fl_Browser::~Fl_Browser() {
+  clear();
+  delete index_;
 }
 
 /**
@@ -654,13 +885,9 @@ Fl_Browser::Fl_Browser(int X, int Y, int W, int H, const char *L)
 void Fl_Browser::lineposition(int line, Fl_Line_Position pos) {
   if (line<1) line = 1;
   if (line>lines) line = lines;
-  int p = 0;
-
-  FL_BLINE* l;
-  for (l=first; l && line>1; l = l->next) {
-    line--; p += item_height(l) + linespacing();
-  }
-  if (l && (pos == BOTTOM)) p += item_height(l) + linespacing();
+  FL_BLINE* l = find_line(line);
+  int p = l ? index_->position_of(l) : 0;
+  if (l && (pos == BOTTOM)) p += l->height;
 
   int final = p, X, Y, W, H;
   bbox(X, Y, W, H);
@@ -705,11 +932,31 @@ void Fl_Browser::textsize(Fl_Fontsize newSize) {
     return; // avoid recalculation
   Fl_Browser_::textsize(newSize);
   new_list();
-  full_height_ = 0;
-  if (lines == 0) return;
-  for (FL_BLINE* itm=(FL_BLINE *)item_first(); itm; itm=(FL_BLINE *)item_next(itm)) {
-    full_height_ += item_height(itm) + linespacing();
-  }
+  update_heights();
+}
+
+/**
+  Sets the default text font for the lines in the browser to \p font.
+
+  Like textsize(), this recalculates all item heights.
+*/
+void Fl_Browser::textfont(Fl_Font font) {
+  if (font == textfont())
+    return;
+  Fl_Browser_::textfont(font);
+  update_heights();
+}
+
+/**
+  Adds \p pixels of additional space between browser lines.
+
+  Like textsize(), this recalculates all item heights.
+*/
+void Fl_Browser::linespacing(int pixels) {
+  if (pixels == linespacing())
+    return;
+  Fl_Browser_::linespacing(pixels);
+  update_heights();
 }
 
 /**
@@ -717,14 +964,12 @@ void Fl_Browser::textsize(Fl_Fontsize newSize) {
   \see add(), insert(), remove(), swap(int,int), clear()
 */
 void Fl_Browser::clear() {
-  for (FL_BLINE* l = first; l;) {
-    FL_BLINE* n = l->next;
+  for (FL_BLINE* l = index_->first(); l;) {
+    FL_BLINE* n = index_->next(l);
     free(l);
     l = n;
   }
-  full_height_ = 0;
-  first = 0;
-  last = 0;
+  index_->clear();
   lines = 0;
   new_list();
 }
@@ -807,7 +1052,7 @@ void Fl_Browser::show(int line) {
   FL_BLINE* t = find_line(line);
   if (t->flags & BLINE_NOTDISPLAYED) {
     t->flags &= ~BLINE_NOTDISPLAYED;
-    full_height_ += item_height(t) + linespacing();
+    update_height(t);
     if (Fl_Browser_::displayed(t)) redraw();
   }
 }
@@ -824,8 +1069,8 @@ void Fl_Browser::show(int line) {
 void Fl_Browser::hide(int line) {
   FL_BLINE* t = find_line(line);
   if (!(t->flags & BLINE_NOTDISPLAYED)) {
-    full_height_ -= item_height(t) + linespacing();
     t->flags |= BLINE_NOTDISPLAYED;
+    update_height(t);
     if (Fl_Browser_::displayed(t)) redraw();
   }
 }
@@ -868,42 +1113,9 @@ int Fl_Browser::value() const {
   \see swap(int,int), item_swap()
 */
 void Fl_Browser::swap(FL_BLINE *a, FL_BLINE *b) {
-
   if ( a == b || !a || !b) return;          // nothing to do
   swapping(a, b);
-  FL_BLINE *aprev  = a->prev;
-  FL_BLINE *anext  = a->next;
-  FL_BLINE *bprev  = b->prev;
-  FL_BLINE *bnext  = b->next;
-  if ( b->prev == a ) {                 // A ADJACENT TO B
-     if ( aprev ) aprev->next = b; else first = b;
-     b->next = a;
-     a->next = bnext;
-     b->prev = aprev;
-     a->prev = b;
-     if ( bnext ) bnext->prev = a; else last = a;
-  } else if ( a->prev == b ) {          // B ADJACENT TO A
-     if ( bprev ) bprev->next = a; else first = a;
-     a->next = b;
-     b->next = anext;
-     a->prev = bprev;
-     b->prev = a;
-     if ( anext ) anext->prev = b; else last = b;
-  } else {                              // A AND B NOT ADJACENT
-     // handle prev's
-     b->prev = aprev;
-     if ( anext ) anext->prev = b; else last = b;
-     a->prev = bprev;
-     if ( bnext ) bnext->prev = a; else last = a;
-     // handle next's
-     if ( aprev ) aprev->next = b; else first = b;
-     b->next = anext;
-     if ( bprev ) bprev->next = a; else first = a;
-     a->next = bnext;
-  }
-  // Disable cache -- we played around with positions
-  cacheline = 0;
-  cache = 0;
+  index_->swap(a, b);
 }
 
 /**
@@ -933,17 +1145,10 @@ void Fl_Browser::icon(int line, Fl_Image* icon) {
 
   FL_BLINE* bl = find_line(line);
 
-  int old_h = bl->icon ? bl->icon->h()+2 : 0;   // init with *old* icon height
-  bl->icon = 0;                                 // remove icon, if any
-  int th = item_height(bl);                     // height of text only
-  int new_h = icon ? icon->h()+2 : 0;           // init with *new* icon height
-  if (th > old_h) old_h = th;
-  if (th > new_h) new_h = th;
-  int dh = new_h - old_h;
-  full_height_ += dh;                           // do this *always*
-
+  int old_h = bl->height;                       // height with *old* icon
   bl->icon = icon;                              // set new icon
-  if (dh>0) {
+  update_height(bl);
+  if (bl->height > old_h) {
     redraw();                                   // icon larger than item? must redraw widget
   } else {
     redraw_line(bl);                            // icon same or smaller? can redraw just this line
@@ -23,6 +23,9 @@
 #include <FL/fl_draw.H>
 #include <FL/fl_utf8.h>
 
+#include <algorithm>
+#include <vector>
+
 
 // This is the base class for browsers.  To be useful it must be
 // subclassed and several virtual functions defined.  The
@@ -128,6 +131,17 @@ void Fl_Browser_::redraw_line(void* item) {
   else damage(FL_DAMAGE_SCROLL);
 }
 
+// Height of an item including linespacing(), 0 for hidden items:
+int Fl_Browser_::line_height(void *item) const {
+  int hh = item_height(item);
+  return hh > 0 ? hh + linespacing() : 0;
+}
+
+int Fl_Browser_::line_quick_height(void *item) const {
+  int hh = item_quick_height(item);
+  return hh > 0 ? hh + linespacing() : 0;
+}
+
 // Figure out top() based on position():
 void Fl_Browser_::update_top() {
   if (!top_) top_ = item_first();
@@ -135,6 +149,17 @@ void Fl_Browser_::update_top() {
     void* l;
     int ly;
     int yy = position_;
+    // ask the subclass first, it may be able to find the item directly:
+    l = item_at_position(yy, ly);
+    if (l) {
+      int hh = line_height(l);
+      if (yy >= ly+hh) yy = ly+hh-1; // past the end
+      top_ = l;
+      offset_ = yy-ly;
+      real_position_ = yy;
+      damage(FL_DAMAGE_SCROLL);
+      return;
+    }
     // start from either head or current position, whichever is closer:
     if (!top_ || yy <= (real_position_/2)) {
       l = item_first();
@@ -148,13 +173,13 @@ void Fl_Browser_::update_top() {
       offset_ = 0;
       real_position_ = 0;
     } else {
-      int hh = item_quick_height(l) + linespacing();
+      int hh = line_quick_height(l);
       // step through list until we find line containing this point:
       while (ly > yy) {
         void* l1 = item_prev(l);
         if (!l1) {ly = 0; break;} // hit the top
         l  = l1;
-        hh = item_quick_height(l) + linespacing();
+        hh = line_quick_height(l);
         ly -= hh;
       }
       while ((ly+hh) <= yy) {
@@ -162,16 +187,16 @@ void Fl_Browser_::update_top() {
         if (!l1) {yy = ly+hh-1; break;}
         l = l1;
         ly += hh;
-        hh = item_quick_height(l) + linespacing();
+        hh = line_quick_height(l);
       }
       // top item must *really* be visible, use slow height:
       for (;;) {
-        hh = item_height(l) + linespacing();
+        hh = line_height(l);
         if ((ly+hh) > yy) break; // it is big enough to see
         // go up to top of previous item:
         void* l1 = item_prev(l);
         if (!l1) {ly = yy = 0; break;} // hit the top
-        l = l1; yy = position_ = ly = ly-item_quick_height(l) + linespacing();
+        l = l1; yy = position_ = ly = ly-line_quick_height(l);
       }
       // use it:
       top_ = l;
@@ -229,7 +254,7 @@ int Fl_Browser_::displayed(void* item) const {
   int yy = H+offset_;
   for (void* l = top_; l && yy > 0; l = item_next(l)) {
     if (l == item) return 1;
-    yy -= item_height(l) + linespacing();
+    yy -= line_height(l);
   }
   return 0;
 }
@@ -257,7 +282,26 @@ void Fl_Browser_::display(void* item) {
 
   // 3rd special case - want to display item just above top of browser?
   void* lp = item_prev(l);
-  if (lp == item) { vposition(real_position_+Y-item_quick_height(lp)-linespacing()); return; }
+  if (lp == item) { vposition(real_position_+Y-line_quick_height(lp)); return; }
+
+  // no need to search if the subclass knows where the item is:
+  int ypos = item_position(item);
+  if (ypos >= 0) {
+    h1 = line_quick_height(item);
+    Y = ypos-real_position_;
+    if (ypos >= real_position_-offset_) { // below top
+      if (Y <= H) { // it is visible or right at bottom
+        Y = Y+h1-H; // find where bottom edge is
+        if (Y > 0) vposition(real_position_+Y); // scroll down a bit
+      } else {
+        vposition(real_position_+Y-(H-h1)/2); // center it
+      }
+    } else { // above top
+      if ((Y + h1) >= 0) vposition(real_position_+Y);
+      else vposition(real_position_+Y-(H-h1)/2);
+    }
+    return;
+  }
 
 #ifdef DISPLAY_SEARCH_BOTH_WAYS_AT_ONCE
   // search for item.  We search both up and down the list at the same time,
@@ -265,7 +309,7 @@ void Fl_Browser_::display(void* item) {
   // much slower for going up than for going down.
   while (l || lp) {
     if (l) {
-      h1 = item_quick_height(l) + linespacing();
+      h1 = line_quick_height(l);
       if (l == item) {
         if (Y <= H) { // it is visible or right at bottom
           Y = Y+h1-H; // find where bottom edge is
@@ -279,7 +323,7 @@ void Fl_Browser_::display(void* item) {
       l = item_next(l);
     }
     if (lp) {
-      h1 = item_quick_height(lp) + linespacing();
+      h1 = line_quick_height(lp);
       Yp -= h1;
       if (lp == item) {
         if ((Yp + h1) >= 0) vposition(real_position_+Yp);
@@ -294,7 +338,7 @@ void Fl_Browser_::display(void* item) {
   // search forward for it:
   l = top_;
   for (; l; l = item_next(l)) {
-    h1 = item_quick_height(l) + linespacing();
+    h1 = line_quick_height(l);
     if (l == item) {
       if (Y <= H) { // it is visible or right at bottom
         Y = Y+h1-H; // find where bottom edge is
@@ -310,7 +354,7 @@ void Fl_Browser_::display(void* item) {
   l = lp;
   Y = -offset_;
   for (; l; l = item_prev(l)) {
-    h1 = item_quick_height(l) + linespacing();
+    h1 = line_quick_height(l);
     Y -= h1;
     if (l == item) {
       if ((Y + h1) >= 0) position(real_position_+Y);
@@ -395,7 +439,7 @@ J1:
   void* l = top();
   int yy = -offset_;
   for (; l && yy < H; l = item_next(l)) {
-    int hh = item_height(l) + linespacing();
+    int hh = line_height(l);
     if (hh <= 0) continue;
     if ((damage()&(FL_DAMAGE_SCROLL|FL_DAMAGE_ALL)) || l == redraw1 || l == redraw2) {
       if (item_selected(l)) {
@@ -448,7 +492,7 @@ J1:
 
   // update the scrollbars and redraw them:
   int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
-  int dy = top_ ? item_quick_height(top_) + linespacing() : 0; if (dy < 10) dy = 10;
+  int dy = top_ ? line_quick_height(top_) : 0; if (dy < 10) dy = 10;
   if (scrollbar.visible()) {
     scrollbar.damage_resize(
         scrollbar.align()&FL_ALIGN_LEFT ? X-scrollsize : X+W,
@@ -584,8 +628,8 @@ void* Fl_Browser_::find_item(int ypos) {
   int X, Y, W, H; bbox(X, Y, W, H);
   int yy = Y-offset_;
   for (void *l = top_; l; l = item_next(l)) {
-    int hh = item_height(l); if (hh <= 0) continue;
-    yy += hh + linespacing();
+    int hh = line_height(l); if (hh <= 0) continue;
+    yy += hh;
     if (ypos <= yy || yy>=(Y+H)) return l;
   }
   return 0;
@@ -1015,6 +1059,7 @@ Fl_Browser_::Fl_Browser_(int X, int Y, int W, int H, const char* L)
 /**
   Sort the items in the browser based on \p flags.
   item_swap(void*, void*) and item_text(void*) must be implemented for this call.
+  item_swap() must be able to swap any two items, not only neighbors.
   \param[in] flags FL_SORT_ASCENDING -- sort in ascending order\n
                    FL_SORT_DESCENDING -- sort in descending order\n
                   FL_SORT_CASEINSENSITIVE -- add this to sort case-insensitively\n
@@ -1022,43 +1067,31 @@ Fl_Browser_::Fl_Browser_(int X, int Y, int W, int H, const char* L)
                    Other flags may appear in the future.
 */
 void Fl_Browser_::sort(int flags) {
-  //
-  // Simple bubble sort - pure lazyness on my side.
-  //
-  int i, j, n = -1, desc = ((flags&FL_SORT_DESCENDING)==FL_SORT_DESCENDING);
+  bool desc = ((flags&FL_SORT_DESCENDING)==FL_SORT_DESCENDING);
   bool caseinsensitive = (flags&FL_SORT_CASEINSENSITIVE);
-  void *a =item_first(), *b, *c;
-  if (!a) return;
-  while (a) {
-    a = item_next(a);
-    n++;
-  }
-  for (i=n; i>0; i--) {
-    char swapped = 0;
-    a = item_first();
-    b = item_next(a);
-    for (j=0; j<i; j++) {
-      const char *ta = item_text(a);
-      const char *tb = item_text(b);
-      c = item_next(b);
-      if (desc) {
-        if ( (caseinsensitive && fl_utf_strcasecmp(ta, tb) < 0) ||
-            (!caseinsensitive && strcmp(ta, tb) < 0) ) {
-          item_swap(a, b);
-          swapped = 1;
-        }
-      } else {
-        if ( (caseinsensitive && fl_utf_strcasecmp(ta, tb) > 0) ||
-            (!caseinsensitive && strcmp(ta, tb) > 0) ) {
-          item_swap(a, b);
-          swapped = 1;
-        }
-      }
-      if (!c) break;
-      b = c; a = item_prev(b);
-    }
-    if (!swapped)
-      break;
+  std::vector<void*> items;
+  for (void *a = item_first(); a; a = item_next(a))
+    items.push_back(a);
+  int n = (int)items.size();
+  if (n < 2) return;
+  // stable sort of the item numbers, equal items keep their order
+  std::vector<int> order(n);
+  for (int i = 0; i < n; i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](int ia, int ib) {
+    const char *ta = item_text(items[ia]);
+    const char *tb = item_text(items[ib]);
+    int c = caseinsensitive ? fl_utf_strcasecmp(ta, tb) : strcmp(ta, tb);
+    return desc ? c > 0 : c < 0;
+  });
+  // move the items into place with at most n-1 swaps
+  std::vector<int> at(n), where(n);   // item number at position, position of item number
+  for (int i = 0; i < n; i++) at[i] = where[i] = i;
+  for (int i = 0; i < n; i++) {
+    int k = order[i], p = where[k];
+    if (p == i) continue;
+    item_swap(items[at[i]], items[k]);
+    where[at[i]] = p; at[p] = at[i];
+    where[k] = i; at[i] = k;
   }
 }
 
@@ -1098,7 +1131,7 @@ int Fl_Browser_::incr_height() const {
 int Fl_Browser_::full_height() const {
   int t = 0;
   for (void* p = item_first(); p; p = item_next(p))
-    t += item_quick_height(p);
+    t += line_quick_height(p);
   return t;
 }
 
@@ -40,26 +40,6 @@
 #include <stdlib.h>
 #include "flstring.h"
 
-//
-// 'Fl_File_Browser::full_height()' - Return the height of the list.
-//
-
-int                                     // O - Height in pixels
-Fl_File_Browser::full_height() const
-{
-  int   i,                              // Looping var
-        th;                             // Total height of list.
-
-
-  for (i = 0, th = 0; i < size(); i ++) {
-    // Note: find_line() is 1-based!
-    th += item_height(find_line(i+1)) + linespacing();
-  }
-
-  return (th);
-}
-
-
 //
 // 'Fl_File_Browser::item_height()' - Return the height of a list item.
 //
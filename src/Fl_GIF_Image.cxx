@@ -353,7 +353,12 @@ void Fl_GIF_Image::lzw_decode(Fl_Image_Reader &rdr, uchar *Image,
       }
     }
     *tp++ = FinChar = i;
-    do {
+    // Fast path: the whole string fits into the current line
+    if (tp - OutCode < eol - p) {
+      do {
+        *p++ = *--tp;
+      } while (tp > OutCode);
+    } else do {
       *p++ = *--tp;
       if (p >= eol) {
         if (!Interlace) YC++;
@@ -479,10 +484,9 @@ static char ** convert_to_xpm(uchar *Image, int Width, int Height, ColorMap &CMa
   image is decoded (as with Fl_GIF_Image), but all contained images are read.
   The new Fl_Anim_GIF_Image class is derived from Fl_GIF_Image and utilises this
   feature in order to avoid code duplication of the GIF decoding routines.
-  The first image is in this case (additionally) stored in the usual way as described
-  above (making the Fl_Anim_GIF_Image a normal Fl_GIF_Image too).
-  All subsequent images are only decoded (and not converted to XPM) and passed
-  to Fl_Anim_GIF_Image, which stores them on its own (in RGBA format).
+  In this case no image is converted to XPM. All images, including the first,
+  are only decoded and passed to Fl_Anim_GIF_Image, which stores them on its
+  own (in RGBA format). The Fl_Pixmap base class only holds the canvas size.
 */
 void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
 {
@@ -539,15 +543,14 @@ void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
   int YPos = 0;
   struct ColorMap CMap; /* color map */
   if (HasColormap) {
+    // the color table is kept for reading further images in the file
+    // (Fl_Anim_GIF_Image) because CMap is changed during processing.
+    // GIF_FRAME::CPAL has the same layout as the file data (r, g, b).
+    rdr.read(&GlobalColorTable[0].r, ColorMapSize * 3);
     for (int i=0; i < ColorMapSize; i++) {
-      CMap.Red[i] = rdr.read_byte();
-      CMap.Green[i] = rdr.read_byte();
-      CMap.Blue[i] = rdr.read_byte();
-      // store away for reading of further images in file (Fl_Anim_GIF_Image)
-      // because the values are changed during processing.
-      GlobalColorTable[i].r = CMap.Red[i];
-      GlobalColorTable[i].g = CMap.Green[i];
-      GlobalColorTable[i].b = CMap.Blue[i];
+      CMap.Red[i] = GlobalColorTable[i].r;
+      CMap.Green[i] = GlobalColorTable[i].g;
+      CMap.Blue[i] = GlobalColorTable[i].b;
     }
   }
   CHECK_ERROR
@@ -624,15 +627,13 @@ void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
         BitsPerPixel = (ch & 7) + 1;
         ColorMapSize = 2 << (ch & 7);
         memset(LocalColorTable, 0, sizeof(LocalColorTable));
+        // the color table is kept for reading further images in the file
+        // (Fl_Anim_GIF_Image) because CMap is changed during processing.
+        rdr.read(&LocalColorTable[0].r, ColorMapSize * 3);
         for (i=0; i < ColorMapSize; i++) {
-          CMap.Red[i] = rdr.read_byte();
-          CMap.Green[i] = rdr.read_byte();
-          CMap.Blue[i] = rdr.read_byte();
-          // store away for reading of further images in file (Fl_Anim_GIF_Image)
-          // because the values are changed during processing.
-          LocalColorTable[i].r = CMap.Red[i];
-          LocalColorTable[i].g = CMap.Green[i];
-          LocalColorTable[i].b = CMap.Blue[i];
+          CMap.Red[i] = LocalColorTable[i].r;
+          CMap.Green[i] = LocalColorTable[i].g;
+          CMap.Blue[i] = LocalColorTable[i].b;
         }
       }
       CHECK_ERROR
@@ -715,26 +716,13 @@ void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
 
       // We are done reading the image, now convert to xpm (first image only)
       if (!frame) {
-        if (anim && ( (Width != ScreenWidth) || (Height != ScreenHeight) )) {
-          // if we are reading this for Fl_Anim_GIF_Image, we must apply offsets
+        if (anim) {
+          // Fl_Anim_GIF_Image keeps its own RGBA frames, built from the color
+          // indexes passed to on_frame_data(), so there is no XPM data to
+          // build here. Just set the size of the canvas.
           w(ScreenWidth);
           h(ScreenHeight);
           d(1);
-          uchar *moved_image = new uchar[ScreenWidth*ScreenHeight];
-          memset(moved_image, has_transparent ? transparent_pixel : 0, ScreenWidth*ScreenHeight);
-          int xstart = XPos; if (xstart < 0) xstart = 0;
-          int ystart = YPos; if (ystart < 0) ystart = 0;
-          int xmax = XPos + Width;  if (xmax > ScreenWidth)  xmax = ScreenWidth;
-          int ymax = YPos + Height; if (ymax > ScreenHeight) ymax = ScreenHeight;
-          for (int y = ystart; y<ymax; y++) {
-            uchar *src = Image + (y-YPos) * Width + (xstart-XPos);
-            uchar *dst = moved_image + y*ScreenWidth + xstart;
-            memcpy(dst, src, xmax-xstart);
-          }
-          char **new_data = convert_to_xpm(moved_image, ScreenWidth, ScreenHeight, CMap, ColorMapSize, has_transparent ? transparent_pixel : -1);
-          data((const char **)new_data, Height + 2);
-          alloc_data = 1;
-          delete[] moved_image;
         } else {
           // Fl_GIF_Image does not apply offsets and just show the first frame at 0, 0
           w(Width);
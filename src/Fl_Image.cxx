@@ -25,6 +25,28 @@
 #include <stdlib.h>
 #include <cstdint>
 
+// Large images are scaled by several threads where FLTK supports threads
+#if defined(HAVE_PTHREAD) || defined(_MSC_VER)
+#  define FL_SCALE_THREADS 1
+#  include <thread>
+#  include <system_error>
+#  include <vector>
+#else
+#  define FL_SCALE_THREADS 0
+#endif
+
+// SSE2 is part of the x86-64 baseline, the scaling kernels use it when
+// the compiler targets it. The results are the same as without it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define FL_SCALE_SSE2 1
+#  include <emmintrin.h>
+#else
+#  define FL_SCALE_SSE2 1
+#endif
+
+// Minimum number of bytes scaled per thread
+#define FL_SCALE_THREAD_BYTES (1L << 20)
+
 //
 // Base image class...
 //
@@ -251,6 +273,9 @@ Fl_Image::measure(const Fl_Label *lo,           // I - Label
 
 /** Sets the RGB image scaling method used for copy(int, int).
     Applies to all RGB images, defaults to FL_RGB_SCALING_NEAREST.
+    FL_RGB_SCALING_AREA uses bilinear interpolation when an image is
+    scaled up in either direction.
+    Large images are scaled by several threads on systems that support them.
 */
 void Fl_Image::RGB_scaling(Fl_RGB_Scaling method) {
   RGB_scaling_ = method;
@@ -499,47 +524,105 @@ Fl_RGB_Image *Fl_RGB_Image::copy_optimize_(int W, int H) const {
   return new_image;
 }
 
+/*
+  Calls rows(y0, y1) for bands of lines that together cover lines 0 to H-1.
+  If the image is large, the bands are scaled in parallel by several threads.
+  'bytes' is the number of bytes read and written by the scaling.
+
+  If the system can't start another thread, the calling thread scales the
+  bands of the missing threads itself.
+*/
+template <class Rows>
+static void scale_rows_(int H, long bytes, const Rows &rows) {
+#if FL_SCALE_THREADS
+  long nthreads = (long)std::thread::hardware_concurrency();
+  if (nthreads > bytes / FL_SCALE_THREAD_BYTES) nthreads = bytes / FL_SCALE_THREAD_BYTES;
+  if (nthreads > H) nthreads = H;
+  if (nthreads > 8) nthreads = 8;
+  if (nthreads > 1) {
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads - 1);
+    long t = 1;
+    try {
+      for (; t < nthreads; t++)
+        threads.push_back(std::thread(rows, (int)(H * t / nthreads), (int)(H * (t+1) / nthreads)));
+    } catch (const std::system_error &) {
+      // out of threads: lines H*t/nthreads to H-1 are scaled below
+    }
+    try {
+      rows(0, (int)(H / nthreads));
+      if (t < nthreads) rows((int)(H * t / nthreads), H);
+    } catch (...) {
+      for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+      throw;
+    }
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+    return;
+  }
+#endif // FL_SCALE_THREADS
+  rows(0, H);
+}
+
+/*
+  Copies one pixel of D bytes. The image depth is a template parameter,
+  so the compiler can unroll and vectorize the scaling kernels below for
+  each depth instead of looping over d() for every pixel.
+*/
+template <int D>
+static inline void copy_pixel_(uchar *dst, const uchar *src) {
+  for (int c = 0; c < D; c++) dst[c] = src[c];
+}
+
+// Nearest neighbor kernel: copies W pixels using precomputed source offsets
+template <int D>
+static void nearest_row_(uchar *dst, const uchar *src, const int *x_off, int W) {
+  for (int x = 0; x < W; x++, dst += D)
+    copy_pixel_<D>(dst, src + x_off[x]);
+}
+
 /**
  Create a scaled up or down copy of this image using nearest neighbor.
  */
 Fl_RGB_Image *Fl_RGB_Image::copy_nearest_neighbor_(int W, int H) const {
-  uchar         *new_ptr;       // Pointer into new array
-  const uchar   *old_ptr;       // Pointer into old array
   int           dx, dy,         // Destination coordinates
                 line_d;         // stride from line to line
+  const int     D = d();        // Image depth
+  const int     row_d = W * D;  // Bytes per line in the new image
 
   // Allocate memory for the new image...
-  uchar  *new_array = new uchar [((long)W) * H * d()];
-  Fl_RGB_Image  *new_image = new Fl_RGB_Image(new_array, W, H, d());
+  uchar  *new_array = new uchar [((long)W) * H * D];
+  Fl_RGB_Image  *new_image = new Fl_RGB_Image(new_array, W, H, D);
   new_image->alloc_array = 1;
 
-  line_d = ld() ? ld() : data_w() * d();
+  line_d = ld() ? ld() : data_w() * D;
 
-  int         c,              // Channel number
-              sy,             // Source coordinate
+  int         sx, sy,         // Source coordinates
               xerr, yerr,     // X & Y errors
               xmod, ymod,     // X & Y moduli
               xstep, ystep;   // X & Y step increments
 
   // Figure out Bresenham step/modulus values...
   xmod   = data_w() % W;
-  xstep  = (data_w() / W) * d();
+  xstep  = data_w() / W;
   ymod   = data_h() % H;
   ystep  = data_h() / H;
 
-    // Scale the image using a nearest-neighbor algorithm...
-  for (dy = H, sy = 0, yerr = H, new_ptr = new_array; dy > 0; dy --) {
-    for (dx = W, xerr = W, old_ptr = array + ((long)sy) * line_d; dx > 0; dx --) {
-      for (c = 0; c < d(); c ++) {
-        *new_ptr++ = old_ptr[c];
-      }
-      old_ptr += xstep;
-      xerr    -= xmod;
-      if (xerr <= 0) {
-        xerr    += W;
-        old_ptr += d();
-      }
+  // The source columns are the same for all lines, compute them once...
+  int *x_off = new int[W];
+  for (dx = 0, sx = 0, xerr = W; dx < W; dx ++) {
+    x_off[dx] = sx * D;
+    sx   += xstep;
+    xerr -= xmod;
+    if (xerr <= 0) {
+      xerr += W;
+      sx ++;
     }
+  }
+
+  // ..and the source line of each line
+  int *y_src = new int[H];
+  for (dy = 0, sy = 0, yerr = H; dy < H; dy ++) {
+    y_src[dy] = sy;
     sy   += ystep;
     yerr -= ymod;
     if (yerr <= 0) {
@@ -547,9 +630,149 @@ Fl_RGB_Image *Fl_RGB_Image::copy_nearest_neighbor_(int W, int H) const {
       sy ++;
     }
   }
+
+  // Scale the image using a nearest-neighbor algorithm. When scaling up,
+  // lines that come from the same source line are copied from the previous one.
+  scale_rows_(H, (long)row_d * H, [&](int y0, int y1) {
+    uchar *new_ptr = new_array + (long)y0 * row_d;
+    for (int y = y0; y < y1; y++, new_ptr += row_d) {
+      if (y > y0 && y_src[y] == y_src[y-1]) {
+        memcpy(new_ptr, new_ptr - row_d, row_d);
+        continue;
+      }
+      const uchar *old_ptr = array + ((long)y_src[y]) * line_d;
+      switch (D) {
+        case 1: nearest_row_<1>(new_ptr, old_ptr, x_off, W); break;
+        case 2: nearest_row_<2>(new_ptr, old_ptr, x_off, W); break;
+        case 3: nearest_row_<3>(new_ptr, old_ptr, x_off, W); break;
+        case 4: nearest_row_<4>(new_ptr, old_ptr, x_off, W); break;
+      }
+    }
+  });
+
+  delete[] x_off;
+  delete[] y_src;
   return new_image;
 }
 
+// Vertical bilinear pass: blends two source lines into 8.8 fixed point values
+static void bilinear_blend_(uint16_t *dst, const uint8_t *row0, const uint8_t *row1,
+                            uint32_t n, uint32_t wy) {
+  const uint32_t wy0 = 256 - wy;
+  uint32_t i = 0;
+#if FL_SCALE_SSE2
+  // 16 bytes at a time, the sums fit into 16 bits
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i w0 = _mm_set1_epi16((short)wy0), w1 = _mm_set1_epi16((short)wy);
+  for (; i + 16 <= n; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(row0 + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(row1 + i));
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1));
+    _mm_storeu_si128((__m128i *)(dst + i), lo);
+    _mm_storeu_si128((__m128i *)(dst + i + 8), hi);
+  }
+#endif // FL_SCALE_SSE2
+  for (; i < n; ++i)
+    dst[i] = (uint16_t)(row0[i] * wy0 + row1[i] * wy);
+}
+
+#if FL_SCALE_SSE2
+
+// Interpolates 8 channel values: (p0 * w0 + p1 * w1 + 32768) >> 16, as bytes
+static inline __m128i bilinear_lerp8_(__m128i p0, __m128i p1, __m128i w0, __m128i w1) {
+  const __m128i round = _mm_set1_epi32(32768);
+  __m128i l0 = _mm_mullo_epi16(p0, w0), h0 = _mm_mulhi_epu16(p0, w0);
+  __m128i l1 = _mm_mullo_epi16(p1, w1), h1 = _mm_mulhi_epu16(p1, w1);
+  __m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(l0, h0),
+                                           _mm_unpacklo_epi16(l1, h1)), round);
+  __m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_unpackhi_epi16(l0, h0),
+                                           _mm_unpackhi_epi16(l1, h1)), round);
+  lo = _mm_srli_epi32(lo, 16);
+  hi = _mm_srli_epi32(hi, 16);
+  __m128i v = _mm_packs_epi32(lo, hi);
+  return _mm_packus_epi16(v, v);
+}
+
+// Loads 4 blended values, 8 bytes
+static inline __m128i bilinear_load4_(const uint16_t *p) {
+  return _mm_loadl_epi64((const __m128i *)p);
+}
+
+// Loads 2 blended values, 4 bytes
+static inline __m128i bilinear_load2_(const uint16_t *p) {
+  int v;
+  memcpy(&v, p, sizeof(v));
+  return _mm_cvtsi32_si128(v);
+}
+
+/*
+  Horizontal bilinear pass for 8 channel values at a time: 2 pixels of depth
+  4, 4 of depth 2, or 8 of depth 1. Returns the number of pixels done.
+  Depth 3 is left to the compiler, splitting and merging the odd pixel size
+  was slower than the plain loop.
+*/
+template <int D>
+static uint32_t bilinear_row_sse2_(uint8_t *dst, const uint16_t *src, const uint32_t *x0_off,
+                                   const uint32_t *x1_off, const uint32_t *wx1, uint32_t W) {
+  if (D == 3) return 0;
+  const uint32_t N = 8 / D;   // pixels per step
+  uint32_t x = 0;
+  for (; x + N <= W; x += N, dst += N * D) {
+    __m128i p0, p1, w0, w1;
+    const uint32_t *o0 = x0_off + x, *o1 = x1_off + x, *w = wx1 + x;
+    if (D == 4) {
+      p0 = _mm_unpacklo_epi64(bilinear_load4_(src + o0[0]), bilinear_load4_(src + o0[1]));
+      p1 = _mm_unpacklo_epi64(bilinear_load4_(src + o1[0]), bilinear_load4_(src + o1[1]));
+      w1 = _mm_set_epi16((short)w[1], (short)w[1], (short)w[1], (short)w[1],
+                         (short)w[0], (short)w[0], (short)w[0], (short)w[0]);
+    } else if (D == 2) {
+      p0 = _mm_unpacklo_epi64(
+             _mm_unpacklo_epi32(bilinear_load2_(src + o0[0]), bilinear_load2_(src + o0[1])),
+             _mm_unpacklo_epi32(bilinear_load2_(src + o0[2]), bilinear_load2_(src + o0[3])));
+      p1 = _mm_unpacklo_epi64(
+             _mm_unpacklo_epi32(bilinear_load2_(src + o1[0]), bilinear_load2_(src + o1[1])),
+             _mm_unpacklo_epi32(bilinear_load2_(src + o1[2]), bilinear_load2_(src + o1[3])));
+      w1 = _mm_set_epi16((short)w[3], (short)w[3], (short)w[2], (short)w[2],
+                         (short)w[1], (short)w[1], (short)w[0], (short)w[0]);
+    } else {
+      p0 = _mm_set_epi16((short)src[o0[7]], (short)src[o0[6]], (short)src[o0[5]], (short)src[o0[4]],
+                         (short)src[o0[3]], (short)src[o0[2]], (short)src[o0[1]], (short)src[o0[0]]);
+      p1 = _mm_set_epi16((short)src[o1[7]], (short)src[o1[6]], (short)src[o1[5]], (short)src[o1[4]],
+                         (short)src[o1[3]], (short)src[o1[2]], (short)src[o1[1]], (short)src[o1[0]]);
+      w1 = _mm_set_epi16((short)w[7], (short)w[6], (short)w[5], (short)w[4],
+                         (short)w[3], (short)w[2], (short)w[1], (short)w[0]);
+    }
+    w0 = _mm_sub_epi16(_mm_set1_epi16(256), w1);
+    __m128i v = bilinear_lerp8_(p0, p1, w0, w1);
+    _mm_storel_epi64((__m128i *)dst, v);
+  }
+  return x;
+}
+
+#endif // FL_SCALE_SSE2
+
+// Horizontal bilinear pass: interpolates W pixels from a blended line
+template <int D>
+static void bilinear_row_(uint8_t *dst, const uint16_t *src, const uint32_t *x0_off,
+                          const uint32_t *x1_off, const uint32_t *wx1, uint32_t W) {
+  uint32_t x = 0;
+#if FL_SCALE_SSE2
+  x = bilinear_row_sse2_<D>(dst, src, x0_off, x1_off, wx1, W);
+  dst += x * D;
+#endif
+  for (; x < W; ++x, dst += D) {
+    const uint16_t *p0 = src + x0_off[x];
+    const uint16_t *p1 = src + x1_off[x];
+    const uint32_t wx = wx1[x];
+    const uint32_t wx0 = 256 - wx;
+    for (int c = 0; c < D; ++c)
+      dst[c] = (uint8_t)((p0[c] * wx0 + p1[c] * wx + 32768) >> 16);
+  }
+}
+
 /**
   Create a scaled up or down copy of this image using bilinear interpolation.
 
@@ -561,8 +784,10 @@ Fl_RGB_Image *Fl_RGB_Image::copy_nearest_neighbor_(int W, int H) const {
 
   RGB or gray must not be premultiplied if alpha is used.
 
-  Yes, this function is relatively slow. It may be worth looking to host OS
-  support for scaling images.
+  The interpolation is done in two passes. Two source lines are blended
+  vertically first, then the new line is interpolated horizontally from
+  the blended values. The result is identical to interpolating every pixel
+  from its four neighbors, but the inner loops are simpler and faster.
 
   \param[in] W, H  Requested width and height of the new image
   \returns  A new image object with the requested size. The caller is responsible
@@ -638,31 +863,24 @@ Fl_RGB_Image *Fl_RGB_Image::copy_bilinear_(uint32_t W, uint32_t H) const {
     wy1[y] = w;
   }
 
-  for (uint32_t y = 0; y < H; ++y) {
-    const uint8_t *row0 = array + y0_off[y];
-    const uint8_t *row1 = array + y1_off[y];
-    uint8_t *dst = new_array + y * W * D;
-
-    const uint32_t wy = wy1[y];
-    const uint32_t wy0 = 256 - wy;
-
-    for (uint32_t x = 0; x < W; ++x) {
-      const uint8_t *p00 = row0 + x0_off[x];
-      const uint8_t *p10 = row0 + x1_off[x];
-      const uint8_t *p01 = row1 + x0_off[x];
-      const uint8_t *p11 = row1 + x1_off[x];
-
-      const uint32_t wx = wx1[x];
-      const uint32_t wx0 = 256 - wx;
-
-      for (uint32_t c = 0; c < D; ++c) {
-        const uint32_t top = p00[c] * wx0 + p10[c] * wx;
-        const uint32_t bot = p01[c] * wx0 + p11[c] * wx;
-        dst[c] = (uint8_t)((top * wy0 + bot * wy + 32768) >> 16);
+  scale_rows_((int)H, (long)W * H * D * 2, [&](int ys, int ye) {
+    // One source line blended vertically (8.8 fixed point)
+    uint16_t *blend = new uint16_t[SW * D];
+    for (uint32_t y = ys; y < (uint32_t)ye; ++y) {
+      // Lines with the same source lines and weight share the blended line
+      if (y == (uint32_t)ys || y0_off[y] != y0_off[y-1] || y1_off[y] != y1_off[y-1] || wy1[y] != wy1[y-1])
+        bilinear_blend_(blend, array + y0_off[y], array + y1_off[y], SW * D, wy1[y]);
+
+      uint8_t *dst = new_array + (long)y * W * D;
+      switch (D) {
+        case 1: bilinear_row_<1>(dst, blend, x0_off, x1_off, wx1, W); break;
+        case 2: bilinear_row_<2>(dst, blend, x0_off, x1_off, wx1, W); break;
+        case 3: bilinear_row_<3>(dst, blend, x0_off, x1_off, wx1, W); break;
+        case 4: bilinear_row_<4>(dst, blend, x0_off, x1_off, wx1, W); break;
       }
-      dst += D;
     }
-  }
+    delete[] blend;
+  });
 
   delete[] x0_off;
   delete[] x1_off;
@@ -674,6 +892,141 @@ Fl_RGB_Image *Fl_RGB_Image::copy_bilinear_(uint32_t W, uint32_t H) const {
   return new_image;
 }
 
+/*
+  Source span of one destination pixel for area averaging.
+
+  Every source pixel is N units wide and every destination pixel covers
+  S units, where S is the source size and N the destination size.
+  Pixels between first and last are fully covered, the first and last
+  pixel are covered by w_first and w_last units.
+*/
+struct Fl_Area_Span {
+  int first, last;
+  uint32_t w_first, w_last;
+};
+
+static void area_spans_(Fl_Area_Span *span, int S, int N) {
+  for (int i = 0; i < N; i++) {
+    long a = (long)i * S, b = a + S;
+    span[i].first = (int)(a / N);
+    span[i].last  = (int)((b - 1) / N);
+    if (span[i].first == span[i].last) {
+      span[i].w_first = S;
+      span[i].w_last  = 0;
+    } else {
+      span[i].w_first = (uint32_t)((long)(span[i].first + 1) * N - a);
+      span[i].w_last  = (uint32_t)(b - (long)span[i].last * N);
+    }
+  }
+}
+
+// Horizontal area pass: weighted sums of the source pixels of one line
+template <int D>
+static void area_row_(uint32_t *dst, const uint8_t *src, const Fl_Area_Span *span,
+                      int W, uint32_t N) {
+  for (int x = 0; x < W; x++, dst += D) {
+    const Fl_Area_Span &sp = span[x];
+    const uint8_t *p = src + sp.first * D;
+    uint32_t sum[D];
+    for (int c = 0; c < D; c++) sum[c] = p[c] * sp.w_first;
+    if (sp.last > sp.first) {
+      uint32_t inner[D] = { 0 };
+      for (int i = sp.first + 1; i < sp.last; i++) {
+        p += D;
+        for (int c = 0; c < D; c++) inner[c] += p[c];
+      }
+      p += D;
+      for (int c = 0; c < D; c++) sum[c] += inner[c] * N + p[c] * sp.w_last;
+    }
+    for (int c = 0; c < D; c++) dst[c] = sum[c];
+  }
+}
+
+// Vertical area pass: adds a summed line with weight wy to the sums
+static void area_acc_(uint64_t *acc, const uint32_t *line, int n, uint32_t wy) {
+  int i = 0;
+#if FL_SCALE_SSE2
+  const __m128i zero = _mm_setzero_si128(), w = _mm_set1_epi32((int)wy);
+  for (; i + 4 <= n; i += 4) {
+    __m128i l = _mm_loadu_si128((const __m128i *)(line + i));
+    __m128i a0 = _mm_loadu_si128((const __m128i *)(acc + i));
+    __m128i a1 = _mm_loadu_si128((const __m128i *)(acc + i + 2));
+    a0 = _mm_add_epi64(a0, _mm_mul_epu32(_mm_unpacklo_epi32(l, zero), w));
+    a1 = _mm_add_epi64(a1, _mm_mul_epu32(_mm_unpackhi_epi32(l, zero), w));
+    _mm_storeu_si128((__m128i *)(acc + i), a0);
+    _mm_storeu_si128((__m128i *)(acc + i + 2), a1);
+  }
+#endif // FL_SCALE_SSE2
+  for (; i < n; i++)
+    acc[i] += (uint64_t)line[i] * wy;
+}
+
+/**
+  Create a scaled down copy of this image by averaging the area of the source
+  pixels that are covered by each new pixel.
+
+  This is the best quality filter for scaling images down by any factor,
+  since every source pixel contributes to the result. It must not be used
+  to scale up, i.e. \p W and \p H must not be larger than the source size.
+
+  \param[in] W, H  Requested width and height of the new image
+  \returns  A new image object with the requested size. The caller is responsible
+           for deleting the returned image object when it is no longer needed.
+*/
+Fl_RGB_Image *Fl_RGB_Image::copy_area_(int W, int H) const {
+  const int D = d();
+  const int SW = data_w();
+  const int SH = data_h();
+  const int SLD = ld() ? ld() : SW * D;
+  const int row_d = W * D;
+
+  uchar *new_array = new uchar[((long)W) * H * D];
+  Fl_RGB_Image *new_image = new Fl_RGB_Image(new_array, W, H, D);
+  new_image->alloc_array = 1;
+
+  Fl_Area_Span *x_span = new Fl_Area_Span[W];
+  Fl_Area_Span *y_span = new Fl_Area_Span[H];
+  area_spans_(x_span, SW, W);
+  area_spans_(y_span, SH, H);
+
+  const double norm = 1.0 / ((double)SW * SH); // all weights add up to SW * SH
+
+  scale_rows_(H, (long)SW * SH * D + (long)row_d * H, [&](int ys, int ye) {
+    uint32_t *line = new uint32_t[row_d];  // one source line summed horizontally
+    uint64_t *acc  = new uint64_t[row_d];  // weighted sum of the summed lines
+    int line_y = -1;                       // source line currently in line[]
+    for (int y = ys; y < ye; y++) {
+      const Fl_Area_Span &sp = y_span[y];
+      memset(acc, 0, row_d * sizeof(uint64_t));
+      for (int sy = sp.first; sy <= sp.last; sy++) {
+        // The last source line of a span is often the first of the next one
+        if (sy != line_y) {
+          const uint8_t *src = array + (long)sy * SLD;
+          switch (D) {
+            case 1: area_row_<1>(line, src, x_span, W, W); break;
+            case 2: area_row_<2>(line, src, x_span, W, W); break;
+            case 3: area_row_<3>(line, src, x_span, W, W); break;
+            case 4: area_row_<4>(line, src, x_span, W, W); break;
+          }
+          line_y = sy;
+        }
+        uint32_t wy = (sy == sp.first) ? sp.w_first : (sy == sp.last) ? sp.w_last : (uint32_t)H;
+        area_acc_(acc, line, row_d, wy);
+      }
+      uchar *dst = new_array + (long)y * row_d;
+      for (int i = 0; i < row_d; i++)
+        dst[i] = (uchar)((double)(int64_t)acc[i] * norm + 0.5);
+    }
+    delete[] line;
+    delete[] acc;
+  });
+
+  delete[] x_span;
+  delete[] y_span;
+
+  return new_image;
+}
+
 /**
   Create a scaled down copy of this image by a factor of 2 in the horizontal direction.
  */
@@ -777,6 +1130,9 @@ Fl_Image *Fl_RGB_Image::copy(int W, int H) const {
   if (W <= 0 || H <= 0) return nullptr;
   if (Fl_Image::RGB_scaling() == FL_RGB_SCALING_NEAREST) {
     return copy_nearest_neighbor_(W, H);
+  } else if (Fl_Image::RGB_scaling() == FL_RGB_SCALING_AREA &&
+             W <= data_w() && H <= data_h()) {
+    return copy_area_(W, H);
   } else {
     // Bilinear scaling only scales down between 100% and 50%. If our image is
     // much larger, divide it by two in either direction first. This is not
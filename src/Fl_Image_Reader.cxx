@@ -34,6 +34,9 @@
   duplication and may be extended to be used in similar cases. Future
   options might be to read data in MSB-first byte order or to add more
   methods.
+
+  When reading from a file, data_ and end_ point into a block buffer
+  instead of the memory block, and start_ is not used.
 */
 
 // Initialize the reader to access the file system, filename is copied
@@ -46,6 +49,9 @@ int Fl_Image_Reader::open(const char *filename) {
     return -1;
   }
   is_file_ = 1;
+  buffer_ = new unsigned char[FL_IMAGE_READER_BUFSIZE];
+  buffer_pos_ = 0;
+  data_ = end_ = buffer_;
   return 0;
 }
 
@@ -73,6 +79,7 @@ int Fl_Image_Reader::open(const char *imagename, const unsigned char *data) {
     name_ = fl_strdup(imagename);
   if (data) {
     start_ = data_ = data;
+    end_ = (const unsigned char *)(-1L); // unlimited
     is_data_ = 1;
     return 0;
   }
@@ -84,26 +91,38 @@ Fl_Image_Reader::~Fl_Image_Reader() {
   if (is_file_ && file_) {
     fclose(file_);
   }
+  delete[] buffer_;
   if (name_)
     free(name_);
 }
 
-// Read a single byte from memory or a file
-uchar Fl_Image_Reader::read_byte() {
+// Read the next block from the file into the buffer.
+// Returns the number of bytes in the buffer, 0 on EOF or error.
+int Fl_Image_Reader::fill_buffer_() {
+  buffer_pos_ += (long)(end_ - buffer_);
+  size_t n = fread(buffer_, 1, FL_IMAGE_READER_BUFSIZE, file_);
+  data_ = buffer_;
+  end_ = buffer_ + n;
+  if (n == 0) {
+    if (feof(file_))
+      error_ = 1;
+    else if (ferror(file_))
+      error_ = 2;
+    else
+      error_ = 3; // unknown error
+  }
+  return (int)n;
+}
+
+// Read a single byte from memory or a file, called by read_byte()
+// if the buffer is empty, at the end of memory, or after an error
+uchar Fl_Image_Reader::read_byte_() {
   if (error()) // don't read after read error or EOF
     return 0;
   if (is_file_) {
-    int ret = getc(file_);
-    if (ret < 0) {
-      if (feof(file_))
-        error_ = 1;
-      else if (ferror(file_))
-        error_ = 2;
-      else
-        error_ = 3; // unknown error
+    if (!fill_buffer_())
       return 0;
-    }
-    return ret;
+    return *data_++;
   } else if (is_data_) {
     if (data_ < end_)
       return *data_++;
@@ -114,6 +133,49 @@ uchar Fl_Image_Reader::read_byte() {
   return 0;
 }
 
+// Read up to n bytes into dst and return the number of bytes read.
+// Sets the EOF or error status if less than n bytes could be read.
+size_t Fl_Image_Reader::read(uchar *dst, size_t n) {
+  if (error()) // don't read after read error or EOF
+    return 0;
+  size_t done = 0;
+  if (is_file_) {
+    for (;;) {
+      size_t avail = (size_t)(end_ - data_);
+      if (avail > n - done) avail = n - done;
+      memcpy(dst + done, data_, avail);
+      data_ += avail;
+      done += avail;
+      if (done == n)
+        break;
+      // read large remainders directly, bypassing the buffer
+      if (n - done >= FL_IMAGE_READER_BUFSIZE) {
+        buffer_pos_ += (long)(end_ - buffer_);
+        data_ = end_ = buffer_;
+        size_t got = fread(dst + done, 1, n - done, file_);
+        buffer_pos_ += (long)got;
+        done += got;
+        if (done < n)
+          error_ = feof(file_) ? 1 : 2;
+        break;
+      }
+      if (!fill_buffer_())
+        break;
+    }
+  } else if (is_data_) {
+    done = (size_t)(end_ - data_);
+    if (done > n)
+      done = n;
+    memcpy(dst, data_, done);
+    data_ += done;
+    if (done < n)
+      error_ = 1; // EOF
+  } else {
+    error_ = 3; // undefined mode
+  }
+  return done;
+}
+
 // Read a 16-bit unsigned integer, LSB-first
 unsigned short Fl_Image_Reader::read_word() {
   unsigned char b0, b1; // Bytes from file or memory
@@ -144,7 +206,14 @@ unsigned int Fl_Image_Reader::read_dword() {
 void Fl_Image_Reader::seek(unsigned int n) {
   error_ = 0;
   if (is_file_) {
+    // seek inside the buffer without a system call if possible
+    if ((long)n >= buffer_pos_ && (long)n <= buffer_pos_ + (long)(end_ - buffer_)) {
+      data_ = buffer_ + (n - buffer_pos_);
+      return;
+    }
     int ret = fseek(file_, n, SEEK_SET);
+    buffer_pos_ = n;
+    data_ = end_ = buffer_;
     if (ret < 0)
       error_ = 2; // read / position error
     return;
@@ -162,12 +231,11 @@ void Fl_Image_Reader::seek(unsigned int n) {
 // Get the current read position as a byte offset from the
 // beginning of the file or the original start address in memory.
 // This method does neither affect the error flag nor is it affected
-// by the current error status. If reading from a file, this may
-// return -1 or any error code from ftell().
+// by the current error status.
 
 long Fl_Image_Reader::tell() const {
   if (is_file_) {
-    return ftell(file_);
+    return buffer_pos_ + (long)(data_ - buffer_);
   } else if (is_data_) {
     return long(data_ - start_);
   }
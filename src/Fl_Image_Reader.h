@@ -22,6 +22,10 @@
   duplication and may be extended to be used in similar cases. Future
   options might be to read data in MSB-first byte order or to add more
   methods.
+
+  Files are read in blocks of FL_IMAGE_READER_BUFSIZE bytes, so read_byte()
+  is an inline pointer increment for files as well as for memory. Use
+  read() to copy larger chunks of data.
 */
 
 #ifndef FL_IMAGE_READER_H
@@ -29,6 +33,9 @@
 
 #include <stdio.h>
 
+// size of the block buffer for reading files
+#define FL_IMAGE_READER_BUFSIZE 65536
+
 class Fl_Image_Reader {
 public:
   // Create the reader.
@@ -38,9 +45,11 @@ public:
     , file_(0L)
     , data_(0L)
     , start_(0L)
-    , end_((const unsigned char *)(-1L))
+    , end_(0L)
     , name_(0L)
-    , error_(0) {}
+    , error_(0)
+    , buffer_(0L)
+    , buffer_pos_(0) {}
 
   // Initialize the reader to access the file system, filename is copied
   // and stored.
@@ -55,7 +64,15 @@ public:
   ~Fl_Image_Reader();
 
   // Read a single byte from memory or a file
-  unsigned char read_byte();
+  unsigned char read_byte() {
+    if (!error_ && data_ < end_)
+      return *data_++;
+    return read_byte_();
+  }
+
+  // Read up to n bytes into dst, return the number of bytes read.
+  // Sets the EOF or error status if less than n bytes could be read.
+  size_t read(unsigned char *dst, size_t n);
 
   // Read a 16-bit unsigned integer, LSB-first
   unsigned short read_word();
@@ -113,14 +130,23 @@ private:
   const unsigned char *data_;
   // a pointer to the start of the image data
   const unsigned char *start_;
-  // a pointer to the end of image data if reading from memory, otherwise undefined
-  // note: currently (const unsigned char *)(-1L) if end of memory is not available
+  // a pointer to the end of image data if reading from memory, or to the end
+  // of the buffered data if reading from a file, 0L until open() succeeds
+  // note: (const unsigned char *)(-1L) if end of memory is not available
   // ... which means "unlimited"
   const unsigned char *end_;
   // a copy of the name associated with this reader
   char *name_;
   // a flag to store EOF or error status
   int error_;
+  // file data is read in blocks into this buffer, data_ and end_ point into it
+  unsigned char *buffer_;
+  // the file offset of buffer_[0]
+  long buffer_pos_;
+  // read the next block from the file, return 0 on EOF or error
+  int fill_buffer_();
+  // read a byte if the buffer is empty or at the end of memory
+  unsigned char read_byte_();
 };
 
 #endif // FL_IMAGE_READER_H
@@ -134,6 +134,33 @@ Fl_JPEG_Image::Fl_JPEG_Image(const char *name, const unsigned char *data, int da
   load_jpg_(0L, name, data, data_length);
 }
 
+/**
+ \brief The constructor loads a reduced size JPEG image from the given file.
+
+ This is meant for thumbnails and previews of large photos. The JPEG decoder
+ scales the image down by 1/2, 1/4, or 1/8 while decoding, which is much
+ faster and needs much less memory than decoding the image at full size
+ and scaling it afterwards. The largest reduction is used that still
+ yields an image of at least \p max_w x \p max_h pixels, so the image
+ can be scaled to its final size with copy(int, int) or scale() without
+ losing quality. Use 0 for \p max_w or \p max_h if either dimension
+ does not matter.
+
+ Grayscale images are loaded with only one channel (d() == 1), whereas
+ the other constructors always return RGB images.
+
+ \param[in] filename a full path and name pointing to a valid jpeg file.
+ \param[in] max_w, max_h the size the image will be displayed at
+
+ \see Fl_JPEG_Image::Fl_JPEG_Image(const char *filename)
+ \since 1.5.0
+ */
+Fl_JPEG_Image::Fl_JPEG_Image(const char *filename, int max_w, int max_h)
+: Fl_RGB_Image(0,0,0)
+{
+  load_jpg_(filename, 0L, 0L, -1, max_w > 0 ? max_w : 1, max_h > 0 ? max_h : 1);
+}
+
 
 // data source manager for reading jpegs from memory
 // init_source (j_decompress_ptr cinfo)
@@ -233,13 +260,16 @@ struct load_stat {
  To avoid code duplication, we set filename if we want to read from a file
  or data to read from memory instead. Sharename can be set if the image is
  supposed to be added to the Fl_Shared_Image list.
+ If max_w and max_h are set, the image is decoded at a reduced size that is
+ not smaller than max_w x max_h, and grayscale images are kept grayscale.
  */
-void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const unsigned char *data, int data_length)
+void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const unsigned char *data, int data_length,
+                              int max_w, int max_h)
 {
 #ifdef HAVE_LIBJPEG
   jpeg_decompress_struct  dinfo;    // Decompressor info
   fl_jpeg_error_mgr       jerr;     // Error handler info
-  JSAMPROW                row;      // Sample row pointer
+  JSAMPROW                rows[16]; // Sample row pointers
 
   struct load_stat lstat;
 
@@ -306,9 +336,28 @@ void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const
   jpeg_read_header(&dinfo, TRUE);
 
   dinfo.quantize_colors      = (boolean)FALSE;
-  dinfo.out_color_space      = JCS_RGB;
-  dinfo.out_color_components = 3;
-  dinfo.output_components    = 3;
+  if (max_w > 0 && max_h > 0 && dinfo.jpeg_color_space == JCS_GRAYSCALE) {
+    // don't expand grayscale to RGB if the caller accepts it
+    dinfo.out_color_space      = JCS_GRAYSCALE;
+    dinfo.out_color_components = 1;
+    dinfo.output_components    = 1;
+  } else {
+    dinfo.out_color_space      = JCS_RGB;
+    dinfo.out_color_components = 3;
+    dinfo.output_components    = 3;
+  }
+
+  // Let the DCT scale the image down by 1/2, 1/4, or 1/8 as long as
+  // it stays at least as large as requested
+  if (max_w > 0 && max_h > 0) {
+    unsigned int denom = 1;
+    while (denom < 8 &&
+           (dinfo.image_width + 2 * denom - 1) / (2 * denom) >= (unsigned int)max_w &&
+           (dinfo.image_height + 2 * denom - 1) / (2 * denom) >= (unsigned int)max_h)
+      denom *= 2;
+    dinfo.scale_num   = 1;
+    dinfo.scale_denom = denom;
+  }
 
   jpeg_calc_output_dimensions(&dinfo);
 
@@ -322,11 +371,18 @@ void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const
 
   jpeg_start_decompress(&dinfo);
 
+  // Read as many lines per call as the decoder can deliver
   while (dinfo.output_scanline < dinfo.output_height) {
-    row = (JSAMPROW)(array +
-                     dinfo.output_scanline * dinfo.output_width *
-                     dinfo.output_components);
-    jpeg_read_scanlines(&dinfo, &row, (JDIMENSION)1);
+    int n = dinfo.rec_outbuf_height;
+    if (n < 1) n = 1;
+    else if (n > 16) n = 16;
+    if (dinfo.output_scanline + n > dinfo.output_height)
+      n = dinfo.output_height - dinfo.output_scanline;
+    for (int i = 0; i < n; i++)
+      rows[i] = (JSAMPROW)(array +
+                           (dinfo.output_scanline + i) * dinfo.output_width *
+                           dinfo.output_components);
+    jpeg_read_scanlines(&dinfo, rows, (JDIMENSION)n);
   }
 
   jpeg_finish_decompress(&dinfo);
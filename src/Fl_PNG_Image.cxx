@@ -4,7 +4,7 @@
 // Copyright 1997-2012 by Easy Software Products.
 // Image support by Matthias Melcher, Copyright 2000-2009.
 //
-// Copyright 2013-2022 by Bill Spitzak and others.
+// Copyright 2013-2026 by Bill Spitzak and others.
 //
 // This library is free software. Distribution and use rights are outlined in
 // the file "COPYING" which should have been included with this file.  If this
@@ -35,6 +35,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
 extern "C"
@@ -69,115 +70,114 @@ extern "C" {
     png_mem_data->current += length;
   }
 } // extern "C"
-#endif // HAVE_LIBPNG && HAVE_LIBZ
-
-
-/**
- The constructor loads the named PNG image from the given png filename.
-
- The destructor frees all memory and server resources that are used by
- the image.
-
- Use Fl_Image::fail() to check if Fl_PNG_Image failed to load. fail() returns
- ERR_FILE_ACCESS if the file could not be opened or read, ERR_FORMAT if the
- PNG format could not be decoded, and ERR_NO_IMAGE if the image could not
- be loaded for another reason.
 
- \param[in] filename    Name of PNG file to read
- */
-Fl_PNG_Image::Fl_PNG_Image (const char *filename): Fl_RGB_Image(0,0,0)
-{
-  load_png_(filename, 0, NULL, 0);
+/*
+  State of a PNG decoder run by fl_read_png().
+
+  Everything that is needed after a longjmp() from libpng is kept in this
+  struct instead of automatic variables (gcc: [-Wclobbered]).
+*/
+struct fl_png_reader {
+  const char *name;             // file name or shared image name
+  int offset;                   // start of PNG data in the file
+  const unsigned char *buffer;  // PNG data in memory, or NULL
+  int maxsize;                  // size of PNG data in memory
+  int header_only;              // stop after reading the header
+  int alloc;                    // allocate 'out' for the rectangle
+  int w, h, d;                  // image size and depth (output)
+  int X, Y, W, H;               // rectangle to decode, W == 0 for all
+  uchar *out;                   // rows of the rectangle, or NULL
+  int ld;                       // bytes per row in 'out'
+  Fl_PNG_Row_Callback cb;       // called for each row, or NULL
+  void *data;                   // user data for 'cb'
+  int rows;                     // number of rows decoded (output)
+  FILE *fp;                     // open file
+  uchar *row;                   // one full image row
+  uchar *band;                  // full width rows of the rectangle (interlaced)
+};
+
+static void fl_png_cleanup(fl_png_reader *r) {
+  if (r->fp) fclose(r->fp);
+  delete[] r->row;
+  delete[] r->band;
+  r->fp = NULL;
+  r->row = r->band = NULL;
 }
 
-// private c'tor used by Fl_ICO_Image
-// \param     offset      Offset to seek for the begin of PNG data inside a .ICO file
-Fl_PNG_Image::Fl_PNG_Image (const char *filename, int offset): Fl_RGB_Image(0,0,0)
-{
-  load_png_(filename, offset, NULL, 0);
+/*
+  Stores a finished row of the rectangle and calls the row callback.
+  Returns non-zero to stop decoding.
+*/
+static int fl_png_row(fl_png_reader *r, uchar *src, int y) {
+  uchar *dst = src;
+  if (r->out) {
+    dst = r->out + (size_t)y * r->ld;
+    if (dst != src) memcpy(dst, src, (size_t)r->W * r->d);
+  }
+  if (r->d == 4) Fl::system_driver()->png_extra_rgba_processing(dst, r->W, 1);
+  r->rows ++;
+  return r->cb && (r->cb)(dst, y, r->data);
 }
 
-/**
- \brief Constructor that reads a PNG image from memory.
-
- Construct an image from a block of memory inside the application. Fluid offers
- "binary Data" chunks as a great way to add image data into the C++ source code.
- name_png can be NULL. If a name is given, the image is added to the list of
- shared images (see: Fl_Shared_Image) and will be available by that name.
-
- \param name_png  A name given to this image or NULL
- \param buffer    Pointer to the start of the PNG image in memory
- \param maxsize   Size in bytes of the memory buffer containing the PNG image
- */
-Fl_PNG_Image::Fl_PNG_Image (
-      const char *name_png, const unsigned char *buffer, int maxsize): Fl_RGB_Image(0,0,0)
-{
-  load_png_(name_png, 0, buffer, maxsize);
-}
+/*
+  Reads a PNG image from a file or from memory.
 
+  Only the rows down to the bottom of the requested rectangle are decoded,
+  one row at a time. Without interlacing this needs a single row buffer in
+  addition to the output. Interlaced images need the full width rows of
+  the rectangle, since every pass adds pixels to every row.
 
-void Fl_PNG_Image::load_png_(const char *name_png, int offset, const unsigned char *buffer_png, int maxsize)
-{
-#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
-  int i;                // Looping var
-  int channels;         // Number of color channels
+  Returns 0 or an Fl_Image::ERR_* error code.
+*/
+static int fl_read_png(fl_png_reader *r) {
   png_structp pp;       // PNG read pointer
   png_infop info = 0;   // PNG info pointers
-  png_bytep *rows;      // PNG row pointers
   fl_png_memory png_mem_data;
-  int from_memory = (buffer_png != NULL); // true if reading image from memory
-
-  // Note: The file pointer fp must not be an automatic (stack) variable
-  // to avoid potential clobbering by setjmp/longjmp (gcc: [-Wclobbered]).
-  // Hence the actual 'fp' is allocated with operator new.
-
-  FILE** fp = new FILE*;   // always allocate file pointer
-  *fp = NULL;
-
-  if (!from_memory) {
-    if ((*fp = fl_fopen(name_png, "rb")) == NULL) {
-      ld(ERR_FILE_ACCESS);
-      delete fp;
-      return;
-    }
-    if (offset > 0 && fseek(*fp, (long)offset, SEEK_SET) == -1) {
-      fclose(*fp);
-      ld(ERR_FORMAT);
-      delete fp;
-      return;
+  const char *display_name = (r->name ? r->name : "In-memory PNG data");
+
+  r->fp   = NULL;
+  r->row  = NULL;
+  r->band = NULL;
+  r->rows = 0;
+
+  if (!r->buffer) {
+    if ((r->fp = fl_fopen(r->name, "rb")) == NULL)
+      return Fl_Image::ERR_FILE_ACCESS;
+    if (r->offset > 0 && fseek(r->fp, (long)r->offset, SEEK_SET) == -1) {
+      fl_png_cleanup(r);
+      return Fl_Image::ERR_FORMAT;
     }
   }
-  const char *display_name = (name_png ? name_png : "In-memory PNG data");
 
   // Setup the PNG data structures...
   pp = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
   if (pp) info = png_create_info_struct(pp);
   if (!pp || !info) {
     if (pp) png_destroy_read_struct(&pp, NULL, NULL);
-    if (!from_memory) fclose(*fp);
+    fl_png_cleanup(r);
     Fl::warning("Cannot allocate memory to read PNG file or data \"%s\".\n", display_name);
-    w(0); h(0); d(0); ld(ERR_FORMAT);
-    delete fp;
-    return;
+    return Fl_Image::ERR_FORMAT;
   }
 
   if (setjmp(png_jmpbuf(pp))) {
     png_destroy_read_struct(&pp, &info, NULL);
-    if (!from_memory) fclose(*fp);
+    fl_png_cleanup(r);
+    if (r->alloc) {
+      delete[] r->out;
+      r->out = NULL;
+    }
     Fl::warning("PNG file or data \"%s\" is too large or contains errors!\n", display_name);
-    w(0); h(0); d(0); ld(ERR_FORMAT);
-    delete fp;
-    return;
+    return Fl_Image::ERR_FORMAT;
   }
 
-  if (from_memory) {
-    png_mem_data.current = buffer_png;
-    png_mem_data.last = buffer_png + maxsize;
+  if (r->buffer) {
+    png_mem_data.current = r->buffer;
+    png_mem_data.last = r->buffer + r->maxsize;
     png_mem_data.pp = pp;
     // Initialize the function pointer to the PNG read "engine"...
     png_set_read_fn (pp, (png_voidp) &png_mem_data, png_read_data_from_mem);
   } else {
-    png_init_io(pp, *fp); // Initialize the PNG file read "engine"...
+    png_init_io(pp, r->fp); // Initialize the PNG file read "engine"...
   }
 
   // Get the image dimensions and convert to grayscale or RGB...
@@ -186,6 +186,7 @@ void Fl_PNG_Image::load_png_(const char *name_png, int offset, const unsigned ch
   if (png_get_color_type(pp, info) == PNG_COLOR_TYPE_PALETTE)
     png_set_expand(pp);
 
+  int channels;         // Number of color channels
   if (png_get_color_type(pp, info) & PNG_COLOR_MASK_COLOR)
     channels = 3;
   else
@@ -196,9 +197,9 @@ void Fl_PNG_Image::load_png_(const char *name_png, int offset, const unsigned ch
   if ((png_get_color_type(pp, info) & PNG_COLOR_MASK_ALPHA) || (num_trans != 0))
     channels ++;
 
-  w((int)(png_get_image_width(pp, info)));
-  h((int)(png_get_image_height(pp, info)));
-  d(channels);
+  r->w = (int)(png_get_image_width(pp, info));
+  r->h = (int)(png_get_image_height(pp, info));
+  r->d = channels;
 
   if (png_get_bit_depth(pp, info) < 8)
   {
@@ -214,36 +215,268 @@ void Fl_PNG_Image::load_png_(const char *name_png, int offset, const unsigned ch
     png_set_tRNS_to_alpha(pp);
 #  endif // HAVE_PNG_GET_VALID && HAVE_PNG_SET_TRNS_TO_ALPHA
 
-  if (((size_t)w()) * h() * d() > max_size() ) longjmp(png_jmpbuf(pp), 1);
-  array = new uchar[w() * h() * d()];
-  alloc_array = 1;
-
-  // Allocate pointers...
-  rows = new png_bytep[h()];
+  if (r->header_only) {
+    png_destroy_read_struct(&pp, &info, NULL);
+    fl_png_cleanup(r);
+    return 0;
+  }
 
-  for (i = 0; i < h(); i ++)
-    rows[i] = (png_bytep)(array + i * w() * d());
+  // Clip the rectangle to the image...
+  if (r->W == 0) {
+    r->X = r->Y = 0;
+    r->W = r->w;
+    r->H = r->h;
+  }
+  if (r->out && !r->ld) r->ld = r->W * r->d;  // caller's stride, even if clipped
+  if (r->X < 0) { r->W += r->X; r->X = 0; }
+  if (r->Y < 0) { r->H += r->Y; r->Y = 0; }
+  if (r->X + r->W > r->w) r->W = r->w - r->X;
+  if (r->Y + r->H > r->h) r->H = r->h - r->Y;
+  if (r->W <= 0 || r->H <= 0) {
+    r->W = r->H = 0;
+    png_destroy_read_struct(&pp, &info, NULL);
+    fl_png_cleanup(r);
+    return 0;
+  }
 
-  // Read the image, handling interlacing as needed...
-  for (i = png_set_interlace_handling(pp); i > 0; i --)
-    png_read_rows(pp, rows, NULL, h());
+  size_t line = (size_t)r->w * r->d;    // bytes per image row
+  if (r->alloc) {
+    if ((size_t)r->W * r->H * r->d > Fl_RGB_Image::max_size()) longjmp(png_jmpbuf(pp), 1);
+    r->ld  = r->W * r->d;
+    r->out = new uchar[(size_t)r->ld * r->H];
+  }
 
-  if (channels == 4) Fl::system_driver()->png_extra_rgba_processing((uchar*)array, w(), h());
+  // Decode directly into the output if it has whole image rows
+  uchar *direct = NULL;
+  if (r->out && r->X == 0 && r->W == r->w && (size_t)r->ld == line)
+    direct = r->out;
+
+  int bottom = r->Y + r->H;
+  int passes = png_set_interlace_handling(pp);
+  int y, stop = 0;
+
+  if (passes == 1) {
+    if (!direct || r->Y > 0) r->row = new uchar[line];
+    for (y = 0; y < bottom && !stop; y ++) {
+      uchar *p = (direct && y >= r->Y) ? direct + (y - r->Y) * line : r->row;
+      png_read_row(pp, p, NULL);
+      if (y >= r->Y) stop = fl_png_row(r, p + r->X * r->d, y - r->Y);
+    }
+  } else {
+    uchar *band = direct;
+    if (!band) band = r->band = new uchar[line * r->H];
+    if (r->Y > 0 || bottom < r->h) r->row = new uchar[line];
+    for (int pass = 1; pass <= passes && !stop; pass ++) {
+      // The last pass completes the rows from top to bottom
+      int last = (pass == passes) ? bottom : r->h;
+      for (y = 0; y < last && !stop; y ++) {
+        uchar *p = (y >= r->Y && y < bottom) ? band + (y - r->Y) * line : r->row;
+        png_read_row(pp, p, NULL);
+        if (pass == passes && y >= r->Y)
+          stop = fl_png_row(r, p + r->X * r->d, y - r->Y);
+      }
+    }
+  }
 
   // Free memory and return...
-  delete[] rows;
-
-  png_read_end(pp, info);
+  if (!stop && bottom == r->h) png_read_end(pp, info);
   png_destroy_read_struct(&pp, &info, NULL);
+  fl_png_cleanup(r);
+  return 0;
+}
+#endif // HAVE_LIBPNG && HAVE_LIBZ
 
-  if (from_memory) {
-    if (w() && h() && name_png) {
-      Fl_Shared_Image *si = new Fl_Shared_Image(name_png, this);
-      si->add();
-    }
-  } else {
-    fclose(*fp);
+
+/**
+ The constructor loads the named PNG image from the given png filename.
+
+ The destructor frees all memory and server resources that are used by
+ the image.
+
+ Use Fl_Image::fail() to check if Fl_PNG_Image failed to load. fail() returns
+ ERR_FILE_ACCESS if the file could not be opened or read, ERR_FORMAT if the
+ PNG format could not be decoded, and ERR_NO_IMAGE if the image could not
+ be loaded for another reason.
+
+ \param[in] filename    Name of PNG file to read
+ */
+Fl_PNG_Image::Fl_PNG_Image (const char *filename): Fl_RGB_Image(0,0,0)
+{
+  load_png_(filename, 0, NULL, 0);
+}
+
+// private c'tor used by Fl_ICO_Image
+// \param     offset      Offset to seek for the begin of PNG data inside a .ICO file
+Fl_PNG_Image::Fl_PNG_Image (const char *filename, int offset): Fl_RGB_Image(0,0,0)
+{
+  load_png_(filename, offset, NULL, 0);
+}
+
+/**
+ \brief Constructor that reads a PNG image from memory.
+
+ Construct an image from a block of memory inside the application. Fluid offers
+ "binary Data" chunks as a great way to add image data into the C++ source code.
+ name_png can be NULL. If a name is given, the image is added to the list of
+ shared images (see: Fl_Shared_Image) and will be available by that name.
+
+ \param name_png  A name given to this image or NULL
+ \param buffer    Pointer to the start of the PNG image in memory
+ \param maxsize   Size in bytes of the memory buffer containing the PNG image
+ */
+Fl_PNG_Image::Fl_PNG_Image (
+      const char *name_png, const unsigned char *buffer, int maxsize): Fl_RGB_Image(0,0,0)
+{
+  load_png_(name_png, 0, buffer, maxsize);
+}
+
+/**
+ The constructor loads a rectangle of the named PNG image file.
+
+ Only the rows down to the bottom of the rectangle are decoded, and only
+ the pixels inside the rectangle are kept, so that a small part of a huge
+ image can be loaded without decoding the whole image into memory.
+
+ The rectangle is clipped to the image. If it is empty, fail() returns
+ ERR_NO_IMAGE. Other errors are reported like Fl_PNG_Image(const char *).
+
+ \param[in] filename    Name of PNG file to read
+ \param[in] X, Y, W, H  Rectangle to load, in image pixels
+
+ \see read_rows()
+ \since 1.5.0
+ */
+Fl_PNG_Image::Fl_PNG_Image(const char *filename, int X, int Y, int W, int H): Fl_RGB_Image(0,0,0)
+{
+  if (W <= 0 || H <= 0) {
+    w(0); h(0); d(0); ld(ERR_NO_IMAGE);
+    return;
+  }
+  load_png_(filename, 0, NULL, 0, X, Y, W, H);
+}
+
+/**
+ Reads the size and depth of a PNG image file without decoding it.
+
+ The depth \p D is the number of bytes per pixel of the decoded image,
+ as returned by d() of an Fl_PNG_Image loaded from the same file.
+
+ \param[in]  filename   Name of PNG file to read
+ \param[out] W, H, D    Image size and depth
+ \return 0 on success, or ERR_FILE_ACCESS or ERR_FORMAT
+
+ \since 1.5.0
+ */
+int Fl_PNG_Image::read_header(const char *filename, int &W, int &H, int &D)
+{
+  W = H = D = 0;
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+  fl_png_reader r;
+  memset(&r, 0, sizeof(r));
+  r.name        = filename;
+  r.header_only = 1;
+  int err = fl_read_png(&r);
+  if (err) return err;
+  W = r.w;
+  H = r.h;
+  D = r.d;
+  return 0;
+#else
+  return ERR_FORMAT;
+#endif // HAVE_LIBPNG && HAVE_LIBZ
+}
+
+/**
+ Decodes a rectangle of a PNG image file row by row.
+
+ Rows are decoded from the top of the image down to the bottom of the
+ rectangle, and the pixels inside the rectangle are stored in \p buffer,
+ if it is not NULL. Each row has W * D bytes, where D is the depth
+ returned by read_header(), and rows are \p ld bytes apart.
+
+ If the rectangle is clipped to the image, \p buffer holds the rows of the
+ clipped rectangle, starting with its top left pixel, and each row has fewer
+ bytes. \p ld = 0 stands for W * D with W as passed in, not the clipped
+ width, so the stride doesn't depend on the clipping and a buffer of
+ W * D * H bytes is always large enough.
+
+ After each row of the rectangle has been decoded, \p cb is called with
+ a pointer to the row. The callback can be used to show the progress of
+ loading a huge image, for instance by calling Fl_Image::uncache() and
+ redrawing an Fl_RGB_Image that uses \p buffer. If \p buffer is NULL,
+ the callback can process the image one row at a time, so the decoded
+ image never needs to be held in memory. The callback returns non-zero
+ to stop decoding.
+
+ Interlaced images are decoded in several passes over the whole image,
+ and their rows are complete only in the last pass. They need a temporary
+ buffer for the full width rows of the rectangle.
+
+ \param[in] filename    Name of PNG file to read
+ \param[in] buffer      Buffer for the rows of the rectangle, or NULL
+ \param[in] ld          Bytes per row in \p buffer, or 0 for W * D (unclipped W)
+ \param[in] X, Y, W, H  Rectangle to decode, clipped to the image
+ \param[in] cb          Callback for each decoded row, or NULL
+ \param[in] data        User data for \p cb
+ \return the number of rows decoded, or ERR_FILE_ACCESS or ERR_FORMAT
+
+ \see read_header()
+ \since 1.5.0
+ */
+int Fl_PNG_Image::read_rows(const char *filename, uchar *buffer, int ld,
+                            int X, int Y, int W, int H,
+                            Fl_PNG_Row_Callback cb, void *data)
+{
+  if (W <= 0 || H <= 0) return 0;
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+  fl_png_reader r;
+  memset(&r, 0, sizeof(r));
+  r.name = filename;
+  r.X = X; r.Y = Y; r.W = W; r.H = H;
+  r.out  = buffer;
+  r.ld   = ld;
+  r.cb   = cb;
+  r.data = data;
+  int err = fl_read_png(&r);
+  return err ? err : r.rows;
+#else
+  return ERR_FORMAT;
+#endif // HAVE_LIBPNG && HAVE_LIBZ
+}
+
+
+void Fl_PNG_Image::load_png_(const char *name_png, int offset, const unsigned char *buffer_png, int maxsize,
+                             int X, int Y, int W, int H)
+{
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+  fl_png_reader r;
+  memset(&r, 0, sizeof(r));
+  r.name    = name_png;
+  r.offset  = offset;
+  r.buffer  = buffer_png;
+  r.maxsize = maxsize;
+  r.alloc   = 1;
+  r.X = X; r.Y = Y; r.W = W; r.H = H;
+
+  int err = fl_read_png(&r);
+  if (err) {
+    w(0); h(0); d(0); ld(err);
+    return;
+  }
+  if (!r.out) {
+    w(0); h(0); d(0); ld(ERR_NO_IMAGE);
+    return;
+  }
+
+  w(r.W);
+  h(r.H);
+  d(r.d);
+  array = r.out;
+  alloc_array = 1;
+
+  if (buffer_png && name_png) {
+    Fl_Shared_Image *si = new Fl_Shared_Image(name_png, this);
+    si->add();
   }
-  delete fp;
 #endif // HAVE_LIBPNG && HAVE_LIBZ
 }
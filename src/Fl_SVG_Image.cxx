@@ -1,7 +1,7 @@
 //
 // SVG image code for the Fast Light Tool Kit (FLTK).
 //
-// Copyright 2017-2024 by Bill Spitzak and others.
+// Copyright 2017-2026 by Bill Spitzak and others.
 //
 // This library is free software. Distribution and use rights are outlined in
 // the file "COPYING" which should have been included with this file.  If this
@@ -27,6 +27,8 @@
 #include "Fl_System_Driver.H"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 
 #include "../nanosvg/nanosvg.h"
 #include "../nanosvg/nanosvgrast.h"
@@ -35,6 +37,180 @@
 #include <zlib.h>
 #endif
 
+// Batches of images are rasterized by worker threads where FLTK supports threads
+#if defined(HAVE_PTHREAD) || defined(_MSC_VER)
+#  define FL_SVG_THREADS 1
+#  include <thread>
+#  include <mutex>
+#  include <atomic>
+#  include <system_error>
+#  include <vector>
+#else
+#  define FL_SVG_THREADS 0
+#endif
+
+// Number of rasterized sizes cached for each SVG image
+#define FL_SVG_RASTER_CACHE_SIZE 4
+// Largest rasterized image that is cached, in pixels
+#define FL_SVG_RASTER_CACHE_MAX (256 * 256)
+// Default memory budget of the raster cache of all SVG images, in bytes
+#define FL_SVG_RASTER_CACHE_BUDGET (32 * 1024 * 1024)
+
+/*
+  One rasterized size of an SVG image. All entries of all images are also
+  in one list, most recently used first, so that the least recently used
+  ones can be dropped when the cache exceeds its memory budget.
+*/
+struct Fl_SVG_Raster_Entry {
+  Fl_SVG_Raster_Entry *prev, *next;   // list of all entries
+  Fl_SVG_Raster_Cache *cache;         // cache of the image this is a size of
+  int w, h;
+  bool proportional;
+  uchar *pixels;
+};
+
+/*
+  Rasterized sizes of an SVG image, most recently used first.
+  The cache is shared by all copies of the image and holds the raw
+  rasterized pixels, before desaturate() or color_average().
+*/
+struct Fl_SVG_Raster_Cache {
+  int count;
+  Fl_SVG_Raster_Entry *entry[FL_SVG_RASTER_CACHE_SIZE];
+};
+
+static Fl_SVG_Raster_Entry *raster_lru_first = NULL; // most recently used size
+static Fl_SVG_Raster_Entry *raster_lru_last = NULL;  // least recently used size
+static size_t raster_bytes = 0;                           // pixel bytes of all cached sizes
+static size_t raster_budget = FL_SVG_RASTER_CACHE_BUDGET; // largest allowed raster_bytes
+
+#if FL_SVG_THREADS
+static std::mutex raster_cache_mutex;
+#  define LOCK_RASTER_CACHE std::lock_guard<std::mutex> lock(raster_cache_mutex)
+#else
+#  define LOCK_RASTER_CACHE
+#endif
+
+// The functions below that don't lock the mutex must be called with the lock held.
+
+static void raster_lru_unlink(Fl_SVG_Raster_Entry *e) {
+  if (e->prev) e->prev->next = e->next;
+  else raster_lru_first = e->next;
+  if (e->next) e->next->prev = e->prev;
+  else raster_lru_last = e->prev;
+}
+
+static void raster_lru_push_front(Fl_SVG_Raster_Entry *e) {
+  e->prev = NULL;
+  e->next = raster_lru_first;
+  if (raster_lru_first) raster_lru_first->prev = e;
+  else raster_lru_last = e;
+  raster_lru_first = e;
+}
+
+// Moves entry i of a cache to the front of the cache and of the list of all entries
+static void raster_cache_touch(Fl_SVG_Raster_Cache *cache, int i) {
+  Fl_SVG_Raster_Entry *e = cache->entry[i];
+  memmove(cache->entry + 1, cache->entry, i * sizeof(cache->entry[0]));
+  cache->entry[0] = e;
+  raster_lru_unlink(e);
+  raster_lru_push_front(e);
+}
+
+// Removes an entry from its cache and from the list, and frees it
+static void raster_cache_remove(Fl_SVG_Raster_Entry *e) {
+  Fl_SVG_Raster_Cache *cache = e->cache;
+  int i = 0;
+  while (cache->entry[i] != e) i++;
+  cache->count--;
+  memmove(cache->entry + i, cache->entry + i + 1, (cache->count - i) * sizeof(cache->entry[0]));
+  raster_lru_unlink(e);
+  raster_bytes -= (size_t)e->w * e->h * 4;
+  delete[] e->pixels;
+  delete e;
+}
+
+// Drops the least recently used sizes until the cache fits into its budget
+static void raster_cache_trim() {
+  while (raster_bytes > raster_budget && raster_lru_last)
+    raster_cache_remove(raster_lru_last);
+}
+
+// Copies cached pixels of the given size into 'pixels' and returns true if found.
+static bool raster_cache_get(Fl_SVG_Raster_Cache *const &cache, int W, int H, bool proportional,
+                             uchar *pixels) {
+  LOCK_RASTER_CACHE;
+  if (!cache) return false;
+  for (int i = 0; i < cache->count; i++) {
+    const Fl_SVG_Raster_Entry *e = cache->entry[i];
+    if (e->w != W || e->h != H || e->proportional != proportional) continue;
+    memcpy(pixels, e->pixels, (size_t)W * H * 4);
+    raster_cache_touch(cache, i);
+    return true;
+  }
+  return false;
+}
+
+// Adds a copy of rasterized pixels to the cache, dropping the least recently used size
+// of this image, and the least recently used sizes of all images if over budget.
+static void raster_cache_put(Fl_SVG_Raster_Cache *&cache, int W, int H, bool proportional,
+                             const uchar *pixels) {
+  const size_t bytes = (size_t)W * H * 4;
+  if ((size_t)W * H > FL_SVG_RASTER_CACHE_MAX) return;
+  Fl_SVG_Raster_Entry *e = new Fl_SVG_Raster_Entry;
+  e->w = W;
+  e->h = H;
+  e->proportional = proportional;
+  e->pixels = new uchar[bytes];
+  memcpy(e->pixels, pixels, bytes);
+  LOCK_RASTER_CACHE;
+  bool keep = (bytes <= raster_budget);
+  // another thread may have rasterized the same size meanwhile
+  for (int i = 0; keep && cache && i < cache->count; i++) {
+    const Fl_SVG_Raster_Entry *o = cache->entry[i];
+    if (o->w == W && o->h == H && o->proportional == proportional) keep = false;
+  }
+  if (!keep) {
+    delete[] e->pixels;
+    delete e;
+    return;
+  }
+  if (!cache) {
+    cache = new Fl_SVG_Raster_Cache;
+    cache->count = 0;
+  }
+  e->cache = cache;
+  if (cache->count == FL_SVG_RASTER_CACHE_SIZE)
+    raster_cache_remove(cache->entry[cache->count - 1]);
+  memmove(cache->entry + 1, cache->entry, cache->count * sizeof(cache->entry[0]));
+  cache->entry[0] = e;
+  cache->count++;
+  raster_lru_push_front(e);
+  raster_bytes += bytes;
+  raster_cache_trim();
+}
+
+static void raster_cache_delete(Fl_SVG_Raster_Cache *cache) {
+  if (!cache) return;
+  {
+    LOCK_RASTER_CACHE;
+    while (cache->count) raster_cache_remove(cache->entry[0]);
+  }
+  delete cache;
+}
+
+// Each thread uses its own rasterizer, since a rasterizer holds the state of a drawing.
+struct Fl_SVG_Rasterizer {
+  NSVGrasterizer *rast;
+  Fl_SVG_Rasterizer() { rast = nsvgCreateRasterizer(); }
+  ~Fl_SVG_Rasterizer() { nsvgDeleteRasterizer(rast); }
+};
+
+static NSVGrasterizer *svg_rasterizer() {
+  static thread_local Fl_SVG_Rasterizer rasterizer;
+  return rasterizer.rast;
+}
+
 
 /** Load an SVG image from a file.
 
@@ -112,12 +288,13 @@ Fl_SVG_Image::Fl_SVG_Image(const Fl_SVG_Image *source) :
 Fl_SVG_Image::~Fl_SVG_Image() {
   if ( --counted_svg_image_->ref_count <= 0) {
     nsvgDelete(counted_svg_image_->svg_image);
+    raster_cache_delete(counted_svg_image_->raster_cache);
     delete counted_svg_image_;
   }
 }
 
 
-float Fl_SVG_Image::svg_scaling_(int W, int H) {
+float Fl_SVG_Image::svg_scaling_(int W, int H) const {
   float f1 = float(W) / int(counted_svg_image_->svg_image->width+0.5);
   float f2 = float(H) / int(counted_svg_image_->svg_image->height+0.5);
   return (f1 < f2) ? f1 : f2;
@@ -213,6 +390,7 @@ void Fl_SVG_Image::init_(const char *name, const unsigned char *in_data, size_t
   counted_svg_image_ = new counted_NSVGimage;
   counted_svg_image_->svg_image = NULL;
   counted_svg_image_->ref_count = 1;
+  counted_svg_image_->raster_cache = NULL;
   to_desaturate_ = false;
   average_weight_ = 1;
   proportional = true;
@@ -303,8 +481,15 @@ void Fl_SVG_Image::init_(const char *name, const unsigned char *in_data, size_t
 }
 
 
-void Fl_SVG_Image::rasterize_(int W, int H) {
-  static NSVGrasterizer *rasterizer = nsvgCreateRasterizer();
+/*
+  Returns new pixels of the SVG image rasterized to W x H, from the raster
+  cache if possible. This does not change the object and may be called by
+  several threads at once.
+*/
+uchar *Fl_SVG_Image::raster_(int W, int H) const {
+  uchar *pixels = new uchar[(size_t)W * H * 4];
+  if (raster_cache_get(counted_svg_image_->raster_cache, W, H, proportional, pixels))
+    return pixels;
   double fx, fy;
   if (proportional) {
     fx = svg_scaling_(W, H);
@@ -313,8 +498,15 @@ void Fl_SVG_Image::rasterize_(int W, int H) {
     fx = (double)W / counted_svg_image_->svg_image->width;
     fy = (double)H / counted_svg_image_->svg_image->height;
   }
-  array = new uchar[W*H*4];
-  nsvgRasterizeXY(rasterizer, counted_svg_image_->svg_image, 0, 0, float(fx), float(fy), (uchar* )array, W, H, W*4);
+  nsvgRasterizeXY(svg_rasterizer(), counted_svg_image_->svg_image, 0, 0, float(fx), float(fy), pixels, W, H, W*4);
+  raster_cache_put(counted_svg_image_->raster_cache, W, H, proportional, pixels);
+  return pixels;
+}
+
+
+// Makes the image use pixels rasterized to W x H, rasterizing now if pixels is NULL
+void Fl_SVG_Image::rasterize_(int W, int H, uchar *pixels) {
+  array = pixels ? pixels : raster_(W, H);
   alloc_array = 1;
   data((const char * const *)&array, 1);
   d(4);
@@ -345,8 +537,17 @@ Fl_Image *Fl_SVG_Image::copy(int W, int H) const {
  respectively.
  */
 void Fl_SVG_Image::resize(int width, int height) {
+  if (resize_(width, height)) rasterize_(w(), h());
+}
+
+
+/*
+  Sets the image size for resize() and drops the current pixels.
+  Returns true if the image must be rasterized to w() x h().
+*/
+bool Fl_SVG_Image::resize_(int width, int height) {
   if (ld() < 0 || width <= 0 || height <= 0) {
-    return;
+    return false;
   }
   int w1 = width, h1 = height;
   if (proportional) {
@@ -355,13 +556,13 @@ void Fl_SVG_Image::resize(int width, int height) {
     h1 = int( counted_svg_image_->svg_image->height*f + 0.5 );
   }
   w(w1); h(h1);
-  if (rasterized_ && w1 == raster_w_ && h1 == raster_h_) return;
+  if (rasterized_ && w1 == raster_w_ && h1 == raster_h_) return false;
   if (array) {
     delete[] array;
     array = NULL;
   }
   uncache();
-  rasterize_(w1, h1);
+  return true;
 }
 
 
@@ -417,4 +618,125 @@ void Fl_SVG_Image::scale(int w, int h, int keep_aspect, int can_expand) {
   Fl_Image::scale(w, h, keep_aspect, 1);
 }
 
+
+/** Rasterizes many SVG images at once, using several threads if possible.
+
+ Each image is rasterized to the size that draw() would use with the current
+ graphics driver, so that drawing the images does not rasterize them again.
+ Call this after loading many icons, or after the display scale factor has
+ changed, instead of having each image rasterized when it is first drawn.
+
+ Images that share their SVG data because they are copies of each other
+ also share their cache of rasterized sizes.
+
+ This must be called by the main thread.
+
+ \param images  array of SVG images, may contain NULL pointers and duplicates
+ \param count   number of images in the array
+ \since 1.5.0
+ */
+void Fl_SVG_Image::rasterize(Fl_SVG_Image *const *images, int count) {
+  if (count <= 0) return;
+  // Images that are in the array more than once are rasterized once
+  Fl_SVG_Image **list = new Fl_SVG_Image*[count];
+  memcpy(list, images, count * sizeof(Fl_SVG_Image*));
+  std::sort(list, list + count);
+  count = int(std::unique(list, list + count) - list);
+  // Find the images that need rasterizing, and their sizes
+  Fl_SVG_Image **todo = new Fl_SVG_Image*[count];
+  int *sizes = new int[count * 4]; // drawing and raster sizes of each image
+  int n = 0;
+  for (int i = 0; i < count; i++) {
+    Fl_SVG_Image *img = list[i];
+    if (!img || img->ld() < 0) continue;
+    int w1 = img->w(), h1 = img->h();
+    int w2 = w1, h2 = h1;
+    fl_graphics_driver->cache_size(img, w2, h2);
+    if (!img->resize_(w2, h2)) {
+      img->scale(w1, h1, 0, 1);
+      continue;
+    }
+    todo[n] = img;
+    sizes[4*n] = w1; sizes[4*n+1] = h1;
+    sizes[4*n+2] = img->w(); sizes[4*n+3] = img->h();
+    n++;
+  }
+
+  // Rasterize the pixels, in parallel if possible
+  uchar **pixels = new uchar*[n];
+#if FL_SVG_THREADS
+  int nthreads = (int)std::thread::hardware_concurrency();
+  if (nthreads > n / 4) nthreads = n / 4;
+  if (nthreads > 8) nthreads = 8;
+  if (nthreads > 1) {
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+      int i;
+      while ((i = next++) < n) pixels[i] = todo[i]->raster_(sizes[4*i+2], sizes[4*i+3]);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads - 1);
+    try {
+      for (int t = 0; t < nthreads - 1; t++) threads.push_back(std::thread(worker));
+    } catch (const std::system_error &) {
+      // out of threads: the threads that started and this one do all images
+    }
+    try {
+      worker();
+    } catch (...) {
+      for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+      throw;
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+  } else
+#endif // FL_SVG_THREADS
+  for (int i = 0; i < n; i++) pixels[i] = todo[i]->raster_(sizes[4*i+2], sizes[4*i+3]);
+
+  // Finish the images in the main thread
+  for (int i = 0; i < n; i++) {
+    todo[i]->rasterize_(sizes[4*i+2], sizes[4*i+3], pixels[i]);
+    todo[i]->scale(sizes[4*i], sizes[4*i+1], 0, 1);
+  }
+  delete[] pixels;
+  delete[] sizes;
+  delete[] todo;
+  delete[] list;
+}
+
+/** Sets the memory budget of the cache of rasterized SVG image sizes.
+
+ The cache holds a few rasterized sizes of each SVG image, see Fl_SVG_Image.
+ When the pixels of all cached sizes of all SVG images need more than
+ \p bytes, the least recently used sizes are dropped until they fit.
+ The default budget is 32 MB. Setting it to 0 empties the cache and turns
+ it off.
+
+ \param bytes  memory budget in bytes
+ \see raster_cache_bytes()
+ \since 1.5.0
+ */
+void Fl_SVG_Image::raster_cache_budget(size_t bytes) {
+  LOCK_RASTER_CACHE;
+  raster_budget = bytes;
+  raster_cache_trim();
+}
+
+/** Returns the memory budget of the cache of rasterized SVG image sizes.
+ \see raster_cache_budget(size_t)
+ \since 1.5.0
+ */
+size_t Fl_SVG_Image::raster_cache_budget() {
+  LOCK_RASTER_CACHE;
+  return raster_budget;
+}
+
+/** Returns the number of bytes used by all cached rasterized SVG image sizes.
+ \see raster_cache_budget(size_t)
+ \since 1.5.0
+ */
+size_t Fl_SVG_Image::raster_cache_bytes() {
+  LOCK_RASTER_CACHE;
+  return raster_bytes;
+}
+
 #endif // FLTK_USE_SVG
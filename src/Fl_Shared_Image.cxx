@@ -14,6 +14,7 @@
 //     https://www.fltk.org/bugs.php
 //
 
+#include <config.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <FL/fl_utf8.h>
@@ -21,11 +22,24 @@
 
 #include <FL/Fl.H>
 #include <FL/Fl_Shared_Image.H>
+#include <FL/Fl_Widget.H>
+#include <FL/Fl_Widget_Tracker.H>
 #include <FL/Fl_XBM_Image.H>
 #include <FL/Fl_XPM_Image.H>
 #include <FL/Fl_Preferences.H>
 #include <FL/fl_draw.H>
 
+// Background loading uses worker threads where FLTK supports threads,
+// and the idle callback of the main thread otherwise.
+#if defined(HAVE_PTHREAD) || defined(_MSC_VER)
+#  define FL_SHARED_IMAGE_THREADS 1
+#  include <thread>
+#  include <mutex>
+#  include <condition_variable>
+#else
+#  define FL_SHARED_IMAGE_THREADS 0
+#endif
+
 //
 // Global class vars...
 //
@@ -38,20 +52,21 @@ Fl_Shared_Handler *Fl_Shared_Image::handlers_ = 0;// Additional format handlers
 int     Fl_Shared_Image::num_handlers_ = 0;     // Number of format handlers
 int     Fl_Shared_Image::alloc_handlers_ = 0;   // Allocated format handlers
 
-
-//
-// Typedef the C API sort function type the only way I know how...
-//
-
-extern "C" {
-  typedef int (*compare_func_t)(const void *, const void *);
-}
+Fl_Shared_Image **Fl_Shared_Image::hash_ = 0;   // Hash table of shared images
+int     Fl_Shared_Image::hash_size_ = 0;        // Number of hash buckets
+Fl_Shared_Image *Fl_Shared_Image::lru_first_ = 0; // Most recently released unused image
+Fl_Shared_Image *Fl_Shared_Image::lru_last_ = 0; // Least recently released unused image
+size_t  Fl_Shared_Image::cache_budget_ = 0;     // Bytes to keep for unused images
+size_t  Fl_Shared_Image::cache_bytes_ = 0;      // Bytes used by all shared images
+unsigned long Fl_Shared_Image::cache_hits_ = 0;      // get() calls found in cache
+unsigned long Fl_Shared_Image::cache_misses_ = 0;    // get() calls not in cache
+unsigned long Fl_Shared_Image::cache_evictions_ = 0; // Unused images destroyed
 
 
 /**
  Returns the Fl_Shared_Image* array.
 
- \return a pointer to an array of shared image pointers, sorted by name and size
+ \return a pointer to an array of shared image pointers in no particular order
  \see Fl_Shared_Image::num_images()
  */
 Fl_Shared_Image **Fl_Shared_Image::images() {
@@ -71,20 +86,15 @@ int Fl_Shared_Image::num_images() {
 /**
   Compares two shared images.
 
+  \note The image pool is no longer sorted, this function is kept for
+    subclasses that want to sort a copy of the images() array.
+
   The order of comparison is:
 
     -# Image name, usually the filename used to load it
     -# Image width
     -# Image height
 
-  Binary search in a sorted array works only if we search for the same
-  parameters that were also used for sorting. No special cases are possible
-  here.
-
-  Fl_Shared_Image::find() requires a search for an element with a matching name
-  and the original_ flags set. This is not implemented via binary search, but
-  by a simple run of the array inside Fl_Shared_Image::find().
-
   \param[in] i0, i1 image pointer pointer for sorting
   \returns      Whether the images match or their relative sort order (see text).
   \retval       0       the images match
@@ -117,6 +127,13 @@ Fl_Shared_Image::Fl_Shared_Image() : Fl_Image(0,0,0) {
   original_    = 0;
   image_       = 0;
   alloc_image_ = 0;
+  index_       = -1;
+  hash_key_    = 0;
+  bytes_       = 0;
+  hash_next_   = 0;
+  lru_prev_    = 0;
+  lru_next_    = 0;
+  load_job_    = 0;
 }
 
 
@@ -140,18 +157,65 @@ Fl_Shared_Image::Fl_Shared_Image(const char *n,
   image_       = img;
   alloc_image_ = !img;
   original_    = 1;
+  index_       = -1;
+  hash_key_    = 0;
+  bytes_       = 0;
+  hash_next_   = 0;
+  lru_prev_    = 0;
+  lru_next_    = 0;
+  load_job_    = 0;
 
   if (!img) reload();
   else update();
 }
 
+/*
+  Returns the hash value of an image name (FNV-1a).
+*/
+unsigned Fl_Shared_Image::hash_name_(const char *name) {
+  unsigned h = 2166136261U;
+  if (name) {
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+      h ^= *p;
+      h *= 16777619U;
+    }
+  }
+  return h;
+}
+
+/*
+  Rebuilds the hash table with the given number of buckets.
+  The size must be a power of 2.
+*/
+void Fl_Shared_Image::rehash_(int size) {
+  delete[] hash_;
+  hash_      = new Fl_Shared_Image *[size];
+  hash_size_ = size;
+  memset(hash_, 0, size * sizeof(Fl_Shared_Image *));
+
+  for (int i = 0; i < num_images_; i ++) {
+    Fl_Shared_Image *img = images_[i];
+    Fl_Shared_Image **bucket = hash_ + (img->hash_key_ & (hash_size_ - 1));
+    img->hash_next_ = *bucket;
+    *bucket = img;
+  }
+}
+
+/*
+  Returns the approximate number of bytes used by an image.
+*/
+static size_t image_bytes(const Fl_Image *img) {
+  if (!img) return 0;
+  int d = img->d() > 0 ? img->d() : 1;
+  return (size_t)img->data_w() * img->data_h() * d;
+}
+
 /**
   Adds a shared image to the image pool.
 
-  This \b protected method adds an image to the pool, an ordered list
-  of shared images. The pool is searched for a matching image whenever
-  one is requested, for instance with Fl_Shared_Image::get() or
-  Fl_Shared_Image::find().
+  This \b protected method adds an image to the pool of shared images.
+  The pool is searched for a matching image whenever one is requested,
+  for instance with Fl_Shared_Image::get() or Fl_Shared_Image::find().
 
  This method does not increase or decrease reference counts!
 */
@@ -159,9 +223,12 @@ void
 Fl_Shared_Image::add() {
   Fl_Shared_Image       **temp;         // New image pointer array...
 
+  if (index_ >= 0) return;
+
   if (num_images_ >= alloc_images_) {
     // Allocate more memory...
-    temp = new Fl_Shared_Image *[alloc_images_ + 32];
+    int size = alloc_images_ ? alloc_images_ * 2 : 32;
+    temp = new Fl_Shared_Image *[size];
 
     if (alloc_images_) {
       memcpy(temp, images_, alloc_images_ * sizeof(Fl_Shared_Image *));
@@ -170,18 +237,130 @@ Fl_Shared_Image::add() {
     }
 
     images_       = temp;
-    alloc_images_ += 32;
+    alloc_images_ = size;
   }
 
+  hash_key_ = hash_name_(name_);
+  index_    = num_images_;
   images_[num_images_] = this;
   num_images_ ++;
 
-  if (num_images_ > 1) {
-    qsort(images_, num_images_, sizeof(Fl_Shared_Image *),
-          (compare_func_t)compare);
+  if (num_images_ > hash_size_) {
+    rehash_(hash_size_ ? hash_size_ * 2 : 64);
+  } else {
+    Fl_Shared_Image **bucket = hash_ + (hash_key_ & (hash_size_ - 1));
+    hash_next_ = *bucket;
+    *bucket = this;
+  }
+
+  bytes_ = image_bytes(image_);
+  cache_bytes_ += bytes_;
+  trim_cache_();
+}
+
+/*
+  Removes a shared image from the image pool without deleting it.
+*/
+void Fl_Shared_Image::remove_() {
+  if (index_ < 0) return;
+
+  Fl_Shared_Image **p = hash_ + (hash_key_ & (hash_size_ - 1));
+  while (*p != this) p = &(*p)->hash_next_;
+  *p = hash_next_;
+  hash_next_ = 0;
+
+  lru_remove_();
+
+  num_images_ --;
+  if (index_ < num_images_) {
+    images_[index_] = images_[num_images_];
+    images_[index_]->index_ = index_;
+  }
+  index_ = -1;
+
+  cache_bytes_ -= bytes_;
+  bytes_ = 0;
+
+  if (num_images_ == 0 && images_) {
+    delete[] images_;
+    delete[] hash_;
+
+    images_       = 0;
+    alloc_images_ = 0;
+    hash_         = 0;
+    hash_size_    = 0;
+  }
+}
+
+/*
+  Puts an unused image at the head of the list of cached unused images.
+*/
+void Fl_Shared_Image::lru_insert_() {
+  lru_prev_ = 0;
+  lru_next_ = lru_first_;
+  if (lru_first_) lru_first_->lru_prev_ = this;
+  else lru_last_ = this;
+  lru_first_ = this;
+}
+
+/*
+  Removes an image from the list of cached unused images, if it is there.
+*/
+void Fl_Shared_Image::lru_remove_() {
+  if (!lru_prev_ && lru_first_ != this) return;
+  if (lru_prev_) lru_prev_->lru_next_ = lru_next_;
+  else lru_first_ = lru_next_;
+  if (lru_next_) lru_next_->lru_prev_ = lru_prev_;
+  else lru_last_ = lru_prev_;
+  lru_prev_ = lru_next_ = 0;
+}
+
+/*
+  Destroys the least recently released unused images until the pool
+  fits into the cache budget or no unused images are left.
+*/
+void Fl_Shared_Image::trim_cache_() {
+  while (cache_bytes_ > cache_budget_ && lru_last_) {
+    Fl_Shared_Image *img = lru_last_;
+    img->remove_();
+    delete img;
+    cache_evictions_ ++;
   }
 }
 
+/**
+  Sets the memory budget for unused shared images.
+
+  By default the budget is 0 and an image is destroyed as soon as it is
+  released for the last time. If the budget is larger than 0, released
+  images stay in the cache, so a later Fl_Shared_Image::get() or
+  Fl_Shared_Image::find() can return them without loading the file again.
+  When the memory used by all shared images exceeds the budget, the least
+  recently released unused images are destroyed until it fits again.
+  Images in use are never destroyed.
+
+  Setting the budget to 0 destroys all unused images immediately.
+
+  \param[in] bytes  memory budget in bytes
+  \see cache_budget(), cache_bytes()
+  \since 1.5.0
+*/
+void Fl_Shared_Image::cache_budget(size_t bytes) {
+  cache_budget_ = bytes;
+  trim_cache_();
+}
+
+/**
+  Resets the cache statistics returned by cache_hits(), cache_misses(),
+  and cache_evictions() to zero.
+  \since 1.5.0
+*/
+void Fl_Shared_Image::reset_cache_stats() {
+  cache_hits_      = 0;
+  cache_misses_    = 0;
+  cache_evictions_ = 0;
+}
+
 /**
  Update the dimensions of the shared images.
 
@@ -196,6 +375,11 @@ Fl_Shared_Image::update() {
     d(image_->d());
     data(image_->data(), image_->count());
     if (W && H) scale(W, H, 0, 1);
+    if (index_ >= 0) {
+      cache_bytes_ -= bytes_;
+      bytes_ = image_bytes(image_);
+      cache_bytes_ += bytes_;
+    }
   }
 }
 
@@ -207,6 +391,7 @@ Fl_Shared_Image::update() {
   Use the Fl_Shared_Image::release() method instead.
 */
 Fl_Shared_Image::~Fl_Shared_Image() {
+  if (load_job_) cancel_load_();
   if (name_) delete[] (char *)name_;
   if (alloc_image_) delete image_;
 }
@@ -214,11 +399,12 @@ Fl_Shared_Image::~Fl_Shared_Image() {
 /**
   Releases and possibly destroys (if refcount <= 0) a shared image.
 
-  In the latter case, it will reorganize the shared image array
-  so that no hole will occur.
+  If a cache budget is set, an image that is no longer referenced is kept
+  in the cache and destroyed later, when the budget is exceeded.
+
+  \see cache_budget(size_t)
 */
 void Fl_Shared_Image::release() {
-  int   i;      // Looping var...
   Fl_Shared_Image *the_original = NULL;
 
 #ifdef SHIM_DEBUG
@@ -241,26 +427,13 @@ void Fl_Shared_Image::release() {
     }
   }
 
-  for (i = 0; i < num_images_; i ++) {
-    if (images_[i] == this) {
-      num_images_ --;
-
-      if (i < num_images_) {
-        memmove(images_ + i, images_ + i + 1,
-                (num_images_ - i) * sizeof(Fl_Shared_Image *));
-      }
-
-      break;
-    }
-  }
-
-  delete this;
-
-  if (num_images_ == 0 && images_) {
-    delete[] images_;
-
-    images_       = 0;
-    alloc_images_ = 0;
+  // Keep unused images that we own in the cache if there is a budget,
+  // otherwise remove them from the pool and destroy them now.
+  if (cache_budget_ && index_ >= 0 && alloc_image_) {
+    lru_insert_();
+  } else {
+    remove_();
+    delete this;
   }
 #ifdef SHIM_DEBUG
   printf("<---- Fl_Shared_Image::release() %d %s %d %d\n", original_, name_, w(), h());
@@ -271,41 +444,55 @@ void Fl_Shared_Image::release() {
   // Release one reference count in the original image as well.
   if (the_original)
     the_original->release();
+
+  trim_cache_();
 }
 
-/** Reloads the shared image from disk. */
-void Fl_Shared_Image::reload() {
-  // Load image from disk...
+/*
+  Loads an image file with the first handler that recognizes it.
+
+  This does not access the image pool and is also called by the worker
+  threads of get_async().
+*/
+Fl_Image *Fl_Shared_Image::load_(const char *name) {
   int           i;              // Looping var
   int           count = 0;      // number of bytes read from image header
   FILE          *fp;            // File pointer
   uchar         header[64];     // Buffer for auto-detecting files
   Fl_Image      *img;           // New image
 
-  if (!name_) return;
-
-  if ((fp = fl_fopen(name_, "rb")) != NULL) {
+  if ((fp = fl_fopen(name, "rb")) != NULL) {
     count = (int)fread(header, 1, sizeof(header), fp);
     fclose(fp);
     if (count == 0)
-      return;
+      return 0;
   } else {
-    return;
+    return 0;
   }
 
   // Load the image as appropriate...
   if (count >= 7 && memcmp(header, "#define", 7) == 0) // XBM file
-    img = new Fl_XBM_Image(name_);
+    img = new Fl_XBM_Image(name);
   else if (count >= 9 && memcmp(header, "/* XPM */", 9) == 0) // XPM file
-    img = new Fl_XPM_Image(name_);
+    img = new Fl_XPM_Image(name);
   else {
     // Not a standard format; try an image handler...
     for (i = 0, img = 0; i < num_handlers_; i ++) {
-      img = (handlers_[i])(name_, header, count);
+      img = (handlers_[i])(name, header, count);
       if (img) break;
     }
   }
 
+  return img;
+}
+
+/** Reloads the shared image from disk. */
+void Fl_Shared_Image::reload() {
+  if (!name_) return;
+
+  // Load image from disk...
+  Fl_Image *img = load_(name_);
+
   if (img) {
     if (alloc_image_) delete image_;
 
@@ -467,7 +654,7 @@ void Fl_Shared_Image::uncache()
 
 /** Finds a shared image from its name and size specifications.
 
-  This uses a binary search in the image cache.
+  This uses a hash table lookup in the image cache.
 
   If the image \p name exists with the exact width \p W and height \p H,
   then it is returned.
@@ -496,47 +683,39 @@ void Fl_Shared_Image::uncache()
   marked \p original with the same name, regardless of width and height.
 */
 Fl_Shared_Image* Fl_Shared_Image::find(const char *name, int W, int H) {
-  if (num_images_) {
+  if (!num_images_ || !name) return NULL;
+
+  // All sizes of an image share the same hash bucket, since the hash
+  // only depends on the name.
+  unsigned key = hash_name_(name);
+  Fl_Shared_Image *img;
+  for (img = hash_[key & (hash_size_ - 1)]; img; img = img->hash_next_) {
+    if (img->hash_key_ != key || !img->name_ || strcmp(img->name_, name))
+      continue;
     if (W) {
-      Fl_Shared_Image *key;     // Image key
-      Fl_Shared_Image **match;  // Matching image
-
-      key = new Fl_Shared_Image();
-      key->name_ = new char[strlen(name) + 1];
-      strcpy((char *)key->name_, name);
-      key->w(W);
-      key->h(H);
-
-      match = (Fl_Shared_Image **)bsearch(&key, images_, num_images_,
-                                          sizeof(Fl_Shared_Image *),
-                                          (compare_func_t)compare);
-
-      delete key;
-
-      if (match) {
-        (*match)->refcount_ ++;
-        return *match;
-      }
-    } else {
-      // if no width was given we need to find the original. The list is sorted
-      // by name, width, and height, but we need to find the item by name with
-      // the original_ flags set, no matter how wide, so binary search does not
-      // work here.
-      int i;
-      for (i = 0; i < num_images_; ++i) {
-        // If there are thousands of images and running the array becomes
-        // inefficient, we can hand implement a binary search by name, and then
-        // search back and forth from that location for the member with the
-        // original_ flag set.
-        Fl_Shared_Image *img = images_[i];
-        if (img->original_ && img->name_ && (strcmp(img->name_, name) == 0)) {
-          img->refcount_++;
-          return img;
-        }
-      }
+      if (img->data_w() == W && img->data_h() == H) break;
+    } else if (img->original_) {
+      break;
     }
   }
-  return NULL;
+  if (!img) return NULL;
+
+  if (img->refcount_ <= 0) {
+    // Reuse an unused image from the cache. A resized copy holds a
+    // reference to its original, which may have been destroyed already.
+    if (!img->original_ && !find(name)) {
+      img->remove_();
+      delete img;
+      cache_evictions_ ++;
+      return NULL;
+    }
+    img->lru_remove_();
+    img->refcount_ = 1;
+    return img;
+  }
+
+  img->refcount_ ++;
+  return img;
 }
 
 /**
@@ -582,11 +761,29 @@ Fl_Shared_Image* Fl_Shared_Image::get(const char *name, int W, int H) {
 
   // Find an image by the requested size
   // ::find() increments the ref count for us
-  if ((temp = find(name, W, H)) != NULL)
+  if ((temp = find(name, W, H)) != NULL) {
+    cache_hits_ ++;
+    // Finish a pending get_async() now, since the caller needs the data
+    if (temp->load_job_) {
+      temp->finish_load_();
+      if (!temp->image_) {
+        temp->release();
+        return NULL;
+      }
+    }
     return temp;
+  }
+  cache_misses_ ++;
 
   // Find the original image, size does not matter
   temp = find(name);
+  if (temp && temp->load_job_) {
+    temp->finish_load_();
+    if (!temp->image_) {
+      temp->release();
+      return NULL;
+    }
+  }
   if (temp) {
     temp_referenced = true;
   } else {
@@ -634,6 +831,401 @@ Fl_Shared_Image *Fl_Shared_Image::get(Fl_RGB_Image *rgb, int own_it)
   return shared;
 }
 
+//
+// Background loading for get_async()...
+//
+// Jobs are queued by the main thread and decoded by a small pool of worker
+// threads. A worker only calls load_() and never touches the image pool or
+// any widget. Finished jobs are handed back with Fl::awake(), and the main
+// thread swaps the decoded image into the placeholder. Without thread
+// support the jobs are loaded one at a time from an idle callback.
+//
+
+struct Fl_Shared_Image_Job {
+  char                  *name;          // File name to load
+  int                   priority;       // Jobs with higher priority run first
+  int                   state;          // QUEUED, RUNNING, or DONE
+  Fl_Image              *result;        // Decoded image, or NULL
+  Fl_Shared_Image       *owner;         // Placeholder image, NULL if cancelled
+  Fl_Widget_Tracker     **widgets;      // Widgets to redraw when done
+  int                   num_widgets;    // Number of widgets
+  Fl_Shared_Image_Job   *next;          // Next job in the queue or done list
+
+  enum { QUEUED, RUNNING, DONE };
+
+  Fl_Shared_Image_Job(const char *n, int p);
+  ~Fl_Shared_Image_Job();
+  void add_widget(Fl_Widget *w);
+  void redraw_widgets();
+  void finish();
+
+  static void start(Fl_Shared_Image_Job *job);
+  static void cancel(Fl_Shared_Image_Job *job);
+  static Fl_Shared_Image_Job *next_job();
+  static void run(Fl_Shared_Image_Job *job);
+  static void done_cb(void *);
+#if FL_SHARED_IMAGE_THREADS
+  static void worker();
+  static void stop_workers();
+  static void poll_cb(void *);
+#else
+  static void idle_cb(void *);
+#endif
+};
+
+static Fl_Shared_Image_Job *load_queue = 0;     // Queued and running jobs
+static Fl_Shared_Image_Job *load_done = 0;      // Jobs waiting for the main thread
+static Fl_Shared_Image_Job *load_done_last = 0; // Last job in load_done
+static int load_jobs = 0;                       // Jobs not yet deleted (main thread)
+
+#if FL_SHARED_IMAGE_THREADS
+static const int LOAD_THREADS = 2;              // Number of worker threads
+static std::thread *load_threads = 0;           // The worker threads
+static bool load_stop = false;                  // Tells the workers to exit
+static std::mutex *load_mutex = 0;
+static std::condition_variable *load_cond = 0;
+static void lock_jobs() { load_mutex->lock(); }
+static void unlock_jobs() { load_mutex->unlock(); }
+#else
+static void lock_jobs() {}
+static void unlock_jobs() {}
+#endif
+
+Fl_Shared_Image_Job::Fl_Shared_Image_Job(const char *n, int p) {
+  name        = new char[strlen(n) + 1];
+  strcpy(name, n);
+  priority    = p;
+  state       = QUEUED;
+  result      = 0;
+  owner       = 0;
+  widgets     = 0;
+  num_widgets = 0;
+  next        = 0;
+}
+
+Fl_Shared_Image_Job::~Fl_Shared_Image_Job() {
+  for (int i = 0; i < num_widgets; i ++) delete widgets[i];
+  delete[] widgets;
+  delete[] name;
+  delete result;
+}
+
+/*
+  Adds a widget that is redrawn when the image has been loaded.
+  Widgets are tracked, so they may be deleted before that.
+*/
+void Fl_Shared_Image_Job::add_widget(Fl_Widget *w) {
+  if (!w) return;
+  for (int i = 0; i < num_widgets; i ++)
+    if (widgets[i]->widget() == w) return;
+  Fl_Widget_Tracker **temp = new Fl_Widget_Tracker *[num_widgets + 1];
+  if (num_widgets) memcpy(temp, widgets, num_widgets * sizeof(Fl_Widget_Tracker *));
+  delete[] widgets;
+  widgets = temp;
+  widgets[num_widgets ++] = new Fl_Widget_Tracker(w);
+}
+
+void Fl_Shared_Image_Job::redraw_widgets() {
+  for (int i = 0; i < num_widgets; i ++)
+    if (widgets[i]->exists()) widgets[i]->widget()->redraw();
+}
+
+/*
+  Swaps the decoded image into the placeholder (main thread only).
+  A placeholder that could not be loaded is removed from the pool, so
+  that the next request tries to load the file again.
+*/
+void Fl_Shared_Image_Job::finish() {
+  Fl_Shared_Image *img = owner;
+  if (!img) return;
+  img->load_job_ = 0;
+  owner = 0;
+  if (result) {
+    img->image_       = result;
+    img->alloc_image_ = 1;
+    result = 0;
+    img->update();
+    Fl_Shared_Image::trim_cache_();
+  } else {
+    img->remove_();
+  }
+  redraw_widgets();
+}
+
+/*
+  Queues a new job (main thread only).
+*/
+void Fl_Shared_Image_Job::start(Fl_Shared_Image_Job *job) {
+#if FL_SHARED_IMAGE_THREADS
+  if (!load_threads) {
+    if (!load_mutex) {
+      load_mutex = new std::mutex;
+      load_cond  = new std::condition_variable;
+      atexit(stop_workers);
+    }
+    // Let the main thread set up the awake queue before any worker uses it
+    Fl::awake_once(done_cb);
+    load_stop = false;
+    load_threads = new std::thread[LOAD_THREADS];
+    for (int i = 0; i < LOAD_THREADS; i ++)
+      load_threads[i] = std::thread(worker);
+  }
+  // Fl::awake() does not wake up the main thread unless the program
+  // called Fl::lock(), so we also poll while jobs are pending.
+  if (!load_jobs) Fl::add_timeout(0.05, poll_cb);
+#else
+  if (!load_jobs) Fl::add_idle(idle_cb);
+#endif
+  load_jobs ++;
+
+  lock_jobs();
+  job->next  = load_queue;
+  load_queue = job;
+  unlock_jobs();
+#if FL_SHARED_IMAGE_THREADS
+  load_cond->notify_one();
+#endif
+}
+
+/*
+  Detaches a job from its placeholder image (main thread only).
+  A queued job is deleted right away, a running job is deleted after
+  the worker is done with it.
+*/
+void Fl_Shared_Image_Job::cancel(Fl_Shared_Image_Job *job) {
+  lock_jobs();
+  job->owner = 0;
+  if (job->state == QUEUED) {
+    Fl_Shared_Image_Job **p = &load_queue;
+    while (*p != job) p = &(*p)->next;
+    *p = job->next;
+  } else {
+    job = 0;
+  }
+  unlock_jobs();
+  if (job) {
+    delete job;
+    load_jobs --;
+  }
+}
+
+/*
+  Removes and returns the queued job with the highest priority, or NULL.
+  Jobs with the same priority are loaded in the order they were requested.
+  The caller must hold the job lock.
+*/
+Fl_Shared_Image_Job *Fl_Shared_Image_Job::next_job() {
+  Fl_Shared_Image_Job **best = 0;
+  for (Fl_Shared_Image_Job **p = &load_queue; *p; p = &(*p)->next) {
+    if ((*p)->state == QUEUED && (!best || (*p)->priority >= (*best)->priority))
+      best = p;
+  }
+  if (!best) return 0;
+  Fl_Shared_Image_Job *job = *best;
+  job->state = RUNNING;
+  return job;
+}
+
+/*
+  Loads the file of a running job and moves it to the done list.
+*/
+void Fl_Shared_Image_Job::run(Fl_Shared_Image_Job *job) {
+  Fl_Image *img = Fl_Shared_Image::load_(job->name);
+
+  lock_jobs();
+  job->result = img;
+  job->state  = DONE;
+  Fl_Shared_Image_Job **p = &load_queue;
+  while (*p != job) p = &(*p)->next;
+  *p = job->next;
+  job->next = 0;
+  if (load_done_last) load_done_last->next = job;
+  else load_done = job;
+  load_done_last = job;
+  unlock_jobs();
+}
+
+/*
+  Finishes all jobs in the done list (main thread only).
+*/
+void Fl_Shared_Image_Job::done_cb(void *) {
+  lock_jobs();
+  Fl_Shared_Image_Job *job = load_done;
+  load_done = load_done_last = 0;
+  unlock_jobs();
+
+  while (job) {
+    Fl_Shared_Image_Job *next = job->next;
+    job->finish();
+    delete job;
+    load_jobs --;
+    job = next;
+  }
+}
+
+#if FL_SHARED_IMAGE_THREADS
+
+void Fl_Shared_Image_Job::worker() {
+  for (;;) {
+    Fl_Shared_Image_Job *job = 0;
+    {
+      std::unique_lock<std::mutex> lock(*load_mutex);
+      while (!load_stop && (job = next_job()) == 0) load_cond->wait(lock);
+      if (!job) return;
+    }
+    run(job);
+    Fl::awake_once(done_cb);
+  }
+}
+
+/*
+  Stops the worker threads when the program exits (main thread only).
+  Images that are being decoded are finished first, queued jobs stay
+  queued and are picked up by new workers if start() is called again.
+*/
+void Fl_Shared_Image_Job::stop_workers() {
+  if (!load_threads) return;
+  lock_jobs();
+  load_stop = true;
+  unlock_jobs();
+  load_cond->notify_all();
+  for (int i = 0; i < LOAD_THREADS; i ++) load_threads[i].join();
+  delete[] load_threads;
+  load_threads = 0;
+}
+
+void Fl_Shared_Image_Job::poll_cb(void *) {
+  done_cb(0);
+  if (load_jobs) Fl::repeat_timeout(0.05, poll_cb);
+}
+
+#else
+
+void Fl_Shared_Image_Job::idle_cb(void *) {
+  Fl_Shared_Image_Job *job = next_job();
+  if (job) run(job);
+  done_cb(0);
+  if (!load_jobs) Fl::remove_idle(idle_cb);
+}
+
+#endif // FL_SHARED_IMAGE_THREADS
+
+/**
+  Starts loading an image in the background and returns a placeholder.
+
+  This is like get(const char *name, int W, int H) without a size, but it
+  does not wait for the image file to be decoded. If the image is not in
+  the cache yet, an empty placeholder image is added to the cache and
+  returned right away, and the file is decoded by a worker thread. When
+  decoding is complete, the main thread swaps the image data into the
+  placeholder and redraws \p widget. Until then loading() returns non-zero
+  and w() and h() are 0, unless the drawing size was set with scale().
+
+  If the image is requested again while it is loading, the same placeholder
+  is returned and \p widget is added to the widgets that will be redrawn.
+  Calling get() for an image that is loading decodes it immediately.
+
+  Images with a higher \p priority are loaded first, for instance images
+  that are currently visible. The priority can be changed later with
+  load_priority(). Releasing the placeholder before the image has been
+  loaded cancels loading.
+
+  Image handlers are called from the worker threads and must not be added
+  or removed while images are loading. The main thread is woken up with
+  Fl::awake() when an image has been decoded, which requires that the
+  program called Fl::lock() once; otherwise finished images are picked up
+  within a fraction of a second. On platforms without thread support in
+  FLTK the images are loaded from an idle callback of the main thread.
+
+  \param[in] name      name of the image file
+  \param[in] widget    widget to redraw when the image has been loaded, or NULL
+  \param[in] priority  loading priority, higher values are loaded first
+  \return the shared image, or NULL if \p name is NULL
+
+  \see loading()
+  \see load_priority(int)
+  \since 1.5.0
+*/
+Fl_Shared_Image *Fl_Shared_Image::get_async(const char *name, Fl_Widget *widget,
+                                            int priority) {
+  if (!name) return NULL;
+
+  Fl_Shared_Image *img = find(name);
+  if (img) {
+    cache_hits_ ++;
+    if (img->load_job_) {
+      img->load_job_->add_widget(widget);
+      if (priority > img->load_job_->priority) img->load_priority(priority);
+    }
+    return img;
+  }
+  cache_misses_ ++;
+
+  img = new Fl_Shared_Image();
+  img->name_ = new char[strlen(name) + 1];
+  strcpy((char *)img->name_, name);
+  img->original_ = 1;
+  img->add();
+
+  Fl_Shared_Image_Job *job = new Fl_Shared_Image_Job(name, priority);
+  job->owner = img;
+  job->add_widget(widget);
+  img->load_job_ = job;
+  Fl_Shared_Image_Job::start(job);
+  return img;
+}
+
+/**
+  Changes the loading priority of an image requested with get_async().
+
+  Images with a higher priority are loaded first. This has no effect if
+  the image is not loading, or if a worker thread is already decoding it.
+
+  \param[in] priority  new loading priority
+  \since 1.5.0
+*/
+void Fl_Shared_Image::load_priority(int priority) {
+  if (!load_job_) return;
+  lock_jobs();
+  load_job_->priority = priority;
+  unlock_jobs();
+}
+
+/*
+  Stops loading the image in the background (main thread only).
+*/
+void Fl_Shared_Image::cancel_load_() {
+  Fl_Shared_Image_Job *job = load_job_;
+  load_job_ = 0;
+  if (job) Fl_Shared_Image_Job::cancel(job);
+}
+
+/*
+  Loads an image that is loading in the background right now and redraws
+  the widgets waiting for it. If the file can't be loaded, the image is
+  removed from the pool.
+*/
+void Fl_Shared_Image::finish_load_() {
+  Fl_Shared_Image_Job *job = load_job_;
+  if (!job) return;
+
+  // Keep the widgets to redraw, the job may be deleted by cancel_load_()
+  Fl_Widget_Tracker **widgets = job->widgets;
+  int num_widgets = job->num_widgets;
+  job->widgets = 0;
+  job->num_widgets = 0;
+  cancel_load_();
+
+  reload();
+  if (!image_) remove_();
+
+  for (int i = 0; i < num_widgets; i ++) {
+    if (widgets[i]->exists()) widgets[i]->widget()->redraw();
+    delete widgets[i];
+  }
+  delete[] widgets;
+}
+
 /** Adds a shared image handler, which is basically a test function
   for adding new image formats.
 
@@ -646,6 +1238,10 @@ Fl_Shared_Image *Fl_Shared_Image::get(Fl_RGB_Image *rgb, int own_it)
   handlers - unless you need to override a known image file type which
   should be rare.
 
+  Handlers are called from worker threads for images requested with
+  get_async(), so they must be thread-safe. Handlers must not be added
+  or removed while images are loading in the background.
+
   \see Fl_Shared_Handler for more information of the function you need
     to define.
 */
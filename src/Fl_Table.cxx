@@ -25,6 +25,145 @@
 #include <stdio.h>              // fprintf
 #include <stdlib.h>             // realloc/free
 
+// Row heights or column widths of a table, with prefix sums to find the
+// position of a row and the row at a position in O(log n).
+//
+// As long as all sizes are the same, only that size is stored. Otherwise
+// each size is stored, and the sums of blocks of BLOCK sizes are kept in
+// a Fenwick tree: positions are found by descending the tree to a block,
+// then adding the sizes within that block.
+//
+struct Fl_Table_Sizes {
+  enum { BLOCK = 32 };
+  int n;                        // number of sizes
+  int uniform;                  // the size of all entries if 'sizes' is empty
+  std::vector<int> sizes;       // each size, or empty if all are 'uniform'
+  std::vector<long> tree;       // Fenwick tree of the block sums, 1 based
+
+  Fl_Table_Sizes() : n(0), uniform(0) { }
+  int count() const { return n; }
+  int get(int i) const { return sizes.empty() ? uniform : sizes[i]; }
+  void fill(int size);
+  void resize(int count, int size);
+  void set(int i, int size);
+  long position(int i) const;
+  int find(long pos) const;
+
+private:
+  static int blocks(int count) { return (count + BLOCK - 1) / BLOCK; }
+  long block_sums(int b) const;
+  void add(int b, long delta);
+  void build();
+};
+
+// Sum of the blocks before block 'b'
+long Fl_Table_Sizes::block_sums(int b) const {
+  long sum = 0;
+  for ( ; b > 0; b -= b & -b ) sum += tree[b];
+  return sum;
+}
+
+// Adds 'delta' to the sum of block 'b'
+void Fl_Table_Sizes::add(int b, long delta) {
+  int nb = blocks(n);
+  for ( b++; b <= nb; b += b & -b ) tree[b] += delta;
+}
+
+// Switches to one size per entry and builds the tree
+void Fl_Table_Sizes::build() {
+  if ( sizes.empty() ) sizes.assign(n, uniform);
+  int nb = blocks(n);
+  tree.assign(nb + 1, 0);
+  for ( int i = 0; i < n; i++ ) tree[i / BLOCK + 1] += sizes[i];
+  for ( int b = 1; b <= nb; b++ ) {
+    int parent = b + (b & -b);
+    if ( parent <= nb ) tree[parent] += tree[b];
+  }
+}
+
+// Sets all sizes to 'size', and frees the per entry storage
+void Fl_Table_Sizes::fill(int size) {
+  std::vector<int>().swap(sizes);
+  std::vector<long>().swap(tree);
+  uniform = size;
+}
+
+// Changes the number of entries, new entries get 'size'
+void Fl_Table_Sizes::resize(int count, int size) {
+  if ( count < 0 ) count = 0;
+  if ( sizes.empty() ) {
+    if ( n == 0 ) uniform = size;
+    if ( count <= n || size == uniform ) { n = count; return; }
+    build();
+  }
+  int oldn = n, oldnb = blocks(n), nb = blocks(count);
+  if ( count < oldn ) {
+    long removed = 0;           // sizes dropped from the new last block
+    for ( int i = count; i < nb * BLOCK && i < oldn; i++ ) removed += sizes[i];
+    sizes.resize(count);
+    tree.resize(nb + 1);
+    n = count;
+    if ( removed ) add(nb - 1, -removed);
+    if ( n == 0 ) fill(uniform);
+    return;
+  }
+  sizes.resize(count, size);
+  tree.resize(nb + 1, 0);
+  n = count;
+  int fill_end = oldnb * BLOCK < n ? oldnb * BLOCK : n;
+  if ( fill_end > oldn )        // new sizes in the old last block
+    add(oldnb - 1, (long)(fill_end - oldn) * size);
+  for ( int b = oldnb; b < nb; b++ ) {          // append new blocks to the tree
+    int end = (b + 1) * BLOCK < n ? (b + 1) * BLOCK : n;
+    int j = b + 1;
+    tree[j] = (long)(end - b * BLOCK) * size + block_sums(j - 1) - block_sums(j - (j & -j));
+  }
+}
+
+// Sets the size of entry 'i'
+void Fl_Table_Sizes::set(int i, int size) {
+  if ( sizes.empty() ) {
+    if ( size == uniform ) return;
+    build();
+  }
+  long delta = (long)size - sizes[i];
+  sizes[i] = size;
+  if ( delta ) add(i / BLOCK, delta);
+}
+
+// Returns the sum of the sizes of the entries before 'i'
+long Fl_Table_Sizes::position(int i) const {
+  if ( i <= 0 ) return 0;
+  if ( i > n ) i = n;
+  if ( sizes.empty() ) return (long)i * uniform;
+  int b = i / BLOCK;
+  long pos = block_sums(b);
+  for ( int k = b * BLOCK; k < i; k++ ) pos += sizes[k];
+  return pos;
+}
+
+// Returns the last entry 'i' with position(i) <= 'pos', i.e. the entry
+// that contains 'pos', or n if 'pos' is past the end.
+int Fl_Table_Sizes::find(long pos) const {
+  if ( pos < 0 ) return 0;
+  if ( sizes.empty() ) {
+    if ( uniform <= 0 ) return n;
+    long i = pos / uniform;
+    return i < n ? (int)i : n;
+  }
+  int nb = blocks(n), b = 0, step = 1;
+  while ( step * 2 <= nb ) step *= 2;
+  for ( ; step > 0; step /= 2 ) {               // descend the tree to the block
+    if ( b + step <= nb && tree[b + step] <= pos ) {
+      b += step;
+      pos -= tree[b];
+    }
+  }
+  int i = b * BLOCK;
+  while ( i < n && sizes[i] <= pos ) pos -= sizes[i++];
+  return i;
+}
+
 
 /** Sets the vertical scroll position so 'row' is at the top,
     and causes the screen to redraw.
@@ -67,38 +206,14 @@ void Fl_Table::col_position(int col) {
   Returns the scroll position (in pixels) of the specified 'row'.
 */
 long Fl_Table::row_scroll_position(int row) {
-  int startrow = 0;
-  long scroll = 0;
-  // OPTIMIZATION:
-  //     Attempt to use precomputed row scroll position
-  //
-  if ( toprow_scrollpos != -1 && row >= toprow ) {
-    scroll = toprow_scrollpos;
-    startrow = toprow;
-  }
-  for ( int t=startrow; t<row; t++ ) {
-    scroll += row_height(t);
-  }
-  return(scroll);
+  return(_rowheights->position(row));
 }
 
 /**
   Returns the scroll position (in pixels) of the specified column 'col'.
 */
 long Fl_Table::col_scroll_position(int col) {
-  int startcol = 0;
-  long scroll = 0;
-  // OPTIMIZATION:
-  //     Attempt to use precomputed row scroll position
-  //
-  if ( leftcol_scrollpos != -1 && col >= leftcol ) {
-    scroll = leftcol_scrollpos;
-    startcol = leftcol;
-  }
-  for ( int t=startcol; t<col; t++ ) {
-    scroll += col_width(t);
-  }
-  return(scroll);
+  return(_colwidths->position(col));
 }
 
 /**
@@ -145,8 +260,8 @@ Fl_Table::Fl_Table(int X, int Y, int W, int H, const char *l) : Fl_Group(X,Y,W,H
   _scrollbar_size   = 0;
   flags_            = 0;        // TABCELLNAV off
 
-  _colwidths        = new std::vector<int>;  // column widths in pixels
-  _rowheights       = new std::vector<int>;  // row heights in pixels
+  _colwidths        = new Fl_Table_Sizes;  // column widths in pixels
+  _rowheights       = new Fl_Table_Sizes;  // row heights in pixels
 
   box(FL_THIN_DOWN_FRAME);
 
@@ -194,7 +309,7 @@ Fl_Table::~Fl_Table() {
   \returns Number of columns.
 */
 int Fl_Table::col_size() const {
-  return int(_colwidths->size());
+  return _colwidths->count();
 }
 
 /**
@@ -205,7 +320,7 @@ int Fl_Table::col_size() const {
   \returns Number of rows.
 */
 int Fl_Table::row_size() const {
-  return int(_rowheights->size());
+  return _rowheights->count();
 }
 
 /**
@@ -216,15 +331,15 @@ int Fl_Table::row_size() const {
 */
 void Fl_Table::row_height(int row, int height) {
   if ( row < 0 ) return;
-  if ( row < row_size() && (*_rowheights)[row] == height ) {
+  if ( row < row_size() && _rowheights->get(row) == height ) {
     return;             // OPTIMIZATION: no change? avoid redraw
   }
   // Add row heights, even if none yet
   int now_size = row_size();
   if (row >= now_size) {
-    _rowheights->resize(row, height);
+    _rowheights->resize(row+1, height);
   }
-  (*_rowheights)[row] = height;
+  _rowheights->set(row, height);
   table_resized();
   if ( row <= botrow ) {        // OPTIMIZATION: only redraw if onscreen or above screen
     redraw();
@@ -243,7 +358,7 @@ void Fl_Table::row_height(int row, int height) {
 void Fl_Table::col_width(int col, int width)
 {
   if ( col < 0 ) return;
-  if ( col < col_size() && (*_colwidths)[col] == width ) {
+  if ( col < col_size() && _colwidths->get(col) == width ) {
     return;                     // OPTIMIZATION: no change? avoid redraw
   }
   // Add column widths, even if none yet
@@ -251,7 +366,7 @@ void Fl_Table::col_width(int col, int width)
   if ( col >= now_size ) {
     _colwidths->resize(col+1, width);
   }
-  (*_colwidths)[col] = width;
+  _colwidths->set(col, width);
   table_resized();
   if ( col <= rightcol ) {      // OPTIMIZATION: only redraw if onscreen or to the left
     redraw();
@@ -563,38 +678,26 @@ void Fl_Table::recalc_dimensions() {
   TODO: Assumes ti[xywh] has already been recalculated.
 */
 void Fl_Table::table_scrolled() {
-  // Find top row
-  int y, row, voff = vscrollbar->value();
-  for ( row=y=0; row < _rows; row++ ) {
-    y += row_height(row);
-    if ( y > voff ) { y -= row_height(row); break; }
-  }
-  _row_position = toprow = ( row >= _rows ) ? (row - 1) : row;
-  toprow_scrollpos = y;         // OPTIMIZATION: save for later use
-  // Find bottom row
-  voff = vscrollbar->value() + tih;
-  for ( ; row < _rows; row++ ) {
-    y += row_height(row);
-    if ( y >= voff ) { break; }
-  }
-  botrow = ( row >= _rows ) ? (row - 1) : row;
+  // Find top row: the row that contains the scroll position
+  int row, voff = (int)vscrollbar->value();
+  row = _rowheights->find(voff);
+  _row_position = toprow = ( row >= _rows ) ? (_rows - 1) : row;
+  toprow_scrollpos = (int)row_scroll_position(toprow);  // OPTIMIZATION: save for later use
+  // Find bottom row: the first row that ends at or below the bottom edge
+  voff = (int)vscrollbar->value() + tih;
+  row = _rowheights->find(voff - 1L);
+  if ( row < toprow ) row = toprow;
+  botrow = ( row >= _rows ) ? (_rows - 1) : row;
   // Left column
-  int x, col, hoff = hscrollbar->value();
-  for ( col=x=0; col < _cols; col++ ) {
-    x += col_width(col);
-    if ( x > hoff ) { x -= col_width(col); break; }
-  }
-  _col_position = leftcol = ( col >= _cols ) ? (col - 1) : col;
-  leftcol_scrollpos = x;        // OPTIMIZATION: save for later use
+  int col, hoff = (int)hscrollbar->value();
+  col = _colwidths->find(hoff);
+  _col_position = leftcol = ( col >= _cols ) ? (_cols - 1) : col;
+  leftcol_scrollpos = (int)col_scroll_position(leftcol);        // OPTIMIZATION: save for later use
   // Right column
-  //    Work with data left over from leftcol calculation
-  //
-  hoff = hscrollbar->value() + tiw;
-  for ( ; col < _cols; col++ ) {
-    x += col_width(col);
-    if ( x >= hoff ) { break; }
-  }
-  rightcol = ( col >= _cols ) ? (col - 1) : col;
+  hoff = (int)hscrollbar->value() + tiw;
+  col = _colwidths->find(hoff - 1L);
+  if ( col < leftcol ) col = leftcol;
+  rightcol = ( col >= _cols ) ? (_cols - 1) : col;
   // First tell children to scroll
   draw_cell(CONTEXT_RC_RESIZE, 0,0,0,0,0,0);
 }
@@ -660,7 +763,7 @@ void Fl_Table::rows(int val) {
   int oldrows = _rows;
   _rows = val;
 
-  int default_h = row_size() > 0 ? _rowheights->back() : 25;
+  int default_h = row_size() > 0 ? _rowheights->get(row_size()-1) : 25;
   int now_size = row_size();
 
   if (now_size != val)
@@ -682,7 +785,7 @@ void Fl_Table::rows(int val) {
 void Fl_Table::cols(int val) {
   _cols = val;
 
-  int default_w = col_size() > 0 ? (*_colwidths)[col_size()-1] : 80;
+  int default_w = col_size() > 0 ? _colwidths->get(col_size()-1) : 80;
   int now_size = col_size();
 
   if (now_size != val)
@@ -1398,12 +1501,55 @@ void Fl_Table::draw() {
   Returns the current height of the specified row as a value in pixels.
 */
 int Fl_Table::row_height(int row) const {
-  return((row < 0 || row >= row_size()) ? 0 : (*_rowheights)[row]);
+  return((row < 0 || row >= row_size()) ? 0 : _rowheights->get(row));
 }
 
 /**
   Returns the current width of the specified column in pixels.
 */
 int Fl_Table::col_width(int col) const {
-  return((col < 0 || col >= col_size()) ? 0 : (*_colwidths)[col]);
+  return((col < 0 || col >= col_size()) ? 0 : _colwidths->get(col));
+}
+
+/**
+  Convenience method to set the height of all rows to the
+  same value, in pixels. The screen is redrawn.
+
+  The heights of the individual rows are dropped, so a table whose rows
+  all have the same height needs no memory per row, however many rows
+  it has. callback() is invoked with CONTEXT_RC_RESIZE for each row
+  whose height changed, as with row_height(int, int).
+*/
+void Fl_Table::row_height_all(int height) {
+  std::vector<int> changed;     // rows to report to the callback
+  if ( Fl_Widget::callback() && when() & FL_WHEN_CHANGED ) {
+    for ( int r=0; r<rows() && r<row_size(); r++ )
+      if ( _rowheights->get(r) != height ) changed.push_back(r);
+  }
+  _rowheights->fill(height);
+  table_resized();
+  redraw();
+  for ( size_t t=0; t<changed.size(); t++ )
+    do_callback(CONTEXT_RC_RESIZE, changed[t], 0);
+}
+
+/**
+  Convenience method to set the width of all columns to the
+  same value, in pixels. The screen is redrawn.
+
+  The widths of the individual columns are dropped, see row_height_all().
+  callback() is invoked with CONTEXT_RC_RESIZE for each column
+  whose width changed, as with col_width(int, int).
+*/
+void Fl_Table::col_width_all(int width) {
+  std::vector<int> changed;     // columns to report to the callback
+  if ( Fl_Widget::callback() && when() & FL_WHEN_CHANGED ) {
+    for ( int c=0; c<cols() && c<col_size(); c++ )
+      if ( _colwidths->get(c) != width ) changed.push_back(c);
+  }
+  _colwidths->fill(width);
+  table_resized();
+  redraw();
+  for ( size_t t=0; t<changed.size(); t++ )
+    do_callback(CONTEXT_RC_RESIZE, 0, changed[t]);
 }
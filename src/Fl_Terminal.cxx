@@ -27,6 +27,7 @@
 #include <stdlib.h>     // malloc
 #include <string.h>     // strlen
 #include <stdarg.h>     // va_list
+#include <stdint.h>     // uint64_t
 #include <assert.h>
 #include <string>
 
@@ -55,6 +56,24 @@ static int clamp(int val, int min, int max)
 static void swap(int &a, int &b)
   { int asave = a; a = b; b = asave; }
 
+// Return the number of printable ASCII chars (0x20 thru 0x7e) at the start of s[len].
+//    Checks 8 bytes at a time for bytes below 0x20 or above 0x7e.
+//
+static int printable_ascii_len(const char *s, int len) {
+  const uint64_t ones  = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+  int i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t x;
+    memcpy(&x, s + i, 8);
+    if (((x - ones * 0x20) & ~x & highs) |          // any byte < 0x20?
+        (((x + ones) | x) & highs))                 // any byte >= 0x7f?
+      break;
+  }
+  while (i < len && s[i] >= 0x20 && s[i] <= 0x7e) i++;
+  return i;
+}
+
 static int normalize(int row, int maxrows) {
   row = row % maxrows;
   if (row < 0) row = maxrows + row;    // negative? index relative to end
@@ -532,6 +551,187 @@ void Fl_Terminal::Cursor::scroll(int nrows) {
   row_ = MAX(row_ - nrows, 0);   // don't let (row_<0)
 }
 
+/////////////////////////////////////
+///// Utf8Char Style Table //////////
+/////////////////////////////////////
+
+// Table of the distinct styles (attrib, charflags, fg/bg colors) of the chars
+// of all terminals. Utf8Char only stores a 16 bit index into this table, which
+// keeps each char at 8 bytes instead of 16.
+//
+// Each entry counts the chars using it. The entry of a style no char uses
+// anymore goes on a free list and is reused for the next new style, so the
+// table only holds the styles in use, e.g. while 24 bit color output scrolls
+// through the history. If all 65536 entries are in use, new styles fall back
+// to the default style.
+//
+// Entry 0 is the style of a default constructed Utf8Char. It isn't counted and
+// never freed, and until the table is allocated it is 'default_style_', so the
+// inline accessors never need to check the table. The table is freed when the
+// last terminal is destroyed.
+//
+static const int max_char_styles = 1 << 16;   // Utf8Char::style_ is 16 bits
+static int  char_styles_num  = 1;             // #entries used, including free ones
+static int  char_styles_size = 0;             // #entries allocated, 0 if none
+static int  char_styles_live = 1;             // #entries in use
+static int *char_styles_hash = 0;             // hash: index+1 into table, 0 if unused
+static int  char_styles_hash_size = 0;
+static int *char_styles_free = 0;             // free list: unused entries to reuse
+static int  char_styles_nfree = 0;
+static int  terminals_num    = 0;             // #terminals, the last one frees the table
+
+// The style of the last lookup, and its index, -1 if none
+static Fl_Color last_fgcolor, last_bgcolor;
+static uchar    last_attrib, last_charflags;
+static int      last_index = -1;
+
+Fl_Terminal::Utf8Char::Style  Fl_Terminal::Utf8Char::default_style_ = { 0xffffff00, 0xffffffff, 0, 0, 0 };
+Fl_Terminal::Utf8Char::Style *Fl_Terminal::Utf8Char::styles_ = &Fl_Terminal::Utf8Char::default_style_;
+
+static unsigned char_style_hash(uchar attrib, uchar charflags, Fl_Color fg, Fl_Color bg) {
+  unsigned h = fg * 2654435761u;
+  h = (h ^ bg) * 2654435761u;
+  h = (h ^ (attrib | (charflags << 8))) * 2654435761u;
+  return h ^ (h >> 15);
+}
+
+// Return the hash slot of table entry 'i'
+unsigned Fl_Terminal::Utf8Char::style_hash(int i) {
+  const Style &st = styles_[i];
+  return char_style_hash(st.attrib, st.charflags, st.fgcolor, st.bgcolor) & (char_styles_hash_size - 1);
+}
+
+// Rebuild the hash of the entries in use with 'size' slots
+void Fl_Terminal::Utf8Char::styles_rehash(int size) {
+  free(char_styles_hash);
+  char_styles_hash      = (int*)calloc(size, sizeof(int));
+  char_styles_hash_size = size;
+  for (int i=0; i<char_styles_num; i++) {
+    if (i > 0 && styles_[i].refs == 0) continue;          // on the free list?
+    unsigned h = style_hash(i);
+    while (char_styles_hash[h]) h = (h + 1) & (size - 1);
+    char_styles_hash[h] = i + 1;
+  }
+}
+
+// Add a reference to the style at table index 'i'
+inline void Fl_Terminal::Utf8Char::ref_style(unsigned i) {
+  if (i > 0) styles_[i].refs++;                           // entry 0 isn't counted
+}
+
+// Remove 'n' references to the style at table index 'i', and free
+// its entry if no char uses it anymore.
+//
+inline void Fl_Terminal::Utf8Char::unref_style(unsigned i, unsigned n) {
+  if (i == 0 || i >= unsigned(char_styles_num)) return;   // default style, or index into a freed table?
+  if ((styles_[i].refs -= n) == 0) free_style(i);
+}
+
+// Set the style of the 'n' chars at 'u8c', which all have the same style,
+// to table index 'i' that holds one reference from ref_style(...).
+// Updates the reference counts once instead of once per char.
+//
+void Fl_Terminal::Utf8Char::style_run(Utf8Char *u8c, int n, unsigned i) {
+  if (i > 0) styles_[i].refs += n - 1;                    // ref new style first: may be the same
+  unref_style(u8c->style_, n);
+  for (int c=0; c<n; c++) u8c[c].style_ = i;
+}
+
+// Free the unused entry at table index 'i' for reuse
+void Fl_Terminal::Utf8Char::free_style(unsigned i) {
+  // Remove from hash: find its slot, then move up the entries that were
+  // displaced past it, so lookups don't stop at the hole.
+  const unsigned mask = char_styles_hash_size - 1;
+  unsigned h = style_hash(i);
+  while (char_styles_hash[h] != int(i + 1)) h = (h + 1) & mask;
+  for (unsigned j = (h + 1) & mask; char_styles_hash[j]; j = (j + 1) & mask) {
+    unsigned k = style_hash(char_styles_hash[j] - 1);     // entry's home slot
+    if ((j > h) ? (h < k && k <= j) : (h < k || k <= j)) continue;  // home between hole and j? stays
+    char_styles_hash[h] = char_styles_hash[j];
+    h = j;
+  }
+  char_styles_hash[h] = 0;
+  char_styles_free[char_styles_nfree++] = i;
+  char_styles_live--;
+  if (last_index == int(i)) last_index = -1;
+}
+
+// Add a reference to style (attrib, charflags, fg, bg) and return its index,
+// adding the style to the table if it's new.
+//
+unsigned Fl_Terminal::Utf8Char::ref_style(uchar attrib, uchar charflags,
+                                          Fl_Color fg, Fl_Color bg) {
+  if (last_index >= 0 && last_fgcolor == fg && last_bgcolor == bg &&  // same as last time?
+      last_attrib == attrib && last_charflags == charflags) {          // (most chars are)
+    ref_style(last_index);
+    return last_index;
+  }
+  if (!char_styles_size) {                                // first use? allocate table
+    char_styles_size = 64;
+    styles_ = (Style*)malloc(char_styles_size * sizeof(Style));
+    styles_[0] = default_style_;
+    char_styles_free = (int*)malloc(char_styles_size * sizeof(int));
+    styles_rehash(128);
+  }
+  unsigned h = char_style_hash(attrib, charflags, fg, bg) & (char_styles_hash_size - 1);
+  int i;
+  for (; (i = char_styles_hash[h]) != 0; h = (h + 1) & (char_styles_hash_size - 1)) {
+    const Style &o = styles_[i-1];
+    if (o.fgcolor == fg && o.bgcolor == bg && o.attrib == attrib && o.charflags == charflags)
+      break;
+  }
+  if (i) {                                                // found?
+    i--;
+  } else {                                                // new style
+    if (char_styles_nfree > 0) {                          // reuse a free entry
+      i = char_styles_free[--char_styles_nfree];
+    } else if (char_styles_num < max_char_styles) {       // append an entry
+      if (char_styles_num == char_styles_size) {
+        char_styles_size *= 2;
+        styles_ = (Style*)realloc(styles_, char_styles_size * sizeof(Style));
+        char_styles_free = (int*)realloc(char_styles_free, char_styles_size * sizeof(int));
+      }
+      i = char_styles_num++;
+    } else {
+      return 0;                                           // table full: use the default style
+    }
+    Style &st = styles_[i];
+    st.fgcolor = fg; st.bgcolor = bg; st.attrib = attrib; st.charflags = charflags;
+    st.refs = 0;
+    char_styles_live++;
+    if (char_styles_live * 2 > char_styles_hash_size) {   // keep hash at most half full
+      st.refs = 1;                                        // (rehash skips unused entries)
+      styles_rehash(char_styles_hash_size * 2);
+      st.refs = 0;
+    } else {
+      char_styles_hash[h] = i + 1;
+    }
+  }
+  last_fgcolor = fg; last_bgcolor = bg; last_attrib = attrib; last_charflags = charflags;
+  last_index   = i;
+  ref_style(i);
+  return i;
+}
+
+// Free the table, e.g. when no terminals are left
+void Fl_Terminal::Utf8Char::styles_free(void) {
+  if (char_styles_size) free(styles_);
+  styles_ = &default_style_;
+  free(char_styles_hash); char_styles_hash = 0;
+  free(char_styles_free); char_styles_free = 0;
+  char_styles_num  = char_styles_live = 1;
+  char_styles_size = char_styles_hash_size = char_styles_nfree = 0;
+  last_index = -1;
+}
+
+/**
+  Returns the number of styles used by the chars of all terminals, which
+  is the number of entries in use in the style table. Mainly for testing.
+*/
+int Fl_Terminal::char_styles_count(void) {
+  return char_styles_live;
+}
+
 /////////////////////////////////////
 ///// Utf8Char Class Methods ////////
 /////////////////////////////////////
@@ -540,40 +740,43 @@ void Fl_Terminal::Cursor::scroll(int nrows) {
 Fl_Terminal::Utf8Char::Utf8Char(void) {
   text_[0]   = ' ';
   len_       = 1;
-  attrib_    = 0;
-  charflags_ = 0;
-  fgcolor_   = 0xffffff00;
-  bgcolor_   = 0xffffffff;   // special color: doesn't draw, 'shows thru' to box()
+  style_     = 0;            // fg 0xffffff00, bg 0xffffffff: doesn't draw, 'shows thru' to box()
 }
 
 // copy ctor
 Fl_Terminal::Utf8Char::Utf8Char(const Utf8Char& src) {
-  // local instance not initialized yet; init first, then copy text
-  text_[0]   = ' ';
-  len_       = 1;
-  attrib_    = src.attrib_;
-  charflags_ = src.charflags_;
-  fgcolor_   = src.fgcolor_;
-  bgcolor_   = src.bgcolor_;
-  text_utf8_(src.text_utf8(), src.length());    // copy the src text
+  memcpy(text_, src.text_, max_utf8_);
+  len_       = src.len_;
+  style_     = src.style_;
+  ref_style(style_);
 }
 
 // assignment
 Fl_Terminal::Utf8Char& Fl_Terminal::Utf8Char::operator=(const Utf8Char& src) {
-  // local instance is already initialized, so just change its contents
-  text_utf8_(src.text_utf8(), src.length());    // local copy src text
-  attrib_    = src.attrib_;
-  charflags_ = src.charflags_;
-  fgcolor_   = src.fgcolor_;
-  bgcolor_   = src.bgcolor_;
+  memcpy(text_, src.text_, max_utf8_);
+  len_       = src.len_;
+  if (style_ != src.style_) {
+    ref_style(src.style_);
+    unref_style(style_);
+    style_   = src.style_;
+  }
   return *this;
 }
 
 // dtor
 Fl_Terminal::Utf8Char::~Utf8Char(void) {
+  unref_style(style_);
   len_ = 0;
 }
 
+// Set the style of this char, adding it to the style table if needed
+void Fl_Terminal::Utf8Char::style_set(uchar attrib, uchar charflags,
+                                      Fl_Color fgcolor, Fl_Color bgcolor) {
+  unsigned i = ref_style(attrib, charflags, fgcolor, bgcolor);  // ref first: may be the same style
+  unref_style(style_);
+  style_ = i;
+}
+
 // Set 'text_' to valid UTF-8 string 'text'.
 //
 // text_ must not be NULL, and len must be in range: 1 <= len <= max_utf8().
@@ -596,10 +799,8 @@ void Fl_Terminal::Utf8Char::text_utf8(const char *text,
                                       const CharStyle& style) {
   text_utf8_(text, len);                       // updates text_, len_
   //issue 837 // fl_font(style.fontface(), style.fontsize()); // need font to calc UTF-8 width
-  attrib_    = style.attrib();
-  charflags_ = style.colorbits_only(charflags_);
-  fgcolor_   = style.fgcolor();
-  bgcolor_   = style.bgcolor();
+  style_set(style.attrib(), style.colorbits_only(charflags()),
+            style.fgcolor(), style.bgcolor());
 }
 
 // Set char to single printable ASCII character 'c'
@@ -612,22 +813,46 @@ void Fl_Terminal::Utf8Char::text_ascii(char c, const CharStyle& style) {
   text_utf8(&c, 1, style);
 }
 
-// Set fl_font() based on specified style for this char's attribute
-void Fl_Terminal::Utf8Char::fl_font_set(const CharStyle& style) const {
-  int face = style.fontface() |
-               ((attrib_ & Fl_Terminal::BOLD)   ? FL_BOLD   : 0) |
-               ((attrib_ & Fl_Terminal::ITALIC) ? FL_ITALIC : 0);
-  fl_font(face, style.fontsize());
+// Set the 'n' chars starting at 'u8c' to the printable ASCII chars in 's'.
+//     Same as calling text_ascii() for each char, but the style table is
+//     only searched once for each run of chars with the same previous style.
+//
+void Fl_Terminal::Utf8Char::text_ascii(Utf8Char *u8c, const char *s, int n,
+                                       const CharStyle& style) {
+  for (int c=0, e; c<n; c=e) {
+    for (e=c+1; e<n && u8c[e].style_ == u8c[c].style_; e++) { }   // find run of same style
+    style_run(u8c + c, e - c, ref_style(style.attrib(),
+                                        style.colorbits_only(u8c[c].charflags()),
+                                        style.fgcolor(), style.bgcolor()));
+  }
+  for (int c=0; c<n; c++) {
+    u8c[c].text_[0] = s[c];
+    u8c[c].len_     = 1;
+  }
 }
 
-// Return the foreground color as an fltk color
-Fl_Color Fl_Terminal::Utf8Char::fgcolor(void) const {
-  return fgcolor_;
+// Clear the character to a 'space' with the colors of 'style'
+void Fl_Terminal::Utf8Char::clear(const CharStyle& style) {
+  text_utf8_(" ", 1);
+  style_set(0, 0, style.fgcolor(), style.bgcolor());
 }
 
-// Return the background color as an fltk color
-Fl_Color Fl_Terminal::Utf8Char::bgcolor(void) const {
-  return bgcolor_;
+// Clear the 'n' chars starting at 'u8c', same as calling clear() for each char
+void Fl_Terminal::Utf8Char::clear(Utf8Char *u8c, int n, const CharStyle& style) {
+  for (int c=0, e; c<n; c=e) {
+    for (e=c+1; e<n && u8c[e].style_ == u8c[c].style_; e++) { }   // find run of same style
+    style_run(u8c + c, e - c, ref_style(0, 0, style.fgcolor(), style.bgcolor()));
+  }
+  for (int c=0; c<n; c++) u8c[c].text_utf8_(" ", 1);
+}
+
+// Set fl_font() based on specified style for this char's attribute
+void Fl_Terminal::Utf8Char::fl_font_set(const CharStyle& style) const {
+  uchar attr = attrib();
+  int face = style.fontface() |
+               ((attr & Fl_Terminal::BOLD)   ? FL_BOLD   : 0) |
+               ((attr & Fl_Terminal::ITALIC) ? FL_ITALIC : 0);
+  fl_font(face, style.fontsize());
 }
 
 // Return the width of this character in floating point pixels
@@ -655,7 +880,7 @@ int Fl_Terminal::Utf8Char::pwidth_int(void) const {
 Fl_Color Fl_Terminal::Utf8Char::attr_color_(Fl_Color col, const Fl_Widget *grp) const {
   // Don't modify color if it's the special 'see thru' color 0xffffffff or widget's color()
   if (grp && ((col == 0xffffffff) || (col == grp->color()))) return grp->color();
-  switch (attrib_ & (Fl_Terminal::BOLD|Fl_Terminal::DIM)) {
+  switch (attrib() & (Fl_Terminal::BOLD|Fl_Terminal::DIM)) {
     case 0: return col;                                   // not bold or dim? no change
     case Fl_Terminal::BOLD: return bold_color(col);       // bold? use bold_color()
     case Fl_Terminal::DIM : return dim_color(col);        // dim?  use dim_color()
@@ -668,17 +893,17 @@ Fl_Color Fl_Terminal::Utf8Char::attr_color_(Fl_Color col, const Fl_Widget *grp)
 //    influenced by the attribute bits /if/ \p col matches the \p grp widget's own color().
 //
 Fl_Color Fl_Terminal::Utf8Char::attr_fg_color(const Fl_Widget *grp) const {
-  if (grp && (fgcolor_ == 0xffffffff))           // see thru color?
+  if (grp && (fgcolor() == 0xffffffff))          // see thru color?
     { return grp->color(); }                     // return grp's color()
-  return (charflags_ & Fl_Terminal::FG_XTERM)    // fg is an xterm color?
+  return (charflags() & Fl_Terminal::FG_XTERM)   // fg is an xterm color?
            ? attr_color_(fgcolor(), grp)         // ..use attributes
            : fgcolor();                          // ..ignore attributes.
 }
 
 Fl_Color Fl_Terminal::Utf8Char::attr_bg_color(const Fl_Widget *grp) const {
-  if (grp && (bgcolor_ == 0xffffffff))           // see thru color?
+  if (grp && (bgcolor() == 0xffffffff))          // see thru color?
     { return grp->color(); }                     // return grp's color()
-  return (charflags_ & Fl_Terminal::BG_XTERM)    // bg is an xterm color?
+  return (charflags() & Fl_Terminal::BG_XTERM)   // bg is an xterm color?
            ? attr_color_(bgcolor(), grp)         // ..use attributes
            : bgcolor();                          // ..ignore attributes.
 }
@@ -752,7 +977,10 @@ void Fl_Terminal::RingBuffer::new_copy(int drows, int dcols, int hrows, const Ch
   }
   // Install new buffer: dump old, install new, adjust internals
   if (ring_chars_) delete[] ring_chars_;
+  if (dirty_) delete[] dirty_;
   ring_chars_ = new_ring_chars;
+  dirty_      = new uchar[new_ring_rows];
+  all_dirty_  = true;     // everything moved
   ring_rows_  = new_ring_rows;
   ring_cols_  = dcols;
   nchars_     = new_nchars;
@@ -765,7 +993,11 @@ void Fl_Terminal::RingBuffer::new_copy(int drows, int dcols, int hrows, const Ch
 // Clear the class, delete previous ring if any
 void Fl_Terminal::RingBuffer::clear(void) {
   if (ring_chars_) delete[] ring_chars_; // dump our ring
+  if (dirty_) delete[] dirty_;
   ring_chars_ = 0;
+  dirty_      = 0;
+  scrolled_   = 0;
+  all_dirty_  = true;
   ring_rows_  = 0;
   ring_cols_  = 0;
   nchars_     = 0;
@@ -783,6 +1015,7 @@ void Fl_Terminal::RingBuffer::clear_hist(void) {
 // Default ctor
 Fl_Terminal::RingBuffer::RingBuffer(void) {
   ring_chars_ = 0;
+  dirty_      = 0;
   clear();
 }
 
@@ -790,6 +1023,7 @@ Fl_Terminal::RingBuffer::RingBuffer(void) {
 Fl_Terminal::RingBuffer::RingBuffer(int drows, int dcols, int hrows) {
   // Start with cleared buffer first..
   ring_chars_ = 0;
+  dirty_      = 0;
   clear();
   // ..then create.
   create(drows, dcols, hrows);
@@ -798,7 +1032,9 @@ Fl_Terminal::RingBuffer::RingBuffer(int drows, int dcols, int hrows) {
 // Dtor
 Fl_Terminal::RingBuffer::~RingBuffer(void) {
   if (ring_chars_) delete[] ring_chars_;
+  if (dirty_) delete[] dirty_;
   ring_chars_ = NULL;
+  dirty_      = NULL;
 }
 
 // See if 'grow' is within the history buffer
@@ -836,8 +1072,7 @@ void Fl_Terminal::RingBuffer::move_disp_row(int src_row, int dst_row) {
 void Fl_Terminal::RingBuffer::clear_disp_rows(int sdrow, int edrow, const CharStyle& style) {
   for (int drow=sdrow; drow<=edrow; drow++) {
     int row = hist_rows_ + drow + offset_;
-    Utf8Char *u8c = u8c_ring_row(row);
-    for (int col=0; col<disp_cols(); col++) u8c++->clear(style);
+    Utf8Char::clear(u8c_ring_row(row), disp_cols(), style);
   }
 }
 
@@ -873,6 +1108,7 @@ void Fl_Terminal::RingBuffer::scroll(int rows, const CharStyle& style) {
     rows = clamp(rows, 1, disp_rows());                        // sanity
     // Scroll up into history
     offset_adjust(rows);
+    scrolled_ += rows;                                         // for partial redraws
     // Adjust hist_use, clamp to max
     hist_use_ = clamp(hist_use_ + rows, 0, hist_rows_);
     // Clear exposed lines at bottom
@@ -983,13 +1219,25 @@ const Fl_Terminal::Utf8Char* Fl_Terminal::RingBuffer::u8c_disp_row(int drow) con
 //   }
 //
 Fl_Terminal::Utf8Char* Fl_Terminal::RingBuffer::u8c_ring_row(int row)
-  { return const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_ring_row(row)); }
+{
+  Utf8Char *u8c = const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_ring_row(row));
+  mark_dirty(u8c);                          // caller may modify the row
+  return u8c;
+}
 
 Fl_Terminal::Utf8Char* Fl_Terminal::RingBuffer::u8c_hist_row(int hrow)
-  { return const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_hist_row(hrow)); }
+{
+  Utf8Char *u8c = const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_hist_row(hrow));
+  mark_dirty(u8c);                          // caller may modify the row
+  return u8c;
+}
 
 Fl_Terminal::Utf8Char* Fl_Terminal::RingBuffer::u8c_hist_use_row(int hurow)
-  { return const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_hist_use_row(hurow)); }
+{
+  Utf8Char *u8c = const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_hist_use_row(hurow));
+  mark_dirty(u8c);                          // caller may modify the row
+  return u8c;
+}
 
 // Return UTF-8 char for beginning of 'row' in the display buffer
 // Example:
@@ -999,7 +1247,11 @@ Fl_Terminal::Utf8Char* Fl_Terminal::RingBuffer::u8c_hist_use_row(int hurow)
 //     ..
 //   }
 Fl_Terminal::Utf8Char* Fl_Terminal::RingBuffer::u8c_disp_row(int drow)
-  { return const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_disp_row(drow)); }
+{
+  Utf8Char *u8c = const_cast<Utf8Char*>(const_cast<const RingBuffer*>(this)->u8c_disp_row(drow));
+  mark_dirty(u8c);                          // caller may modify the row
+  return u8c;
+}
 
 // Resize ring buffer by creating new one, dumping old (if any).
 // Input:
@@ -1019,6 +1271,8 @@ void Fl_Terminal::RingBuffer::create(int drows, int dcols, int hrows) {
   ring_cols_  = dcols;
   nchars_     = ring_rows_ * ring_cols_;
   ring_chars_ = new Utf8Char[nchars_];
+  dirty_      = new uchar[ring_rows_];
+  all_dirty_  = true;
 }
 
 // Resize the buffer, preserve previous contents as much as possible
@@ -1037,9 +1291,27 @@ void Fl_Terminal::RingBuffer::resize(int drows, int dcols, int hrows, const Char
     hist_rows_  = hrows;                          // adj hist rows for new value
     disp_rows_  = drows;                          // adj disp rows for new value
     hist_use_   = clamp(hist_use_ + addhist, 0, hrows);
+    all_dirty_  = true;                           // display shows other rows now
   }
 }
 
+// Flag the ring row starting at 'row' as modified
+void Fl_Terminal::RingBuffer::mark_dirty(const Utf8Char *row) {
+  if (row && dirty_ && ring_cols_) dirty_[(row - ring_chars_) / ring_cols_] = 1;
+}
+
+// See if ring row 'row' was modified since clear_dirty()
+bool Fl_Terminal::RingBuffer::is_dirty_ring_row(int row) const {
+  return all_dirty_ || dirty_[normalize(row, ring_rows())];
+}
+
+// Flag all rows as unmodified, e.g. after the display was drawn
+void Fl_Terminal::RingBuffer::clear_dirty(void) {
+  if (dirty_) memset(dirty_, 0, ring_rows_);
+  scrolled_  = 0;
+  all_dirty_ = false;
+}
+
 // Change the display rows. Use style for new rows, if any.
 void Fl_Terminal::RingBuffer::change_disp_rows(int drows, const CharStyle& style)
   { resize(drows, ring_cols(), hist_rows(), style); }
@@ -1098,7 +1370,7 @@ const Fl_Terminal::Utf8Char* Fl_Terminal::u8c_disp_row(int drow) const
   \endcode
 */
 Fl_Terminal::Utf8Char* Fl_Terminal::u8c_ring_row(int grow)
-  { return const_cast<Utf8Char*>(const_cast<const Fl_Terminal*>(this)->u8c_ring_row(grow)); }
+  { return ring_.u8c_ring_row(grow); }
 
 /**
   Return u8c for beginning of a row inside the scrollback history.
@@ -1106,7 +1378,7 @@ Fl_Terminal::Utf8Char* Fl_Terminal::u8c_ring_row(int grow)
   \see u8c_disp_row(int) for example use.
 */
 Fl_Terminal::Utf8Char* Fl_Terminal::u8c_hist_row(int hrow)
-  { return const_cast<Utf8Char*>(const_cast<const Fl_Terminal*>(this)->u8c_hist_row(hrow)); }
+  { return ring_.u8c_hist_row(hrow); }
 
 /**
   Return u8c for beginning of row \p hurow inside the 'in use' part
@@ -1134,7 +1406,7 @@ Fl_Terminal::Utf8Char* Fl_Terminal::u8c_hist_row(int hrow)
   \see u8c_disp_row(int) for example use.
 */
 Fl_Terminal::Utf8Char* Fl_Terminal::u8c_hist_use_row(int hurow)
-  { return const_cast<Utf8Char*>(const_cast<const Fl_Terminal*>(this)->u8c_hist_use_row(hurow)); }
+  { return ring_.u8c_hist_use_row(hurow); }
 
 /**
   Return pointer to the first u8c character in row \p drow of the display.
@@ -1167,7 +1439,7 @@ Fl_Terminal::Utf8Char* Fl_Terminal::u8c_hist_use_row(int hurow)
   \see u8c_hist_use_row() for examples of walking the screen history
 */
 Fl_Terminal::Utf8Char* Fl_Terminal::u8c_disp_row(int drow)
-  { return const_cast<Utf8Char*>(const_cast<const Fl_Terminal*>(this)->u8c_disp_row(drow)); }
+  { return ring_.u8c_disp_row(drow); }
 
 // Create ring buffer.
 // Input:
@@ -2223,8 +2495,11 @@ void Fl_Terminal::select_line(int grow) {
 */
 void Fl_Terminal::scroll(int rows) {
   // Scroll the ring
+  int hist_before = history_use();
   ring_.scroll(rows, *current_style_);
-  if (rows > 0) update_scrollbar();      // scroll up? changes hist, so scrollbar affected
+  if (rows > 0) {                        // scroll up? changes hist, so scrollbar affected
+    if (history_use() != hist_before) update_scrollbar(); // ..unless history was already full
+  }
   else          clear_mouse_selection(); // scroll dn? clear mouse select; it might wrap ring
 }
 
@@ -2975,7 +3250,7 @@ void Fl_Terminal::display_modified(void) {
   } else if (is_redraw_style(PER_WRITE)) {
     if (!redraw_modified_) {
       redraw_modified_ = true;
-      redraw();                      // only call redraw once
+      damage(FL_DAMAGE_USER1);       // only call once; draw() redraws modified rows
     }
   } else {                           // NO_REDRAW?
     // do nothing
@@ -3136,6 +3411,22 @@ void Fl_Terminal::print_char(char c) {
   }
 }
 
+// Print run of printable ASCII chars s[len] at the cursor, and advance the cursor.
+//    Same as print_char() for each char, but writes up to a row at a time.
+//
+void Fl_Terminal::print_ascii_run(const char *s, int len) {
+  while (len > 0) {
+    int col = cursor_col();
+    int n   = MIN(len, disp_cols() - col);
+    if (n <= 0) { print_char(*s++); len--; continue; }    // cursor off screen? let print_char() handle it
+      Utf8Char::text_ascii(u8c_disp_row(cursor_row()) + col, s, n, *current_style_);
+    s   += n;
+    len -= n;
+    if (col + n >= disp_cols()) cursor_crlf(1);           // hit right edge? wrap like cursor_right()
+    else cursor_.col(col + n);
+  }
+}
+
 // Clear the Partial UTF-8 Buffer cache
 void Fl_Terminal::utf8_cache_clear(void) {
   pub_.clear();
@@ -3185,6 +3476,17 @@ void Fl_Terminal::append_utf8(const char *buf, int len/*=-1*/) {
   // For sure buf is now pointing at a valid char, so walk to end of buffer
   const char *p = buf;                      // ptr to walk buffer
   while (len>0) {
+    // Fast path for runs of plain ASCII text
+    if (!escseq.parse_in_progress()) {
+      const int alen = printable_ascii_len(p, len);
+      if (alen > 0) {
+        print_ascii_run(p, alen);
+        p   += alen;
+        len -= alen;
+        mod |= 1;
+        continue;
+      }
+    }
     const int clen = fl_utf8len(*p);        // save byte length of char
     if (clen == -1) {                       // Encountered invalid UTF-8?
       if (ansi_) escseq.reset();            //   ..reset escseq
@@ -3218,7 +3520,12 @@ void Fl_Terminal::append_utf8(const char *buf, int len/*=-1*/) {
 */
 void Fl_Terminal::append_ascii(const char *s) {
   if (!s) return;
-  while ( *s ) print_char(*s++);            // handles display_modified()
+  int len = int(strlen(s));
+  while (len > 0) {
+    int alen = escseq.parse_in_progress() ? 0 : printable_ascii_len(s, len);
+    if (alen > 0) { print_ascii_run(s, alen); s += alen; len -= alen; } // run of plain text?
+    else          { print_char(*s++); len--; }                          // handles ctrl/esc chars
+  }
   display_modified();
 }
 
@@ -3377,7 +3684,7 @@ void Fl_Terminal::autoscroll_timer_cb(void *udata) {
 void Fl_Terminal::redraw_timer_cb2(void) {
   //DRAWDEBUG ::printf("--- UPDATE TICK %.02f\n", redraw_rate_); fflush(stdout);
   if (redraw_modified_) {
-    redraw();                                                // Timer triggered redraw
+    damage(FL_DAMAGE_USER1);                                 // Timer triggered redraw of modified rows
     redraw_modified_ = false;                                // acknowledge modified flag
     Fl::repeat_timeout(redraw_rate_, redraw_timer_cb, this); // restart timer
   } else {
@@ -3466,6 +3773,7 @@ void Fl_Terminal::init_(int X,int Y,int W,int H,const char*L,int rows,int cols,i
   redraw_rate_     = 0.10f;             // maximum rate in seconds (1/10=10fps)
   redraw_modified_ = false;             // display 'modified' flag
   redraw_timer_    = false;
+  drawn_.valid     = false;             // first draw() redraws everything
   autoscroll_dir_  = 0;
   autoscroll_amt_  = 0;
 
@@ -3493,6 +3801,7 @@ void Fl_Terminal::init_(int X,int Y,int W,int H,const char*L,int rows,int cols,i
   clear_history();            // clear history buffer
   show_unknown_ = false;      // default "off"
   ansi_ = true;               // default "on"
+  terminals_num++;            // the last terminal frees the style table
   // End group
   end();
 }
@@ -3510,6 +3819,8 @@ Fl_Terminal::~Fl_Terminal(void) {
   if (redraw_timer_)
     { Fl::remove_timeout(redraw_timer_cb, this); redraw_timer_ = false; }
   delete current_style_;
+  if (--terminals_num == 0)   // last terminal? free the style table
+    Utf8Char::styles_free();  // (the chars of our ring_ don't need it anymore)
 }
 
 /**
@@ -3615,9 +3926,11 @@ void Fl_Terminal::draw_row_bg(int grow, int X, int Y) const {
   int end_col   = disp_cols();
   const Utf8Char *u8c = u8c_ring_row(grow) + start_col;   // start of spec'd row
   uchar lastattr      = u8c->attrib();
+  int      span_x   = X;                                  // start of current bg span
+  Fl_Color span_col = Fl_Group::color();                  // color of current bg span
   for (int gcol=start_col; gcol<end_col; gcol++,u8c++) {  // walk columns
     // Attribute changed since last char?
-    if (gcol==0 || u8c->attrib() != lastattr) {
+    if (gcol==start_col || u8c->attrib() != lastattr) {
       u8c->fl_font_set(*current_style_);                  // pwidth_int() needs fl_font set
       lastattr = u8c->attrib();
     }
@@ -3627,19 +3940,54 @@ void Fl_Terminal::draw_row_bg(int grow, int X, int Y) const {
                : (u8c->attrib() & Fl_Terminal::INVERSE)   // Inverse mode?
                  ? u8c->attr_fg_color(this)               // ..use fg color for bg
                  : u8c->attr_bg_color(this);              // ..use bg color for bg
-    // Draw only if color != 0xffffffff ('see through' color) or widget's own color().
-    if (bg_col != 0xffffffff && bg_col != Fl_Group::color()) {
-      fl_color(bg_col);
-      fl_rectf(X, bg_y, pwidth, bg_h);
+    // Color changed? Draw the previous span with a single rectf
+    if (bg_col != span_col) {
+      // Draw only if color != 0xffffffff ('see through' color) or widget's own color().
+      if (span_col != 0xffffffff && span_col != Fl_Group::color()) {
+        fl_color(span_col);
+        fl_rectf(span_x, bg_y, X - span_x, bg_h);
+      }
+      span_x   = X;
+      span_col = bg_col;
     }
     X += pwidth;                                          // advance X to next char
   }
+  if (span_col != 0xffffffff && span_col != Fl_Group::color()) {
+    fl_color(span_col);
+    fl_rectf(span_x, bg_y, X - span_x, bg_h);
+  }
+}
+
+/**
+  Draw a run of UTF-8 text \p text of \p len bytes that shares the same
+  attributes \p attr and color \p fg, starting at FLTK coords \p X and \p baseline.
+  The caller has already set the font. \p W is the width of the run in pixels,
+  used for underline and strikeout.
+*/
+void Fl_Terminal::draw_row_run(const char *text, int len, int X, int W,
+                               int baseline, uchar attr, Fl_Color fg) const {
+// This looks better on macOS, but too low for X. Maybe we can get better results using fl_text_extents()?
+//  int  strikeout_y = baseline - (current_style_->fontheight() / 4);
+//  int  underline_y = baseline + (current_style_->fontheight() / 5);
+  int strikeout_y = baseline - (current_style_->fontheight() / 3);
+  int underline_y = baseline;
+  fl_color(fg);
+  while (len > 0 && text[len-1] == ' ') len--;            // no need to draw trailing spaces
+  if (len > 0) fl_draw(text, len, X, baseline);
+  if (attr & Fl_Terminal::UNDERLINE) fl_line(X, underline_y, X+W, underline_y);
+  if (attr & Fl_Terminal::STRIKEOUT) fl_line(X, strikeout_y, X+W, strikeout_y);
 }
 
 /**
   Draw the specified global row, which is the row in ring_chars[].
   The global row includes history + display buffers.
 
+  Neighboring chars with the same attributes and colors are collected
+  into runs, and each run is drawn with a single fl_draw() call.
+  fl_draw() advances by the font's fractional char widths, while the
+  chars are placed on whole pixels, so a run is also ended before its
+  next char would be drawn more than one pixel away from its cell.
+
  \param[in] grow row number
  \param[in] Y top position of characters in the row in FLTK coordinates
 */
@@ -3654,14 +4002,16 @@ void Fl_Terminal::draw_row(int grow, int Y) const {
   int  disp_top = (disp_srow() - scrollval);              // top row we need to view
   int  drow = grow - disp_top;                            // disp row
   bool inside_display = is_disp_ring_row(grow);           // row inside 'display'?
-// This looks better on macOS, but too low for X. Maybe we can get better results using fl_text_extents()?
-//  int  strikeout_y = baseline - (current_style_->fontheight() / 4);
-//  int  underline_y = baseline + (current_style_->fontheight() / 5);
-  int  strikeout_y = baseline - (current_style_->fontheight() / 3);
-  int  underline_y = baseline;
   uchar lastattr = -1;
   bool  is_cursor;
   Fl_Color fg;
+  char     run[256];                                      // UTF-8 text of current run
+  int      run_len  = 0;                                  // bytes in run[]
+  int      run_x    = X;                                  // left edge of run
+  int      run_w    = 0;                                  // pixel width of run
+  double   run_fw   = 0.0;                                // width of run as fl_draw() advances
+  uchar    run_attr = 0;
+  Fl_Color run_fg   = 0;
   int start_col = hscrollbar->visible() ? hscrollbar->value() : 0;
   int end_col   = disp_cols();
   const Utf8Char *u8c = u8c_ring_row(grow) + start_col;
@@ -3669,14 +4019,29 @@ void Fl_Terminal::draw_row(int grow, int Y) const {
     const int &dcol = gcol;                               // dcol and gcol are the same
     // Are we drawing the cursor? Only if inside display
     is_cursor = inside_display ? cursor_.is_rowcol(drow-scrollval, dcol) : 0;
+    // Color for text
+    if (is_cursor) fg = cursorfgcolor();                     // color for text under cursor
+    else fg = is_inside_selection(grow, gcol)                // text in mouse selection?
+      ? select_.selectionfgcolor()                           // ..use selection FG color
+      : (u8c->attrib() & Fl_Terminal::INVERSE)               // Inverse attrib?
+        ? u8c->attr_bg_color(this)                           // ..use char's bg color for fg
+        : u8c->attr_fg_color(this);                          // ..use char's fg color for fg
+    // Char can't join current run? Draw the run (its font is still set)
+    if (run_len && (is_cursor || u8c->attrib() != run_attr || fg != run_fg ||
+                    run_len + u8c->length() > (int)sizeof(run))) {
+      draw_row_run(run, run_len, run_x, run_w, baseline, run_attr, run_fg);
+      run_len = run_w = 0;
+      run_fw = 0.0;
+    }
     // Attribute changed since last char?
     if (u8c->attrib() != lastattr) {
-      u8c->fl_font_set(*current_style_);                  // pwidth_int() needs fl_font set
+      u8c->fl_font_set(*current_style_);                  // pwidth() needs fl_font set
       lastattr = u8c->attrib();
     }
-    int pwidth = u8c->pwidth_int();
-    // DRAW CURSOR BLOCK - TODO: support other cursor types?
+    double fwidth = u8c->pwidth();
+    int pwidth = int(fwidth + 0.5);
     if (is_cursor) {
+      // DRAW CURSOR BLOCK - TODO: support other cursor types?
       int cx = X;
       int cy = Y + current_style_->fontheight() - cursor_.h();
       int cw = pwidth;
@@ -3684,29 +4049,29 @@ void Fl_Terminal::draw_row(int grow, int Y) const {
       fl_color(cursorbgcolor());
       if (Fl::focus() == this) fl_rectf(cx, cy, cw, ch);
       else                     fl_rect(cx, cy, cw, ch);
-    }
-    // DRAW TEXT
-    // 1) Color for text
-    if (is_cursor) fg = cursorfgcolor();                     // color for text under cursor
-    else fg = is_inside_selection(grow, gcol)                // text in mouse selection?
-      ? select_.selectionfgcolor()                           // ..use selection FG color
-      : (u8c->attrib() & Fl_Terminal::INVERSE)               // Inverse attrib?
-        ? u8c->attr_bg_color(this)                           // ..use char's bg color for fg
-        : u8c->attr_fg_color(this);                          // ..use char's fg color for fg
-    fl_color(fg);
-    // 2) Font for text - already set by u8c->fl_font_set() in the above
-    if (is_cursor) {
-      fl_font(fl_font()|FL_BOLD, fl_size());      // force text under cursor BOLD
+      // Text under cursor is drawn by itself, forced BOLD
+      fl_font(fl_font()|FL_BOLD, fl_size());
       lastattr = -1;                              // (ensure font reset on next iter)
+      draw_row_run(u8c->text_utf8(), u8c->length(), X, pwidth, baseline, u8c->attrib(), fg);
+    } else {
+      // Append char to run
+      if (!run_len) { run_x = X; run_attr = u8c->attrib(); run_fg = fg; }
+      memcpy(run + run_len, u8c->text_utf8(), u8c->length());
+      run_len += u8c->length();
+      run_w   += pwidth;
+      run_fw  += fwidth;
+      // Next char would drift more than a pixel from its cell? End the run
+      double drift = run_fw - run_w;
+      if (drift > 1.0 || drift < -1.0) {
+        draw_row_run(run, run_len, run_x, run_w, baseline, run_attr, run_fg);
+        run_len = run_w = 0;
+        run_fw = 0.0;
+      }
     }
-    // 3) Draw text for UTF-8 char. No need to draw spaces
-    if (!u8c->is_char(' ')) fl_draw(u8c->text_utf8(), u8c->length(), X, baseline);
-    // 4) Strike or underline?
-    if (u8c->attrib() & Fl_Terminal::UNDERLINE) fl_line(X, underline_y, X+pwidth, underline_y);
-    if (u8c->attrib() & Fl_Terminal::STRIKEOUT) fl_line(X, strikeout_y, X+pwidth, strikeout_y);
     // Move to next char pixel position
     X += pwidth;
   }
+  if (run_len) draw_row_run(run, run_len, run_x, run_w, baseline, run_attr, run_fg);
 }
 
 /**
@@ -3748,6 +4113,11 @@ void Fl_Terminal::draw(void) {
        (hscrollbar->visible() && hscrollbar->h() != Fl::scrollbar_size()))) {
     update_scrollbar();
   }
+  // Only text changed since last draw? Redraw just the modified rows
+  if (can_draw_partial()) {
+    draw_partial();
+    return;
+  }
   // Draw group first, terminal last
   Fl_Group::draw();
   // Draw that little square between the scrollbars:
@@ -3781,6 +4151,103 @@ void Fl_Terminal::draw(void) {
     draw_buff(Y);
   }
   fl_pop_clip();
+  draw_done();
+}
+
+/**
+  Redraws the background and text of all display rows intersecting
+  FLTK coordinates \p Y to \p Y + \p H - 1.
+  Used for partial redraws; clipped to the given area.
+*/
+void Fl_Terminal::draw_rows(int Y, int H) const {
+  fl_push_clip(scrn_.x(), Y, scrn_.w(), H);
+  {
+    if (is_frame(box())) {
+      fl_color(Fl_Group::color());
+      fl_rectf(scrn_.x(), Y, scrn_.w(), H);
+    } else {
+      draw_box();                               // clipped to our area
+    }
+    const int rowheight = current_style_->fontheight();
+    int srow  = disp_srow() - scrollbar->value();
+    int first = (Y - scrn_.y()) / rowheight;
+    int last  = (Y + H - 1 - scrn_.y()) / rowheight;
+    for (int i=first; i<=last && i<disp_rows(); i++)
+      draw_row(srow + i, scrn_.y() + i * rowheight);
+  }
+  fl_pop_clip();
+}
+
+// fl_scroll() callback to draw the area uncovered by scrolling
+void Fl_Terminal::draw_rows_cb(void *udata, int X, int Y, int W, int H) {
+  (void)X; (void)W;
+  ((Fl_Terminal*)udata)->draw_rows(Y, H);
+}
+
+/**
+  Returns true if draw() only needs to redraw the rows modified since the
+  last draw(), i.e. if nothing but text output happened in the meantime.
+*/
+bool Fl_Terminal::can_draw_partial(void) const {
+  if (!drawn_.valid) return false;
+  if (damage() & ~(FL_DAMAGE_USER1|FL_DAMAGE_CHILD)) return false; // redraw() called?
+  int hscroll = hscrollbar->visible() ? hscrollbar->value() : 0;
+  return scrollbar->value() == 0 &&                       // not scrolled back into history
+         drawn_.scrn == scrn_ &&
+         drawn_.rows == disp_rows() &&
+         drawn_.cols == disp_cols() &&
+         drawn_.hscroll == hscroll &&
+         drawn_.font == current_style_->fontface() &&
+         drawn_.size == current_style_->fontsize() &&
+         drawn_.color == Fl_Group::color();
+}
+
+/**
+  Redraws only the display rows modified since the last draw(), and the
+  rows of the old and new cursor positions. If the text scrolled up since,
+  the pixels on screen are moved with fl_scroll() instead of redrawing them.
+*/
+void Fl_Terminal::draw_partial(void) {
+  // Scrollbars changed? (e.g. new history rows)
+  if (damage() & FL_DAMAGE_CHILD) {
+    update_child(*scrollbar);
+    update_child(*hscrollbar);
+  }
+  const int rowheight = current_style_->fontheight();
+  int scrolled = ring_.scrolled();                        // -1 if unknown
+  fl_push_clip(scrn_.x(), scrn_.y(), scrn_.w(), scrn_.h());
+  if (scrolled < 0 || scrolled >= disp_rows()) {
+    draw_rows(scrn_.y(), scrn_.h());                      // all rows changed
+  } else {
+    if (scrolled > 0)
+      fl_scroll(scrn_.x(), scrn_.y(), scrn_.w(), scrn_.h(),
+                0, -scrolled * rowheight, draw_rows_cb, this);
+    int old_cursor_row = drawn_.cursor_row - scrolled;
+    for (int drow=0; drow<disp_rows(); drow++) {
+      if (drow == cursor_.row() || drow == old_cursor_row ||
+          ring_.is_dirty_ring_row(disp_srow() + drow))
+        draw_rows(scrn_.y() + drow * rowheight, rowheight);
+    }
+  }
+  fl_pop_clip();
+  draw_done();
+}
+
+/**
+  Remembers the state of the screen after drawing, and flags all
+  rows as unmodified. See can_draw_partial().
+*/
+void Fl_Terminal::draw_done(void) {
+  drawn_.valid      = (scrollbar->value() == 0);
+  drawn_.scrn       = scrn_;
+  drawn_.rows       = disp_rows();
+  drawn_.cols       = disp_cols();
+  drawn_.hscroll    = hscrollbar->visible() ? hscrollbar->value() : 0;
+  drawn_.font       = current_style_->fontface();
+  drawn_.size       = current_style_->fontsize();
+  drawn_.color      = Fl_Group::color();
+  drawn_.cursor_row = cursor_.row();
+  ring_.clear_dirty();
 }
 
 /**
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <FL/fl_utf8.h>
 #include <FL/fl_string_functions.h>
 #include "flstring.h"
@@ -65,6 +66,57 @@ static int min(int i1, int i2)
 
 #endif
 
+/*
+ Return a pointer to the last byte c in the n bytes starting at s, or NULL.
+ This is the backwards version of memchr() which is not available on all
+ platforms. It compares eight bytes at a time, which is much faster than
+ a byte loop when searching for newlines in long lines of text.
+ */
+static const char *rfind_byte(const char *s, size_t n, char c)
+{
+  const unsigned char *p = (const unsigned char *)s + n;
+  const unsigned char uc = (unsigned char)c;
+  // compare single bytes until p is aligned
+  while (n && ((uintptr_t)p & 7)) {
+    --p; --n;
+    if (*p == uc) return (const char *)p;
+  }
+  // skip eight bytes at a time until a word contains c
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+  const uint64_t pattern = ones * uc;
+  while (n >= 8) {
+    uint64_t w;
+    memcpy(&w, p - 8, 8);
+    w ^= pattern;
+    if ((w - ones) & ~w & highs)
+      break;
+    p -= 8; n -= 8;
+  }
+  // find the exact position
+  while (n) {
+    --p; --n;
+    if (*p == uc) return (const char *)p;
+  }
+  return NULL;
+}
+
+
+/*
+ Return the number of bytes c in the n bytes starting at s.
+ */
+static int count_bytes(const char *s, size_t n, char c)
+{
+  int count = 0;
+  const char *e = s + n;
+  while (s < e && (s = (const char *)memchr(s, c, e - s))) {
+    count++;
+    s++;
+  }
+  return count;
+}
+
+
 /*
  Undo/Redo is handled with Fl_Text_Undo_Action. The names of the class members
  relate to the original action.
@@ -194,6 +246,128 @@ public:
   void unlock() { locked_ = false; }
 };
 
+/*
+ The optional line index stores the byte offsets of all newline characters
+ in the buffer in ascending order, so that line numbers and positions can be
+ converted with a binary search instead of scanning the text.
+
+ Like the text buffer itself, the offset array has a gap at the position of
+ the most recent edit. Entries before the gap are absolute buffer positions,
+ entries after the gap are stored as the distance to the end of the buffer.
+ Inserting or removing text therefore only moves the gap and adds or drops
+ the affected entries, but never touches the offsets of the lines that follow.
+
+ All methods take the current buffer length `len` as a parameter because the
+ index does not keep a reference to the buffer.
+ */
+class Fl_Text_Line_Index {
+  int *pos_;          // newline offsets, with a gap between gap_start_ and gap_end_
+  int capacity_;      // number of allocated entries
+  int count_;         // number of newlines in the buffer
+  int gap_start_;     // index of the first unused entry
+  int gap_end_;       // index of the first entry after the gap
+public:
+  Fl_Text_Line_Index() :
+    pos_(NULL),
+    capacity_(0),
+    count_(0),
+    gap_start_(0),
+    gap_end_(0)
+  { }
+
+  ~Fl_Text_Line_Index() {
+    if (pos_)
+      ::free(pos_);
+  }
+
+  // Number of newline characters in the buffer.
+  int count() const {
+    return count_;
+  }
+
+  // Byte offset of the newline with index n (0 <= n < count()).
+  int at(int n, int len) const {
+    return (n < gap_start_) ? pos_[n] : len - pos_[n + gap_end_ - gap_start_];
+  }
+
+  // Number of newline characters before byte offset pos.
+  int lines_before(int pos, int len) const {
+    int lo = 0, hi = count_;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (at(mid, len) < pos)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  // Discard all entries and index the text in the two segments given.
+  void rebuild(const char *a, int a_len, const char *b, int b_len) {
+    count_ = gap_start_ = 0;
+    gap_end_ = capacity_;
+    add_lines(a, a_len, 0);
+    add_lines(b, b_len, a_len);
+  }
+
+  // Call this before the buffer inserts n bytes of text at pos.
+  void insert(int pos, const char *text, int n, int len) {
+    move_gap(lines_before(pos, len), len);
+    add_lines(text, n, pos);
+  }
+
+  // Call this before the buffer removes the text between start and end.
+  void remove(int start, int end, int len) {
+    int first = lines_before(start, len);
+    int n = lines_before(end, len) - first;
+    move_gap(first, len);
+    gap_end_ += n;
+    count_ -= n;
+  }
+
+private:
+
+  // Move the gap so that it starts in front of entry n.
+  void move_gap(int n, int len) {
+    int gap_len = gap_end_ - gap_start_;
+    if (n < gap_start_) {
+      for (int i = gap_start_ - 1; i >= n; i--)
+        pos_[i + gap_len] = len - pos_[i];
+    } else {
+      for (int i = gap_start_; i < n; i++)
+        pos_[i] = len - pos_[i + gap_len];
+    }
+    gap_end_ += n - gap_start_;
+    gap_start_ = n;
+  }
+
+  // Make room for at least n more entries in the gap.
+  void reserve(int n) {
+    if (gap_end_ - gap_start_ >= n)
+      return;
+    int tail = capacity_ - gap_end_;
+    int new_capacity = count_ + n + (count_ / 2) + 1024;
+    int *new_pos = (int *)realloc(pos_, new_capacity * sizeof(int));
+    memmove(new_pos + new_capacity - tail, new_pos + gap_end_, tail * sizeof(int));
+    pos_ = new_pos;
+    gap_end_ = new_capacity - tail;
+    capacity_ = new_capacity;
+  }
+
+  // Add the newlines found in text, which starts at byte offset pos, to the
+  // front of the gap.
+  void add_lines(const char *text, int n, int pos) {
+    const char *p = text, *e = text + n;
+    while (p < e && (p = (const char *)memchr(p, '\n', e - p))) {
+      reserve(1);
+      pos_[gap_start_++] = pos + (int)(p - text);
+      count_++;
+      p++;
+    }
+  }
+};
+
 
 static void def_transcoding_warning_action(Fl_Text_Buffer *text)
 {
@@ -228,6 +402,7 @@ Fl_Text_Buffer::Fl_Text_Buffer(int requestedSize, int preferredGapSize)
   mUndo = new Fl_Text_Undo_Action();
   mUndoList = new Fl_Text_Undo_Action_List();
   mRedoList = new Fl_Text_Undo_Action_List();
+  mLineIndex = NULL;
   input_file_was_transcoded = 0;
   transcoding_warning_action = def_transcoding_warning_action;
 }
@@ -250,6 +425,7 @@ Fl_Text_Buffer::~Fl_Text_Buffer()
   delete mUndo;
   delete mUndoList;
   delete mRedoList;
+  delete mLineIndex;
 }
 
 
@@ -306,6 +482,8 @@ void Fl_Text_Buffer::text(const char *t)
   mGapStart = insertedLength;
   mGapEnd = mGapStart + mPreferredGapSize;
   memcpy(mBuf, t, insertedLength);
+  if (mLineIndex)
+    mLineIndex->rebuild(mBuf, mLength, NULL, 0);
 
   /* Zero all of the existing selections */
   update_selections(0, deletedLength, 0);
@@ -565,6 +743,8 @@ void Fl_Text_Buffer::copy(Fl_Text_Buffer * fromBuf, int fromStart,
     memcpy(&mBuf[toPos + part1Length],
            &fromBuf->mBuf[fromBuf->mGapEnd], copiedLength - part1Length);
   }
+  if (mLineIndex)
+    mLineIndex->insert(toPos, &mBuf[toPos], copiedLength, mLength);
   mGapStart += copiedLength;
   mLength += copiedLength;
   update_selections(toPos, 0, copiedLength);
@@ -724,6 +904,23 @@ void Fl_Text_Buffer::tab_distance(int tabDist)
 }
 
 
+/*
+ Create or delete the line index.
+ Creating the index scans the buffer once, after that the index is updated
+ with every insertion and deletion.
+ */
+void Fl_Text_Buffer::line_index(int enable)
+{
+  if (!enable) {
+    delete mLineIndex;
+    mLineIndex = NULL;
+  } else if (!mLineIndex) {
+    mLineIndex = new Fl_Text_Line_Index();
+    mLineIndex->rebuild(mBuf, mGapStart, mBuf + mGapEnd, mLength - mGapStart);
+  }
+}
+
+
 /*
  Select a range of text.
  Start and End must be at a character boundary.
@@ -1055,6 +1252,10 @@ char *Fl_Text_Buffer::line_text(int pos) const {
  */
 int Fl_Text_Buffer::line_start(int pos) const
 {
+  if (mLineIndex) {
+    int n = mLineIndex->lines_before(pos, mLength);
+    return n ? mLineIndex->at(n - 1, mLength) + 1 : 0;
+  }
   if (!findchar_backward(pos, '\n', &pos))
     return 0;
   return pos + 1;
@@ -1065,6 +1266,10 @@ int Fl_Text_Buffer::line_start(int pos) const
  Find the end of the line.
  */
 int Fl_Text_Buffer::line_end(int pos) const {
+  if (mLineIndex) {
+    int n = mLineIndex->lines_before(pos, mLength);
+    return (n < mLineIndex->count()) ? mLineIndex->at(n, mLength) : mLength;
+  }
   if (!findchar_forward(pos, '\n', &pos))
     pos = mLength;
   return pos;
@@ -1160,23 +1365,29 @@ int Fl_Text_Buffer::count_lines(int startPos, int endPos) const {
   IS_UTF8_ALIGNED2(this, (startPos))
   IS_UTF8_ALIGNED2(this, (endPos))
 
+  if (mLineIndex) {
+    if (endPos < startPos || endPos > mLength) endPos = mLength;
+    if (startPos >= endPos) return 0;
+    return mLineIndex->lines_before(endPos, mLength)
+         - mLineIndex->lines_before(startPos, mLength);
+  }
+
+  if (endPos < startPos || endPos > mLength)
+    endPos = mLength;
+  if (startPos < 0)
+    startPos = 0;
+  if (startPos >= endPos)
+    return 0;
+
   int gapLen = mGapEnd - mGapStart;
   int lineCount = 0;
 
-  int pos = startPos;
-  while (pos < mGapStart)
-  {
-    if (pos == endPos)
-      return lineCount;
-    if (mBuf[pos++] == '\n')
-      lineCount++;
-  }
-  while (pos < mLength) {
-    if (pos == endPos)
-      return lineCount;
-    if (mBuf[pos++ + gapLen] == '\n')
-      lineCount++;
+  if (startPos < mGapStart) {
+    lineCount += count_bytes(mBuf + startPos, min(endPos, mGapStart) - startPos, '\n');
+    startPos = mGapStart;
   }
+  if (startPos < endPos)
+    lineCount += count_bytes(mBuf + startPos + gapLen, endPos - startPos, '\n');
   return lineCount;
 }
 
@@ -1190,35 +1401,38 @@ int Fl_Text_Buffer::estimate_lines(int startPos, int endPos, int lineLen) const
   IS_UTF8_ALIGNED2(this, (startPos))
   IS_UTF8_ALIGNED2(this, (endPos))
 
-  int gapLen = mGapEnd - mGapStart;
+  if (endPos < startPos || endPos > mLength)
+    endPos = mLength;
+  if (startPos < 0)
+    startPos = 0;
+  if (lineLen < 1)
+    lineLen = 1;
+
+  /* Jump from newline to newline and compute the soft line breaks of each
+   run of text arithmetically instead of counting down per character. */
   int lineCount = 0;
   int softLineBreaks = 0, softLineBreakCount = lineLen;
 
   int pos = startPos;
-  while (pos < mGapStart)
-  {
-    if (pos == endPos)
-      return lineCount + softLineBreaks;
-    if (mBuf[pos++] == '\n') {
-      softLineBreakCount = lineLen;
-      lineCount++;
-    }
-    if (--softLineBreakCount == 0) {
-      softLineBreakCount = lineLen;
-      softLineBreaks++;
-    }
-  }
-  while (pos < mLength) {
-    if (pos == endPos)
-      return lineCount + softLineBreaks;
-    if (mBuf[pos++ + gapLen] == '\n') {
-      softLineBreakCount = lineLen;
-      lineCount++;
+  while (pos < endPos) {
+    int nl = find_byte_forward(pos, endPos, '\n');
+    int n = (nl < 0 ? endPos : nl) - pos;
+    if (n >= softLineBreakCount) {
+      n -= softLineBreakCount;
+      softLineBreaks += 1 + n / lineLen;
+      softLineBreakCount = lineLen - n % lineLen;
+    } else {
+      softLineBreakCount -= n;
     }
-    if (--softLineBreakCount == 0) {
-      softLineBreakCount = lineLen;
+    if (nl < 0)
+      break;
+    // the newline itself is the first character counted on the new line
+    lineCount++;
+    if (lineLen == 1)
       softLineBreaks++;
-    }
+    else
+      softLineBreakCount = lineLen - 1;
+    pos = nl + 1;
   }
   return lineCount + softLineBreaks;
 }
@@ -1235,26 +1449,17 @@ int Fl_Text_Buffer::skip_lines(int startPos, int nLines) const
   if (nLines == 0)
     return startPos;
 
-  int gapLen = mGapEnd - mGapStart;
-  int pos = startPos;
-  int lineCount = 0;
-  while (pos < mGapStart) {
-    if (mBuf[pos++] == '\n') {
-      lineCount++;
-      if (lineCount == nLines) {
-        IS_UTF8_ALIGNED2(this, (pos))
-        return pos;
-      }
-    }
+  if (mLineIndex && nLines > 0) {
+    int n = mLineIndex->lines_before(startPos, mLength) + nLines - 1;
+    return (n < mLineIndex->count()) ? mLineIndex->at(n, mLength) + 1 : mLength;
   }
-  while (pos < mLength) {
-    if (mBuf[pos++ + gapLen] == '\n') {
-      lineCount++;
-      if (lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos))
-        return pos;
-      }
-    }
+
+  int pos = startPos;
+  for (int lineCount = 0; lineCount < nLines; lineCount++) {
+    pos = find_byte_forward(pos, mLength, '\n');
+    if (pos < 0)
+      return mLength;
+    pos++;
   }
   IS_UTF8_ALIGNED2(this, (pos))
   return pos;
@@ -1274,25 +1479,248 @@ int Fl_Text_Buffer::rewind_lines(int startPos, int nLines) const
   if (pos <= 0)
     return 0;
 
+  if (mLineIndex) {
+    int n = mLineIndex->lines_before(pos + 1, mLength) - 1 - nLines;
+    return (n >= 0) ? mLineIndex->at(n, mLength) + 1 : 0;
+  }
+
+  pos++;
+  for (int lineCount = -1; lineCount < nLines; lineCount++) {
+    pos = find_byte_backward(0, pos, '\n');
+    if (pos < 0)
+      return 0;
+  }
+  IS_UTF8_ALIGNED2(this, (pos+1))
+  return pos + 1;
+}
+
+
+/*
+ Fl_Text_Search_Pattern holds a search string that was prepared once for
+ fast matching against the text buffer.
+
+ Case sensitive searches compare bytes. They use the Boyer-Moore-Horspool
+ algorithm which skips ahead by up to the length of the search string after
+ a mismatch. Matching bytes of valid UTF-8 always start at a character
+ boundary, so no decoding is needed at all.
+
+ Case insensitive searches compare the lower case Unicode characters of the
+ text with the search string which is converted to lower case only once.
+ ASCII text is folded with a lookup table, and only non-ASCII characters
+ are decoded.
+ */
+class Fl_Text_Search_Pattern {
+public:
+  const unsigned char *needle;  // search string
+  int len;                      // length of search string in bytes
+  int matchCase;                // compare bytes if set, lower case characters otherwise
+  int skip[256];                // Horspool shift for forward searches
+  int rskip[256];               // Horspool shift for backward searches
+  unsigned char fold[128];      // lower case ASCII characters
+  unsigned int *folded;         // search string in lower case UCS-4 characters
+  int nFolded;                  // number of characters in folded
+
+  Fl_Text_Search_Pattern(const char *searchString, int caseSensitive) :
+    needle((const unsigned char *)searchString),
+    len((int)strlen(searchString)),
+    matchCase(caseSensitive),
+    folded(NULL),
+    nFolded(0)
+  {
+    if (matchCase) {
+      for (int i = 0; i < 256; i++)
+        skip[i] = rskip[i] = len;
+      for (int i = 0; i < len - 1; i++)
+        skip[needle[i]] = len - 1 - i;
+      for (int i = len - 1; i > 0; i--)
+        rskip[needle[i]] = i;
+    } else {
+      for (int i = 0; i < 128; i++)
+        fold[i] = (unsigned char)fl_tolower(i);
+      folded = new unsigned int[len + 1];
+      const char *sp = searchString, *se = searchString + len;
+      while (sp < se) {
+        int n;
+        folded[nFolded++] = fl_tolower(fl_utf8decode(sp, se, &n));
+        sp += n;
+      }
+    }
+  }
+
+  ~Fl_Text_Search_Pattern() {
+    delete[] folded;
+  }
+
+  // Return the offset of the first match in hay, or -1.
+  int find_forward(const char *text, int n) const {
+    const unsigned char *hay = (const unsigned char *)text;
+    if (len == 1) {
+      const void *p = memchr(hay, needle[0], n);
+      return p ? (int)((const unsigned char *)p - hay) : -1;
+    }
+    const unsigned char last = needle[len - 1];
+    for (int i = 0; i <= n - len; i += skip[hay[i + len - 1]]) {
+      if (hay[i + len - 1] == last && memcmp(hay + i, needle, len - 1) == 0)
+        return i;
+    }
+    return -1;
+  }
+
+  // Return the offset of the last match in hay, or -1.
+  int find_backward(const char *text, int n) const {
+    const unsigned char *hay = (const unsigned char *)text;
+    const unsigned char first = needle[0];
+    for (int i = n - len; i >= 0; i -= rskip[hay[i]]) {
+      if (hay[i] == first && memcmp(hay + i + 1, needle + 1, len - 1) == 0)
+        return i;
+    }
+    return -1;
+  }
+};
+
+
+/*
+ Return 1 if the search pattern matches the text at pos. The position after
+ the matching text is returned in foundEnd.
+ */
+int Fl_Text_Buffer::match_(int pos, const Fl_Text_Search_Pattern &pat, int *foundEnd) const
+{
+  if (pat.matchCase) {
+    if (pos < 0 || pos + pat.len > mLength)
+      return 0;
+    for (int i = 0; i < pat.len; i++) {
+      if ((unsigned char)byte_at(pos + i) != pat.needle[i])
+        return 0;
+    }
+    *foundEnd = pos + pat.len;
+    return 1;
+  }
+  for (int i = 0; i < pat.nFolded; i++) {
+    if (pos >= mLength)
+      return 0;
+    unsigned char c = (unsigned char)byte_at(pos);
+    unsigned int u;
+    if (c < 0x80) {
+      u = pat.fold[c];
+      pos++;
+    } else {
+      int len = fl_utf8len1(c);
+      u = fl_tolower(char_at(pos));
+      pos += (len > 0) ? len : 1;
+    }
+    if (u != pat.folded[i])
+      return 0;
+  }
+  *foundEnd = pos;
+  return 1;
+}
+
+
+/*
+ Find the first match of the search pattern at or after startPos.
+ */
+int Fl_Text_Buffer::search_forward_(int startPos, const Fl_Text_Search_Pattern &pat,
+                                    int *foundPos, int *foundEnd) const
+{
+  if (startPos < 0)
+    startPos = 0;
   int gapLen = mGapEnd - mGapStart;
-  int lineCount = -1;
-  while (pos >= mGapStart) {
-    if (mBuf[pos + gapLen] == '\n') {
-      if (++lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos+1))
-        return pos + 1;
+  if (pat.matchCase) {
+    // text before the gap
+    if (startPos < mGapStart) {
+      int i = pat.find_forward(mBuf + startPos, mGapStart - startPos);
+      if (i >= 0) {
+        *foundPos = startPos + i;
+        *foundEnd = startPos + i + pat.len;
+        return 1;
+      }
+      // matches that span the gap
+      for (int pos = max(startPos, mGapStart - pat.len + 1); pos < mGapStart; pos++) {
+        if (match_(pos, pat, foundEnd)) {
+          *foundPos = pos;
+          return 1;
+        }
       }
     }
-    pos--;
+    // text after the gap
+    int pos = max(startPos, mGapStart);
+    if (pos < mLength) {
+      int i = pat.find_forward(mBuf + pos + gapLen, mLength - pos);
+      if (i >= 0) {
+        *foundPos = pos + i;
+        *foundEnd = pos + i + pat.len;
+        return 1;
+      }
+    }
+    return 0;
+  }
+  unsigned int first = pat.folded[0];
+  for (int pos = startPos; pos < mLength; pos++) {
+    unsigned char c = (unsigned char)mBuf[pos < mGapStart ? pos : pos + gapLen];
+    if (c < 0x80) {
+      if (pat.fold[c] != first)
+        continue;
+    } else if (fl_utf8_is_continuation(c)) {
+      continue;
+    }
+    if (match_(pos, pat, foundEnd)) {
+      *foundPos = pos;
+      return 1;
+    }
   }
-  while (pos >= 0) {
-    if (mBuf[pos] == '\n') {
-      if (++lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos+1))
-        return pos + 1;
+  return 0;
+}
+
+
+/*
+ Find the last match of the search pattern that starts at or before startPos.
+ */
+int Fl_Text_Buffer::search_backward_(int startPos, const Fl_Text_Search_Pattern &pat,
+                                     int *foundPos, int *foundEnd) const
+{
+  if (startPos >= mLength)
+    startPos = mLength - 1;
+  int gapLen = mGapEnd - mGapStart;
+  if (pat.matchCase) {
+    // text after the gap
+    if (startPos >= mGapStart) {
+      int n = min(mLength, startPos + pat.len) - mGapStart;
+      int i = pat.find_backward(mBuf + mGapEnd, n);
+      if (i >= 0) {
+        *foundPos = mGapStart + i;
+        *foundEnd = mGapStart + i + pat.len;
+        return 1;
       }
     }
-    pos--;
+    // matches that span the gap
+    for (int pos = min(startPos, mGapStart - 1); pos > mGapStart - pat.len && pos >= 0; pos--) {
+      if (match_(pos, pat, foundEnd)) {
+        *foundPos = pos;
+        return 1;
+      }
+    }
+    // text before the gap
+    int i = pat.find_backward(mBuf, min(mGapStart, startPos + pat.len));
+    if (i >= 0) {
+      *foundPos = i;
+      *foundEnd = i + pat.len;
+      return 1;
+    }
+    return 0;
+  }
+  unsigned int first = pat.folded[0];
+  for (int pos = startPos; pos >= 0; pos--) {
+    unsigned char c = (unsigned char)mBuf[pos < mGapStart ? pos : pos + gapLen];
+    if (c < 0x80) {
+      if (pat.fold[c] != first)
+        continue;
+    } else if (fl_utf8_is_continuation(c)) {
+      continue;
+    }
+    if (match_(pos, pat, foundEnd)) {
+      *foundPos = pos;
+      return 1;
+    }
   }
   return 0;
 }
@@ -1307,105 +1735,67 @@ int Fl_Text_Buffer::search_forward(int startPos, const char *searchString,
   IS_UTF8_ALIGNED2(this, (startPos))
   IS_UTF8_ALIGNED(searchString)
 
-  if (!searchString)
+  if (!searchString || startPos >= length())
     return 0;
-  int bp;
-  const char *sp;
-  if (matchCase) {
-    while (startPos < length()) {
-      bp = startPos;
-      sp = searchString;
-      for (;;) {
-        char c = *sp;
-        // we reached the end of the "needle", so we found the string!
-        if (!c) {
-          *foundPos = startPos;
-          return 1;
-        }
-        int len = fl_utf8len1(c);
-        if (memcmp(sp, address(bp), len))
-          break;
-        sp += len; bp += len;
-      }
-      startPos = next_char(startPos);
-    }
-  } else {
-    while (startPos < length()) {
-      bp = startPos;
-      sp = searchString;
-      for (;;) {
-        // we reached the end of the "needle", so we found the string!
-        if (!*sp) {
-          *foundPos = startPos;
-          return 1;
-        }
-        int len;
-        unsigned int b = char_at(bp);
-        unsigned int s = fl_utf8decode(sp, 0, &len);
-        if (fl_tolower(b)!=fl_tolower(s))
-          break;
-        sp += len;
-        bp = next_char(bp);
-      }
-      startPos = next_char(startPos);
-    }
+  if (!*searchString) {
+    *foundPos = startPos;
+    return 1;
   }
-  return 0;
+  Fl_Text_Search_Pattern pat(searchString, matchCase);
+  int foundEnd;
+  return search_forward_(startPos, pat, foundPos, &foundEnd);
 }
 
+
+/*
+ Find a matching string in the buffer, searching backwards.
+ */
 int Fl_Text_Buffer::search_backward(int startPos, const char *searchString,
                                     int *foundPos, int matchCase) const
 {
   IS_UTF8_ALIGNED2(this, (startPos))
   IS_UTF8_ALIGNED(searchString)
 
-  if (!searchString)
+  if (!searchString || startPos < 0)
     return 0;
-  int bp;
-  const char *sp;
-  if (matchCase) {
-    while (startPos >= 0) {
-      bp = startPos;
-      sp = searchString;
-      for (;;) {
-        char c = *sp;
-        // we reached the end of the "needle", so we found the string!
-        if (!c) {
-          *foundPos = startPos;
-          return 1;
-        }
-        int len = fl_utf8len1(c);
-        if (memcmp(sp, address(bp), len))
-          break;
-        sp += len; bp += len;
-      }
-      startPos = prev_char(startPos);
-    }
-  } else {
-    while (startPos >= 0) {
-      bp = startPos;
-      sp = searchString;
-      for (;;) {
-        // we reached the end of the "needle", so we found the string!
-        if (!*sp) {
-          *foundPos = startPos;
-          return 1;
-        }
-        int len;
-        unsigned int b = char_at(bp);
-        unsigned int s = fl_utf8decode(sp, 0, &len);
-        if (fl_tolower(b)!=fl_tolower(s))
-          break;
-        sp += len;
-        bp = next_char(bp);
-      }
-      startPos = prev_char(startPos);
-    }
+  if (!*searchString) {
+    *foundPos = startPos;
+    return 1;
   }
-  return 0;
+  Fl_Text_Search_Pattern pat(searchString, matchCase);
+  int foundEnd;
+  return search_backward_(startPos, pat, foundPos, &foundEnd);
 }
 
 
+/*
+ Find all non-overlapping matches of a string in a range of the buffer.
+ */
+int Fl_Text_Buffer::search_all(const char *searchString,
+                               std::vector<Fl_Text_Selection> &matches,
+                               int matchCase, int startPos, int endPos) const
+{
+  IS_UTF8_ALIGNED2(this, (startPos))
+  IS_UTF8_ALIGNED(searchString)
+
+  matches.clear();
+  if (!searchString || !*searchString)
+    return 0;
+  if (endPos < 0 || endPos > mLength)
+    endPos = mLength;
+  Fl_Text_Search_Pattern pat(searchString, matchCase);
+  int pos = startPos, foundPos, foundEnd;
+  while (pos < endPos && search_forward_(pos, pat, &foundPos, &foundEnd)) {
+    if (foundEnd > endPos)
+      break;
+    Fl_Text_Selection sel;
+    sel.set(foundPos, foundEnd);
+    matches.push_back(sel);
+    pos = foundEnd;
+  }
+  return (int)matches.size();
+}
+
 
 /*
  Insert a string into the buffer.
@@ -1430,6 +1820,21 @@ int Fl_Text_Buffer::insert_(int pos, const char *text, int insertedLength)
 
   /* Insert the new text (pos now corresponds to the start of the gap) */
   memcpy(&mBuf[pos], text, insertedLength);
+  insert_gap_text_(pos, insertedLength);
+
+  return insertedLength;
+}
+
+
+/*
+ Add text that was copied to the start of the gap to the buffer.
+ Updates the line index, selections, and undo information, but does not
+ call any callbacks.
+ */
+void Fl_Text_Buffer::insert_gap_text_(int pos, int insertedLength)
+{
+  if (mLineIndex)
+    mLineIndex->insert(pos, &mBuf[pos], insertedLength, mLength);
   mGapStart += insertedLength;
   mLength += insertedLength;
   update_selections(pos, 0, insertedLength);
@@ -1454,8 +1859,6 @@ int Fl_Text_Buffer::insert_(int pos, const char *text, int insertedLength)
     mUndo->undoat = pos + insertedLength;
     mUndo->undocut = 0;
   }
-
-  return insertedLength;
 }
 
 
@@ -1503,6 +1906,9 @@ void Fl_Text_Buffer::remove_(int start, int end)
     }
   }
 
+  if (mLineIndex)
+    mLineIndex->remove(start, end, mLength);
+
   /* expand the gap to encompass the deleted characters */
   mGapEnd += end - mGapStart;
   mGapStart = start;
@@ -1826,6 +2232,13 @@ int Fl_Text_Buffer::findchar_forward(int startPos, unsigned searchChar,
   if (startPos<0)
     startPos = 0;
 
+  // ASCII characters never occur inside a UTF-8 sequence, search bytes
+  if (searchChar < 0x80) {
+    int pos = find_byte_forward(startPos, mLength, (char)searchChar);
+    *foundPos = (pos < 0) ? mLength : pos;
+    return (pos >= 0);
+  }
+
   for ( ; startPos<mLength; startPos = next_char(startPos)) {
     if (searchChar == char_at(startPos)) {
       *foundPos = startPos;
@@ -1852,6 +2265,13 @@ int Fl_Text_Buffer::findchar_backward(int startPos, unsigned int searchChar,
   if (startPos > mLength)
     startPos = mLength;
 
+  // ASCII characters never occur inside a UTF-8 sequence, search bytes
+  if (searchChar < 0x80) {
+    int pos = find_byte_backward(0, startPos, (char)searchChar);
+    *foundPos = (pos < 0) ? 0 : pos;
+    return (pos >= 0);
+  }
+
   for (startPos = prev_char(startPos); startPos>=0; startPos = prev_char(startPos)) {
     if (searchChar == char_at(startPos)) {
       *foundPos = startPos;
@@ -1863,6 +2283,55 @@ int Fl_Text_Buffer::findchar_backward(int startPos, unsigned int searchChar,
   return 0;
 }
 
+/*
+ Find the first byte c between start and end, skipping the gap.
+ Returns -1 if the byte was not found.
+ */
+int Fl_Text_Buffer::find_byte_forward(int start, int end, char c) const
+{
+  if (start < mGapStart) {
+    int n = min(end, mGapStart) - start;
+    if (n > 0) {
+      const char *p = (const char *)memchr(mBuf + start, c, n);
+      if (p)
+        return (int)(p - mBuf);
+    }
+    start = mGapStart;
+  }
+  if (start < end) {
+    int gapLen = mGapEnd - mGapStart;
+    const char *p = (const char *)memchr(mBuf + start + gapLen, c, end - start);
+    if (p)
+      return (int)(p - mBuf) - gapLen;
+  }
+  return -1;
+}
+
+
+/*
+ Find the last byte c between start and end, skipping the gap.
+ Returns -1 if the byte was not found.
+ */
+int Fl_Text_Buffer::find_byte_backward(int start, int end, char c) const
+{
+  if (end > mGapStart) {
+    int gapLen = mGapEnd - mGapStart;
+    int s = max(start, mGapStart);
+    if (end > s) {
+      const char *p = rfind_byte(mBuf + s + gapLen, end - s, c);
+      if (p)
+        return (int)(p - mBuf) - gapLen;
+    }
+    end = mGapStart;
+  }
+  if (end > start) {
+    const char *p = rfind_byte(mBuf + start, end - start, c);
+    if (p)
+      return (int)(p - mBuf);
+  }
+  return -1;
+}
+
 //#define EXAMPLE_ENCODING // shows how to process any encoding for which a decoding function exists
 #ifdef EXAMPLE_ENCODING
 
@@ -2013,6 +2482,47 @@ const char *Fl_Text_Buffer::file_encoding_warning_message =
     "of the input file which was not UTF-8 encoded.\n"
     "Some changes may have occurred.";
 
+/*
+ Fast path for insertfile().
+ If the file size is known, the file is read in one block right into the gap
+ of the buffer. If the text is valid UTF-8, it is added to the buffer as is,
+ and the callbacks are called only once. This avoids the transcoding filter
+ and repeated reallocation of the buffer for large files.
+
+ Returns 1 if the file was inserted, or 0 if the caller must read the file
+ with the transcoding filter. In that case the buffer is unchanged and fp
+ is rewound to the start of the file.
+ */
+int Fl_Text_Buffer::insertfile_utf8_(FILE *fp, int pos)
+{
+  if (fseek(fp, 0, SEEK_END) != 0)
+    return 0;
+  long size = ftell(fp);
+  if (fseek(fp, 0, SEEK_SET) != 0 || size <= 0 || size >= 0x7fffffff - mLength - mPreferredGapSize)
+    return 0;
+
+  /* Read the file into the gap at pos. The number of bytes read can be less
+   than size if the file is opened in text mode. */
+  if (size > mGapEnd - mGapStart)
+    reallocate_with_gap(pos, (int)size + mPreferredGapSize);
+  else if (pos != mGapStart)
+    move_gap(pos);
+  int len = (int)fread(&mBuf[pos], 1, size, fp);
+  if (ferror(fp) || len == 0 || getc(fp) != EOF || !fl_utf8test(&mBuf[pos], len)) {
+    clearerr(fp);
+    fseek(fp, 0, SEEK_SET);
+    return 0;
+  }
+
+  /* Insert and redisplay */
+  call_predelete_callbacks(pos, 0);
+  insert_gap_text_(pos, len);
+  mCursorPosHint = pos + len;
+  call_modify_callbacks(pos, 0, len, 0, NULL);
+  return 1;
+}
+
+
 /*
  Insert text from a file.
  Input file can be of various encodings according to what input fiter is used.
@@ -2024,10 +2534,21 @@ const char *Fl_Text_Buffer::file_encoding_warning_message =
   FILE *fp;
   if (!(fp = fl_fopen(file, "r")))
     return 1;
+  if (pos > mLength)
+    pos = mLength;
+  if (pos < 0)
+    pos = 0;
+  input_file_was_transcoded = false;
+#ifndef EXAMPLE_ENCODING
+  if (insertfile_utf8_(fp, pos)) {
+    int e = ferror(fp) ? 2 : 0;
+    fclose(fp);
+    return e;
+  }
+#endif
   char *buffer = new char[buflen + 1];
   char *endline, line[100];
   int len;
-  input_file_was_transcoded = false;
   endline = line;
   while (true) {
 #ifdef EXAMPLE_ENCODING
@@ -73,6 +73,14 @@
  stack in the draw_vline() method for drawing strings */
 #define MAX_DISP_LINE_LEN 1000
 
+/* In continuous wrap mode, wrapped lines of buffers larger than this are
+ estimated, except for the displayed lines. The exact counts are collected
+ in the background in chunks of about WRAP_COUNT_CHUNK bytes, spending at
+ most WRAP_COUNT_TIME seconds per idle call (see wrap_count_cb()). */
+#define WRAP_ESTIMATE_LENGTH 16384
+#define WRAP_COUNT_CHUNK 16384
+#define WRAP_COUNT_TIME 0.01
+
 static int max( int i1, int i2 );
 static int min( int i1, int i2 );
 static int countlines( const char *string );
@@ -161,6 +169,13 @@ Fl_Text_Display::Fl_Text_Display(int X, int Y, int W, int H, const char* l)
 
   display_needs_recalc_ = false;
 
+  mWrapCheckpoints = NULL;
+  mNWrapCheckpoints = 0;
+  mWrapCheckpointsSize = 0;
+  mWrapCountWidth = 0;
+  mWrapCountFont = FL_HELVETICA;
+  mWrapCountSize = FL_NORMAL_SIZE;
+
   scrollbar_width_ = 0;         // 0: default from Fl::scrollbar_size()
   scrollbar_align_ = FL_ALIGN_BOTTOM_RIGHT;
 
@@ -220,6 +235,8 @@ Fl_Text_Display::~Fl_Text_Display() {
     mBuffer->remove_predelete_callback(buffer_predelete_cb, this);
   }
   if (mLineStarts) delete[] mLineStarts;
+  wrap_count_reset();
+  if (mWrapCheckpoints) free(mWrapCheckpoints);
   if (linenumber_format_) {
     free((void*)linenumber_format_);
     linenumber_format_ = 0;
@@ -378,6 +395,7 @@ void Fl_Text_Display::buffer( Fl_Text_Buffer *buf ) {
     mBuffer->remove_modify_callback( buffer_modified_cb, this );
     mBuffer->remove_predelete_callback( buffer_predelete_cb, this );
   }
+  wrap_count_reset();
 
   /* Add the buffer to the display, and attach a callback to the buffer for
    receiving modification information when the buffer contents change */
@@ -448,6 +466,7 @@ void Fl_Text_Display::highlight_data(Fl_Text_Buffer *styleBuffer,
   mUnfinishedHighlightCB = unfinishedHighlightCB;
   mHighlightCBArg = cbArg;
   mColumnScale = 0;
+  wrap_count_reset();
 
   if (mStyleBuffer)
     mStyleBuffer->canUndo(0);
@@ -572,6 +591,7 @@ void Fl_Text_Display::recalc_display() {
 
     if (mContinuousWrap && !mWrapMarginPix && text_area.w != oldTAWidth) {
 
+      wrap_count_check();
       int oldFirstChar = mFirstChar;
       mFirstChar = line_start(mFirstChar);
       mTopLineNum = count_lines(0, mFirstChar, true)+1;
@@ -974,6 +994,7 @@ void Fl_Text_Display::wrap_mode(int wrap, int wrapMargin) {
 
   if (buffer()) {
     /* wrapping can change the total number of lines, re-count */
+    wrap_count_check();
     mNBufferLines = count_lines(0, buffer()->length(), true);
 
     /* changing wrap margins or changing from wrapped mode to non-wrapped
@@ -1465,9 +1486,21 @@ int Fl_Text_Display::count_lines(int startPos, int endPos,
    text display sometimes jumps 2 or 3 lines instead of 1, but the overall
    buffer stays intact as well as the scroll position.
    */
-  if (buffer()->length() > 16384) {
+  if (buffer()->length() > WRAP_ESTIMATE_LENGTH) {
     // Optimized line counting
     int nLines = 0;
+    // exact counts are known up to the last checkpoint of the background counter
+    int counted = wrap_count_valid() ? mWrapCheckpoints[2*(mNWrapCheckpoints-1)] : 0;
+    if (startPos < counted) {
+      if (!startPosIsLineStart)
+        startPos = buffer()->line_start(startPos);
+      int tmpEnd = endPos<counted ? endPos : counted;
+      nLines += wrapped_lines_before(tmpEnd) - wrapped_lines_before(startPos);
+      if (tmpEnd >= endPos)
+        return nLines;
+      startPos = tmpEnd;
+      startPosIsLineStart = true;
+    }
     int firstVisibleChar = buffer()->rewind_lines(mFirstChar, 3);
     int lastVisibleChar = buffer()->skip_lines(mLastChar, 3);
     // Calculate the averga number of characters up to a soft line break
@@ -1512,6 +1545,186 @@ int Fl_Text_Display::count_lines(int startPos, int endPos,
 }
 
 
+/*
+ Start or continue the background count of wrapped lines.
+
+ Called whenever the wrap width, text font, or text size may have changed.
+ If they differ from the ones the existing checkpoints were counted with,
+ counting starts over at the beginning of the buffer.
+ */
+void Fl_Text_Display::wrap_count_check() {
+  if (!mContinuousWrap || !buffer()) {
+    wrap_count_reset();
+    return;
+  }
+  int width = mWrapMarginPix ? mWrapMarginPix : text_area.w;
+  if (!mNWrapCheckpoints || width != mWrapCountWidth ||
+      textfont_ != mWrapCountFont || textsize_ != mWrapCountSize) {
+    if (!mWrapCheckpoints) {
+      mWrapCheckpointsSize = 64;
+      mWrapCheckpoints = (int*)malloc(2 * mWrapCheckpointsSize * sizeof(int));
+    }
+    mWrapCheckpoints[0] = 0;
+    mWrapCheckpoints[1] = 0;
+    mNWrapCheckpoints = 1;
+    mWrapCountWidth = width;
+    mWrapCountFont = textfont_;
+    mWrapCountSize = textsize_;
+  }
+  wrap_count_schedule();
+}
+
+/*
+ Discard all counted wrapped lines and stop the background counter.
+ */
+void Fl_Text_Display::wrap_count_reset() {
+  mNWrapCheckpoints = 0;
+  Fl::remove_idle(wrap_count_cb, this);
+}
+
+/*
+ Make sure the background counter runs if there is uncounted text left.
+ */
+void Fl_Text_Display::wrap_count_schedule() {
+  if (!mNWrapCheckpoints || !buffer())
+    return;
+  int len = buffer()->length();
+  if (len > WRAP_ESTIMATE_LENGTH &&
+      mWrapCheckpoints[2*(mNWrapCheckpoints-1)] < len &&
+      !Fl::has_idle(wrap_count_cb, this))
+    Fl::add_idle(wrap_count_cb, this);
+}
+
+/*
+ Keep the checkpoints in sync with a buffer modification.
+
+ The soft line breaks of a hard line depend on all of its text, so the
+ checkpoints inside the modified hard lines are dropped. Checkpoints before
+ them are unaffected, and checkpoints after them move by the number of bytes
+ and wrapped lines inserted. If this leaves a gap of more than two chunks,
+ the later checkpoints are dropped too and counted again in the background,
+ so that count_lines() never has to measure that much text at once.
+ */
+void Fl_Text_Display::wrap_count_update(int pos, int nInserted, int nDeleted, int nLines) {
+  if (!mNWrapCheckpoints)
+    return;
+  int first = buffer()->line_start(pos);
+  int last = buffer()->line_end(pos + nInserted);
+  int i = mNWrapCheckpoints;
+  while (i > 1 && mWrapCheckpoints[2*(i-1)] > first)
+    i--;
+  int j = i;
+  while (j < mNWrapCheckpoints && (mWrapCheckpoints[2*j] <= pos + nDeleted ||
+         mWrapCheckpoints[2*j] + nInserted - nDeleted <= last))
+    j++;
+  if (j < mNWrapCheckpoints &&
+      mWrapCheckpoints[2*j] + nInserted - nDeleted - mWrapCheckpoints[2*(i-1)] > 2 * WRAP_COUNT_CHUNK)
+    j = mNWrapCheckpoints;
+  for (int k = j; k < mNWrapCheckpoints; k++) {
+    mWrapCheckpoints[2*(i+k-j)] = mWrapCheckpoints[2*k] + nInserted - nDeleted;
+    mWrapCheckpoints[2*(i+k-j)+1] = mWrapCheckpoints[2*k+1] + nLines;
+  }
+  mNWrapCheckpoints -= j - i;
+  wrap_count_schedule();
+}
+
+/*
+ Count the wrapped lines of the next chunk of text and add a checkpoint.
+ Returns 0 when there is nothing left to count.
+
+ A chunk ends at the start of the display line that contains the byte
+ WRAP_COUNT_CHUNK bytes further on, which may be in the middle of a hard
+ line, so that a single huge line is also counted in several steps. The
+ last chunk ends at the end of the buffer and includes a last line
+ without a newline, like count_lines().
+ */
+int Fl_Text_Display::wrap_count_step() {
+  Fl_Text_Buffer *buf = buffer();
+  int len = buf->length();
+  int pos = mWrapCheckpoints[2*(mNWrapCheckpoints-1)];
+  if (pos >= len)
+    return 0;
+
+  int end, retPos, retLines, retLineStart, retLineEnd;
+  if (len - pos <= WRAP_COUNT_CHUNK) {
+    wrapped_line_counter(buf, pos, len, INT_MAX, true, 0,
+                         &retPos, &retLines, &retLineStart, &retLineEnd);
+    end = len;
+  } else {
+    wrapped_line_counter(buf, pos, buf->utf8_align(pos + WRAP_COUNT_CHUNK), INT_MAX,
+                         true, 0, &retPos, &retLines, &retLineStart, &retLineEnd);
+    end = retLineStart;
+    if (end <= pos) {   // display line longer than a chunk: end after it
+      wrapped_line_counter(buf, pos, len, 1, true, 0,
+                           &retPos, &retLines, &retLineStart, &retLineEnd);
+      end = retPos;
+    }
+  }
+
+  if (mNWrapCheckpoints == mWrapCheckpointsSize) {
+    mWrapCheckpointsSize *= 2;
+    mWrapCheckpoints = (int*)realloc(mWrapCheckpoints, 2 * mWrapCheckpointsSize * sizeof(int));
+  }
+  mWrapCheckpoints[2*mNWrapCheckpoints] = end;
+  mWrapCheckpoints[2*mNWrapCheckpoints+1] = mWrapCheckpoints[2*(mNWrapCheckpoints-1)+1] + retLines;
+  mNWrapCheckpoints++;
+  return end < len;
+}
+
+/*
+ Return true if the checkpoints match the current wrap width and font.
+ */
+int Fl_Text_Display::wrap_count_valid() const {
+  if (!mNWrapCheckpoints || !mContinuousWrap)
+    return 0;
+  int width = mWrapMarginPix ? mWrapMarginPix : text_area.w;
+  return width == mWrapCountWidth && textfont_ == mWrapCountFont &&
+         textsize_ == mWrapCountSize;
+}
+
+/*
+ Return the number of wrapped lines before the display line starting at
+ \p pos, which must not be past the last checkpoint. Only the text between
+ the checkpoint before \p pos and \p pos is measured.
+ */
+int Fl_Text_Display::wrapped_lines_before(int pos) const {
+  int lo = 0, hi = mNWrapCheckpoints - 1;
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (mWrapCheckpoints[2*mid] <= pos)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  int start = mWrapCheckpoints[2*lo];
+  if (pos == start)
+    return mWrapCheckpoints[2*lo+1];
+  int retPos, retLines, retLineStart, retLineEnd;
+  wrapped_line_counter(buffer(), start, pos, INT_MAX, true, 0,
+                       &retPos, &retLines, &retLineStart, &retLineEnd);
+  return mWrapCheckpoints[2*lo+1] + retLines;
+}
+
+/*
+ Idle callback that counts wrapped lines in time slices. When done, the
+ estimated line numbers are replaced by the exact ones.
+ */
+void Fl_Text_Display::wrap_count_cb(void *user_data) {
+  Fl_Text_Display *w = (Fl_Text_Display*)user_data;
+  Fl_Timestamp start = Fl::now();
+  int more;
+  do {
+    more = w->wrap_count_step();
+  } while (more && Fl::seconds_since(start) < WRAP_COUNT_TIME);
+  if (more)
+    return;
+  Fl::remove_idle(wrap_count_cb, user_data);
+  w->mNBufferLines = w->count_lines(0, w->buffer()->length(), true);
+  w->mTopLineNum = w->count_lines(0, w->mFirstChar, true) + 1;
+  w->update_v_scrollbar();
+}
+
+
 
 /**
  \brief Skip a number of lines forward.
@@ -1776,6 +1989,8 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
   if (textD->mContinuousWrap) {
     textD->find_wrap_range(deletedText, pos, nInserted, nDeleted,
                            &wrapModStart, &wrapModEnd, &linesInserted, &linesDeleted);
+    if (nInserted != 0 || nDeleted != 0)
+      textD->wrap_count_update(pos, nInserted, nDeleted, linesInserted - linesDeleted);
   } else {
     linesInserted = nInserted == 0 ? 0 : buf->count_lines( pos, pos + nInserted );
     linesDeleted = nDeleted == 0 ? 0 : countlines( deletedText );
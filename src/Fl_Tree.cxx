@@ -83,6 +83,10 @@ Fl_Tree::Fl_Tree(int X, int Y, int W, int H, const char *L) : Fl_Group(X,Y,W,H,L
   _lastselect           = nullptr;
   _lastpushed           = 0;
   _auto_resize_children = 0;                    // don't resize children automatically
+  _item_widgets         = 0;
+  _populate_cb          = 0;
+  _populate_data        = 0;
+  _prune_delay          = -1.0;                 // never prune automatically
 
   box(FL_DOWN_BOX);
   color(FL_BACKGROUND2_COLOR, FL_SELECTION_COLOR);
@@ -109,6 +113,7 @@ Fl_Tree::Fl_Tree(int X, int Y, int W, int H, const char *L) : Fl_Group(X,Y,W,H,L
 
 /// Destructor.
 Fl_Tree::~Fl_Tree() {
+  Fl::remove_timeout(prune_timeout, (void*)this);
   if ( _root ) { delete _root; _root = 0; }
 }
 
@@ -327,8 +332,8 @@ int Fl_Tree::handle(int e) {
               set_item_focus(next_visible_item(_item_focus, ekey));     // next item up|dn
               if ( _item_focus ) {                                      // item in focus?
                 // Autoscroll
-                int itemtop = _item_focus->y();
-                int itembot = _item_focus->y()+_item_focus->h();
+                int itemtop = item_y(_item_focus);
+                int itembot = itemtop+_item_focus->h();
                 if ( itemtop < y() ) { show_item_top(_item_focus); }
                 if ( itembot > y()+h() ) { show_item_bottom(_item_focus); }
                 // Extend selection
@@ -652,6 +657,12 @@ void Fl_Tree::calc_dimensions() {
 /// potentially a slow calculation if the tree has many items (potentially
 /// hundreds of thousands), and should therefore be called sparingly.
 ///
+/// The walk also caches the height of each item and of its open children.
+/// Using these, draw() skips the items scrolled out of view, and find_clicked()
+/// only descends into the subtrees under the mouse, so scrolling a large tree
+/// does not visit every item again. Trees with item widgets() are still drawn
+/// in full, so that the widgets of hidden items are moved out of view.
+///
 /// For this reason, recalc_tree() is used as a way to /schedule/
 /// calculation when changes affect the tree hierarchy's size.
 ///
@@ -679,6 +690,7 @@ void Fl_Tree::calc_tree() {
   }
   int xmax = 0, render = 0, ytop = Y;
   fl_font(_prefs.labelfont(), _prefs.labelsize());
+  _item_widgets = 0;                                    // set again by items that have a widget()
   _root->draw(X, Y, W, 0, xmax, 1, render);             // descend into tree without drawing (render=0)
   // Save computed tree width and height
   _tree_w = _prefs.marginleft() + xmax - X;             // include margin in tree's width
@@ -1647,6 +1659,89 @@ int Fl_Tree::is_close(const char *path) const {
   return(item->is_close()?1:0);
 }
 
+/// Sets the callback that creates the children of lazy items.
+///
+/// Items marked with Fl_Tree_Item::lazy_children(int) show an open/close icon,
+/// but their children are only created when the item is first opened,
+/// by this callback. This way, large hierarchies such as file systems
+/// don't have to be built up front. The callback should add the children
+/// with e.g. add(Fl_Tree_Item*,const char*), and can mark them lazy in turn.
+///
+/// Example:
+/// \code
+/// static void populate_cb(Fl_Tree *tree, Fl_Tree_Item *item, void *data) {
+///   char path[FL_PATH_MAX];
+///   tree->item_pathname(path, sizeof(path), item);
+///   // ..for each entry of directory 'path':
+///   Fl_Tree_Item *child = tree->add(item, name);
+///   if ( is_directory ) child->lazy_children(1);
+/// }
+/// [..]
+/// tree->populate_callback(populate_cb);
+/// tree->add("/home")->lazy_children(1);
+/// \endcode
+///
+/// \param[in] cb The callback, or NULL.
+/// \param[in] data User data passed to the callback.
+/// \see prune_delay(), prune()
+/// \version 1.5.0
+///
+void Fl_Tree::populate_callback(Fl_Tree_Populate_Cb *cb, void *data) {
+  _populate_cb = cb;
+  _populate_data = data;
+}
+
+/// Sets when the children created by the populate callback are freed
+/// after their parent was closed.
+///
+///     - < 0: never, unless prune() is called (default)
+///     - 0: as soon as control returns to the event loop
+///     - > 0: when no such item was closed for \p 'val' seconds
+///
+/// Pruned items become lazy again, and the populate callback creates
+/// their children anew when they are reopened. Their selection state
+/// and user data are lost. Apps that rather limit memory use can call
+/// prune() themselves, e.g. when too many items were created.
+///
+/// \param[in] val The delay in seconds.
+/// \see populate_callback(), prune()
+/// \version 1.5.0
+///
+void Fl_Tree::prune_delay(double val) {
+  _prune_delay = val;
+  Fl::remove_timeout(prune_timeout, (void*)this);
+}
+
+/// Frees the children created by the populate callback of closed items.
+///
+/// Only items that were opened as lazy items, and have been closed since,
+/// are pruned. They become lazy again, see Fl_Tree_Item::lazy_children(int).
+/// Closed items are not descended into, so this does not visit the whole tree.
+///
+/// \param[in] item The item below which to prune, or NULL for the whole tree.
+/// \returns The number of items freed.
+/// \see populate_callback(), prune_delay()
+/// \version 1.5.0
+///
+int Fl_Tree::prune(Fl_Tree_Item *item) {
+  item = item ? item : _root;
+  if ( ! item ) return(0);
+  int count = item->prune_children();
+  if ( count ) redraw();
+  return(count);
+}
+
+// Schedules prune() after an item with populated children was closed
+void Fl_Tree::prune_later() {
+  if ( _prune_delay < 0 ) return;
+  Fl::remove_timeout(prune_timeout, (void*)this);
+  Fl::add_timeout(_prune_delay, prune_timeout, (void*)this);
+}
+
+void Fl_Tree::prune_timeout(void *data) {
+  ((Fl_Tree*)data)->prune();
+}
+
 /// Select the specified \p 'item'. Use 'deselect()' to deselect it.
 ///
 /// Invokes the callback depending on the value of optional parameter \p docallback.<br>
@@ -2361,7 +2456,8 @@ void Fl_Tree::item_draw_mode(int mode) {
 int Fl_Tree::displayed(Fl_Tree_Item *item) {
   item = item ? item : first();
   if (!item) return(0);
-  return( (item->y() >= y()) && (item->y() <= (y()+h()-item->h())) ? 1 : 0);
+  int Y = item_y(item);
+  return( (Y >= y()) && (Y <= (y()+h()-item->h())) ? 1 : 0);
 }
 
 /// Adjust the vertical scrollbar so that \p 'item' is visible
@@ -2381,7 +2477,7 @@ int Fl_Tree::displayed(Fl_Tree_Item *item) {
 void Fl_Tree::show_item(Fl_Tree_Item *item, int yoff) {
   item = item ? item : first();
   if (!item) return;
-  int newval = item->y() - y() - yoff + (int)_vscroll->value();
+  int newval = item_y(item) - y() - yoff + (int)_vscroll->value();
   if ( newval < _vscroll->minimum() ) newval = (int)_vscroll->minimum();
   if ( newval > _vscroll->maximum() ) newval = (int)_vscroll->maximum();
   _vscroll->value(newval);
@@ -2685,6 +2781,14 @@ void Fl_Tree::fix_scrollbar_order() {
   }
 }
 
+// Returns the current y position of 'item'.
+//    Items scrolled out of view are not drawn, and their y() is not updated,
+//    so use the heights cached by calc_tree() if possible.
+//
+int Fl_Tree::item_y(const Fl_Tree_Item *item) const {
+  return(item->cached_heights() ? item->cached_y() : item->y());
+}
+
 /// Schedule tree to recalc the entire tree size.
 /// \note Must be using FLTK ABI 1.3.3 or higher for this to be effective.
 ///
@@ -72,6 +72,9 @@ void Fl_Tree_Item::_Init(const Fl_Tree_Prefs &prefs, Fl_Tree *tree) {
   _children.manage_item_destroy(1);     // let array's dtor manage destroying Fl_Tree_Items
   _prev_sibling     = 0;
   _next_sibling     = 0;
+  _row_h            = 0;
+  _subtree_h        = 0;
+  _child_y          = 0;
 }
 
 /// Constructor.
@@ -131,6 +134,9 @@ Fl_Tree_Item::Fl_Tree_Item(const Fl_Tree_Item *o) {
   _parent           = o->_parent;
   _prev_sibling     = 0;                // do not copy ptrs! use update_prev_next()
   _next_sibling     = 0;                // do not copy ptrs! use update_prev_next()
+  _row_h            = 0;                // heights are cached by draw()
+  _subtree_h        = 0;
+  _child_y          = 0;
 }
 
 /// Print the tree as 'ascii art' to stdout.
@@ -442,6 +448,7 @@ Fl_Tree_Item *Fl_Tree_Item::insert_above(const Fl_Tree_Prefs &prefs, const char
 Fl_Tree_Item* Fl_Tree_Item::deparent(int pos) {
   Fl_Tree_Item *orphan = _children[pos];
   if ( _children.deparent(pos) < 0 ) return NULL;
+  recalc_tree();                        // may change tree geometry
   return orphan;
 }
 
@@ -457,6 +464,7 @@ int Fl_Tree_Item::reparent(Fl_Tree_Item *newchild, int pos) {
   int ret;
   if ( (ret = _children.reparent(newchild, this, pos)) < 0 ) return ret;
   newchild->parent(this);               // take custody
+  recalc_tree();                        // may change tree geometry
   return 0;
 }
 
@@ -470,7 +478,9 @@ int Fl_Tree_Item::reparent(Fl_Tree_Item *newchild, int pos) {
 /// \see move_above(), move_below(), move_into(), move(Fl_Tree_Item*,int,int)
 ///
 int Fl_Tree_Item::move(int to, int from) {
-  return _children.move(to, from);
+  int ret = _children.move(to, from);
+  if ( ret == 0 ) recalc_tree();        // may change tree geometry
+  return ret;
 }
 
 /// Move the current item above/below/into the specified \p 'item',
@@ -681,6 +691,7 @@ int Fl_Tree_Item::remove_child(const char *name) {
 ///
 void Fl_Tree_Item::swap_children(int ax, int bx) {
   _children.swap(ax, bx);
+  recalc_tree();                        // may change tree geometry
 }
 
 /// Swap two of our immediate children, given item pointers.
@@ -770,6 +781,7 @@ void Fl_Tree_Item::draw_vertical_connector(int x, int y1, int y2, const Fl_Tree_
 /// \version 1.3.3 ABI feature
 ///
 const Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int yonly) const {
+  if ( cached_heights() ) return(find_clicked_y(prefs, yonly, cached_y()));
   if ( ! is_visible() ) return(0);
   if ( is_root() && !prefs.showroot() ) {
     // skip event check if we're root but root not being shown
@@ -796,6 +808,62 @@ const Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int y
   return(0);
 }
 
+// Returns 1 if the row and subtree heights cached by draw() are valid.
+//    They are computed for all items by Fl_Tree::calc_tree(), and are
+//    not used if items have widgets, as these need to be moved by draw().
+//
+int Fl_Tree_Item::cached_heights() const {
+  return(_tree && _tree->_tree_h >= 0 && !_tree->_item_widgets);
+}
+
+// Returns the current y position of the item, computed from the cached heights.
+//    Unlike y(), this is also valid for items that were scrolled out of view.
+//    Only call this if cached_heights() is true.
+//
+int Fl_Tree_Item::cached_y() const {
+  if ( !_parent )
+    return(_tree->_tiy + _tree->_prefs.margintop() - _tree->_vscroll->value());
+  return(_parent->cached_y() + _parent->_row_h + _child_y);
+}
+
+// find_clicked() using the cached heights, for an item at position 'Y'.
+//    Only descends into the children whose subtree contains the event.
+//
+const Fl_Tree_Item *Fl_Tree_Item::find_clicked_y(const Fl_Tree_Prefs &prefs,
+                                                 int yonly, int Y) const {
+  if ( ! is_visible() ) return(0);
+  int ey = Fl::event_y();
+  if ( is_root() && !prefs.showroot() ) {
+    // skip event check if we're root but root not being shown
+  } else {
+    // See if event is over us
+    int H = _row_h - prefs.linespacing();
+    if ( yonly ) {
+      if ( ey >= Y && ey <= Y+H ) return(this);
+    } else {
+      if ( Fl::event_inside(_xywh[0], Y, _xywh[2], H) ) return(this);
+    }
+  }
+  if ( is_open() && has_children() ) {          // open? check children of this item
+    int child_y_start = Y + _row_h;
+    int lo = 0, hi = children();                // binary search first child that ends below event
+    while ( lo < hi ) {
+      int mid = (lo + hi) / 2;
+      const Fl_Tree_Item *c = _children[mid];
+      if ( child_y_start + c->_child_y + c->_subtree_h < ey ) lo = mid + 1;
+      else hi = mid;
+    }
+    for ( int t=lo; t<children(); t++ ) {
+      int child_y = child_y_start + _children[t]->_child_y;
+      if ( child_y > ey ) break;                // this and later children are below event
+      const Fl_Tree_Item *item;
+      if ( (item = _children[t]->find_clicked_y(prefs, yonly, child_y)) != NULL )
+        return(item);
+    }
+  }
+  return(0);
+}
+
 /// Non-const version of Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs&,int) const
 Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int yonly) {
   // "Effective C++, 3rd Ed", p.23. Sola fide, Amen.
@@ -824,7 +892,7 @@ int Fl_Tree_Item::calc_item_height(const Fl_Tree_Prefs &prefs) const {
        H < widget()->h()) {
     H = widget()->h();
   }
-  if ( has_children() && H < prefs.openicon_h() )
+  if ( can_open() && H < prefs.openicon_h() )
     H = prefs.openicon_h();
   if ( usericon() && H<usericon()->h() )
     H = usericon()->h();
@@ -977,11 +1045,12 @@ int Fl_Tree_Item::draw_item_content(int render) {
 void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
                         int &tree_item_xmax, int lastchild, int render) {
   Fl_Tree_Prefs &prefs = _tree->_prefs;
-  if ( !is_visible() ) return;
+  if ( !is_visible() ) { _row_h = _subtree_h = 0; return; }
   int tree_top = tree()->_tiy;
   int tree_bot = tree_top + tree()->_tih;
   int H = calc_item_height(prefs);      // height of item
   int H2 = H + prefs.linespacing();     // height of item with line spacing
+  int item_y = Y;                       // for caching the subtree's height
 
   // Update the xywh of this item
   _xywh[0] = X;
@@ -1035,6 +1104,7 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
   //   (so that they don't get mouse events, etc)
   //
   if ( widget() ) {
+    tree()->_item_widgets = 1;          // all items must be drawn to move their widgets
     int wx = uicon_x + uicon_w + (_label ? prefs.labelmarginleft() : 0);
     int wy = label_y();
     int ww = widget()->w();             // use widget's width
@@ -1079,7 +1149,7 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
           }
         }
         // Draw collapse icon
-        if ( render && has_children() && prefs.showcollapse() ) {
+        if ( render && can_open() && prefs.showcollapse() ) {
           // Draw icon image
           if ( is_open() ) {
             if ( prefs.closeicon() ) {
@@ -1130,7 +1200,8 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
       }
     }                   // end drawthis
   }                     // end clipped
-  if ( drawthis ) Y += H2;                                      // adjust Y (even if clipped)
+  _row_h = drawthis ? H2 : 0;
+  Y += _row_h;                                                  // adjust Y (even if clipped)
   // Manage tree_item_xmax
   if ( xmax > tree_item_xmax )
     tree_item_xmax = xmax;
@@ -1140,10 +1211,29 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
                            : X;                                 // unless didn't drawthis
     int child_w = W - (child_x-X);
     int child_y_start = Y;
-    for ( int t=0; t<children(); t++ ) {
-      int is_lastchild = ((t+1)==children()) ? 1 : 0;
+    int t = 0, n = children();
+    // When rendering with valid cached heights, skip the children that are
+    // entirely above or below the viewport. Their subtrees would be clipped.
+    int cull = render && cached_heights();
+    if ( cull ) {
+      int lo = 0, hi = n;               // binary search first child that ends in view
+      while ( lo < hi ) {
+        int mid = (lo + hi) / 2;
+        const Fl_Tree_Item *c = _children[mid];
+        if ( child_y_start + c->_child_y + c->_subtree_h < tree_top ) lo = mid + 1;
+        else hi = mid;
+      }
+      t = lo;
+      if ( t < n ) Y = child_y_start + _children[t]->_child_y;
+    }
+    for ( ; t<n; t++ ) {
+      if ( cull && Y > tree_bot ) break;        // rest is below the viewport
+      int is_lastchild = ((t+1)==n) ? 1 : 0;
+      _children[t]->_child_y = Y - child_y_start;
       _children[t]->draw(child_x, Y, child_w, itemfocus, tree_item_xmax, is_lastchild, render);
     }
+    if ( cull )                                 // bottom of the children, incl. skipped ones
+      Y = child_y_start + _children[n-1]->_child_y + _children[n-1]->_subtree_h;
     if ( has_children() && is_open() ) {
       Y += prefs.openchild_marginbottom();              // offset below open child tree
     }
@@ -1178,13 +1268,14 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
       }
     }
   }
+  _subtree_h = Y - item_y;
 }
 
 
 /// Was the event on the 'collapse' button of this item?
 ///
 int Fl_Tree_Item::event_on_collapse_icon(const Fl_Tree_Prefs &prefs) const {
-  if ( is_visible() && is_active() && has_children() && prefs.showcollapse() ) {
+  if ( is_visible() && is_active() && can_open() && prefs.showcollapse() ) {
     return(event_inside(_collapse_xywh) ? 1 : 0);
   } else {
     return(0);
@@ -1256,6 +1347,13 @@ void Fl_Tree_Item::hide_widgets() {
 
 /// Open this item and all its children.
 void Fl_Tree_Item::open() {
+  if ( is_flag(LAZY) ) {                // first open of a lazy item? create its children
+    set_flag(LAZY,0);
+    if ( _tree && _tree->_populate_cb ) {
+      _tree->_populate_cb(_tree, this, _tree->_populate_data);
+      set_flag(POPULATED,1);
+    }
+  }
   set_flag(OPEN,1);
   // Tell children to show() their widgets
   for ( int t=0; t<_children.total(); t++ ) {
@@ -1272,6 +1370,80 @@ void Fl_Tree_Item::close() {
     _children[t]->hide_widgets();
   }
   recalc_tree();                // may change tree geometry
+  if ( is_flag(POPULATED) && _tree )
+    _tree->prune_later();       // children may be freed, see Fl_Tree::prune_delay()
+}
+
+/// Marks the item as having children that are only created when it is opened.
+///
+/// A lazy item shows the open/close icon although it has no children yet.
+/// The first time it is opened, the tree's populate callback is invoked to
+/// add them, see Fl_Tree::populate_callback(). If the callback adds no
+/// children, the item becomes a normal leaf.
+///
+/// Since the children are created by opening the item, this also closes it
+/// and frees any children it already has.
+/// Children created by the callback can be freed again when the item is
+/// closed, which makes it lazy again, see Fl_Tree::prune().
+///
+/// \param[in] val 1: children are created when opened, 0: normal item
+/// \version 1.5.0
+///
+void Fl_Tree_Item::lazy_children(int val) {
+  if ( val ) {
+    free_children();            // the populate callback creates them
+    set_flag(POPULATED,0);
+  }
+  set_flag(LAZY, val);
+  if ( val ) close();
+  else recalc_tree();           // may change tree geometry
+}
+
+// Returns the number of items below 'item'
+static int count_children(const Fl_Tree_Item *item) {
+  int count = item->children();
+  for ( int t=0; t<item->children(); t++ )
+    count += count_children(item->child(t));
+  return(count);
+}
+
+// Returns 1 if 'item' is below 'parent' in the tree
+static int is_below(const Fl_Tree_Item *item, const Fl_Tree_Item *parent) {
+  for ( ; item; item = item->parent() )
+    if ( item->parent() == parent ) return(1);
+  return(0);
+}
+
+// Frees all children, and makes the tree forget its pointers to them.
+//    Returns the number of items freed.
+//
+int Fl_Tree_Item::free_children() {
+  if ( !has_children() ) return(0);
+  if ( _tree ) {                // (the dtor handles the focus item)
+    if ( is_below(_tree->_lastselect, this) ) _tree->_lastselect = 0;
+    if ( is_below(_tree->_callback_item, this) ) _tree->_callback_item = 0;
+  }
+  int count = count_children(this);
+  clear_children();
+  return(count);
+}
+
+// Frees the children created by the populate callback if the item is closed,
+// and makes the item lazy again. Otherwise descends into the open children.
+//    Returns the number of items freed.
+//
+int Fl_Tree_Item::prune_children() {
+  if ( is_close() ) {
+    if ( !is_flag(POPULATED) ) return(0);
+    int count = free_children();
+    set_flag(POPULATED,0);
+    set_flag(LAZY,1);
+    return(count);
+  }
+  int count = 0;
+  for ( int t=0; t<children(); t++ )
+    count += _children[t]->prune_children();
+  return(count);
 }
 
 /// Returns how many levels deep this item is in the hierarchy.
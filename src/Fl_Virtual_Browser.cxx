@@ -0,0 +1,242 @@
+//
+// Virtual browser widget for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl.H>
+#include <FL/Fl_Virtual_Browser.H>
+#include <FL/fl_draw.H>
+#include <FL/platform_types.h>
+#include <algorithm>
+
+// Items are the line numbers themselves, cast to pointers, so that
+// no memory is needed per line. Line 0 is the NULL item.
+
+static inline int item_line(const void *item) {
+  return (int)(fl_intptr_t)item;
+}
+
+static inline void *line_item(int line) {
+  return (void *)(fl_intptr_t)line;
+}
+
+/**
+  The constructor makes an empty browser.
+  \param[in] X,Y,W,H position and size.
+  \param[in] L label string, may be NULL.
+*/
+Fl_Virtual_Browser::Fl_Virtual_Browser(int X, int Y, int W, int H, const char *L)
+: Fl_Browser_(X, Y, W, H, L) {
+  lines_ = 0;
+  line_height_ = 0;
+  text_cb_ = 0;
+  text_data_ = 0;
+}
+
+/**
+  Sets the number of lines in the browser.
+  Lines are added or removed at the end. The scroll position and the
+  selection are kept when lines are added, and reset when lines are
+  removed.
+  \param[in] n The new number of lines.
+*/
+void Fl_Virtual_Browser::lines(int n) {
+  if (n < 0) n = 0;
+  if (n == lines_) return;
+  if (n < lines_) {
+    selected_.erase(std::upper_bound(selected_.begin(), selected_.end(), n), selected_.end());
+    new_list();
+  }
+  lines_ = n;
+  redraw();
+}
+
+/**
+  Sets the height of all lines in pixels, not including linespacing().
+  With 0, the default, the height is fl_height() of textfont() and
+  textsize().
+  \param[in] h The new line height.
+*/
+void Fl_Virtual_Browser::line_height(int h) {
+  if (h < 0) h = 0;
+  if (h == line_height_) return;
+  line_height_ = h;
+  new_list();
+}
+
+/**
+  Returns the text of \p line.
+  The default calls the function set with text_callback(), if any.
+  \param[in] line The line number (1 based).
+  \returns The text, or NULL.
+*/
+const char *Fl_Virtual_Browser::line_text(int line) const {
+  if (!text_cb_ || line < 1 || line > lines_) return 0;
+  return text_cb_(line, text_data_);
+}
+
+/**
+  Draws \p line in the area indicated by \p X, \p Y, \p W, \p H.
+  The default draws line_text() with textfont(), textsize() and
+  textcolor(). The background, including the selection, has already
+  been drawn.
+  \param[in] line The line number (1 based).
+  \param[in] X,Y,W,H position and size.
+*/
+void Fl_Virtual_Browser::draw_line(int line, int X, int Y, int W, int H) const {
+  const char *str = line_text(line);
+  if (!str || !*str) return;
+  Fl_Color lcol = textcolor();
+  if (selected(line)) lcol = fl_contrast(lcol, selection_color());
+  if (!active_r()) lcol = fl_inactive(lcol);
+  fl_font(textfont(), textsize());
+  fl_color(lcol);
+  fl_draw(str, X+3, Y, W-6, H, FL_ALIGN_LEFT, 0, 0);
+}
+
+void *Fl_Virtual_Browser::item_first() const {
+  return lines_ ? line_item(1) : 0;
+}
+
+void *Fl_Virtual_Browser::item_next(void *item) const {
+  int line = item_line(item);
+  return line < lines_ ? line_item(line + 1) : 0;
+}
+
+void *Fl_Virtual_Browser::item_prev(void *item) const {
+  int line = item_line(item);
+  return line > 1 ? line_item(line - 1) : 0;
+}
+
+void *Fl_Virtual_Browser::item_last() const {
+  return line_item(lines_);
+}
+
+void *Fl_Virtual_Browser::item_at(int line) const {
+  return (line < 1 || line > lines_) ? 0 : line_item(line);
+}
+
+int Fl_Virtual_Browser::item_selected(void *item) const {
+  return std::binary_search(selected_.begin(), selected_.end(), item_line(item));
+}
+
+void Fl_Virtual_Browser::item_select(void *item, int val) {
+  int line = item_line(item);
+  std::vector<int>::iterator i = std::lower_bound(selected_.begin(), selected_.end(), line);
+  bool found = (i != selected_.end() && *i == line);
+  if (val && !found) selected_.insert(i, line);
+  else if (!val && found) selected_.erase(i);
+}
+
+int Fl_Virtual_Browser::item_height(void *) const {
+  if (line_height_) return line_height_;
+  int h = fl_height(textfont(), textsize());
+  return h > 2 ? h : 2;
+}
+
+int Fl_Virtual_Browser::item_width(void *item) const {
+  const char *str = line_text(item_line(item));
+  if (!str) return 6;
+  fl_font(textfont(), textsize());
+  return int(fl_width(str)) + 6;
+}
+
+void Fl_Virtual_Browser::item_draw(void *item, int X, int Y, int W, int H) const {
+  draw_line(item_line(item), X, Y, W, H);
+}
+
+int Fl_Virtual_Browser::full_height() const {
+  return lines_ * step();
+}
+
+int Fl_Virtual_Browser::incr_height() const {
+  return step();
+}
+
+const char *Fl_Virtual_Browser::item_text(void *item) const {
+  return line_text(item_line(item));
+}
+
+// All lines have the same height, so positions and lines are converted
+// by a multiplication or a division:
+
+void *Fl_Virtual_Browser::item_at_position(int ypos, int &item_y) const {
+  if (!lines_) return 0;
+  int h = step();
+  int line = (ypos < 0 ? 0 : ypos / h) + 1;
+  if (line > lines_) line = lines_;
+  item_y = (line - 1) * h;
+  return line_item(line);
+}
+
+int Fl_Virtual_Browser::item_position(void *item) const {
+  return (item_line(item) - 1) * step();
+}
+
+/**
+  Sets the selection state of \p line to \p val.
+  \param[in] line The line number (1 based).
+  \param[in] val The new selection state (1=select, 0=de-select).
+  \returns 1 if the state changed, 0 if not.
+*/
+int Fl_Virtual_Browser::select(int line, int val) {
+  if (line < 1 || line > lines_) return 0;
+  return Fl_Browser_::select(line_item(line), val);
+}
+
+/**
+  Returns 1 if \p line is selected, 0 if not.
+  \param[in] line The line number (1 based).
+*/
+int Fl_Virtual_Browser::selected(int line) const {
+  if (line < 1 || line > lines_) return 0;
+  return item_selected(line_item(line));
+}
+
+/**
+  Returns the number of the current selection, or 0 if none is selected.
+*/
+int Fl_Virtual_Browser::value() const {
+  return item_line(selection());
+}
+
+/**
+  Scrolls the browser so that \p line is at the top.
+  \param[in] line The line number (1 based).
+*/
+void Fl_Virtual_Browser::topline(int line) {
+  if (line > lines_) line = lines_;
+  if (line < 1) line = 1;
+  int X, Y, W, H;
+  bbox(X, Y, W, H);
+  int pos = (line - 1) * step();
+  if (pos > full_height() - H) pos = full_height() - H;
+  vposition(pos);
+}
+
+/**
+  Returns the line that is currently shown at the top of the browser.
+*/
+int Fl_Virtual_Browser::topline() const {
+  return item_line(top());
+}
+
+/**
+  Scrolls the browser as needed to show \p line.
+  \param[in] line The line number (1 based).
+*/
+void Fl_Virtual_Browser::make_visible(int line) {
+  if (line < 1 || line > lines_) return;
+  display(line_item(line));
+}
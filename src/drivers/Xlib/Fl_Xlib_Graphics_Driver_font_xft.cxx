@@ -673,6 +673,7 @@ Fl_Xlib_Font_Descriptor::Fl_Xlib_Font_Descriptor(const char* name, Fl_Fontsize f
 //  encoding = fl_encoding_;
   angle = fangle;
   font = fontopen(name, fsize, false, angle);
+  width = NULL;
 }
 
 
@@ -720,13 +721,6 @@ int Fl_Xlib_Graphics_Driver::descent_unscaled() {
   else return -1;
 }
 
-double Fl_Xlib_Graphics_Driver::width_unscaled(const char* str, int n) {
-  if (!font_descriptor()) return -1.0;
-  XGlyphInfo i;
-  utf8extents((Fl_Xlib_Font_Descriptor*)font_descriptor(), str, n, &i);
-  return i.xOff;
-}
-
 static double fl_xft_width(Fl_Font_Descriptor *desc, FcChar32 *str, int n) {
   if (!desc) return -1.0;
   XGlyphInfo i;
@@ -734,9 +728,51 @@ static double fl_xft_width(Fl_Font_Descriptor *desc, FcChar32 *str, int n) {
   return i.xOff;
 }
 
+#define NO_WIDTH 0x7fffffff // rotated fonts can have negative widths
+
+/* Returns the advance of a single Unicode character. Widths of characters
+ of the Basic Multilingual Plane are cached in the font descriptor, one
+ page of 1024 characters at a time. The advance of a string is the sum of
+ the advances of its characters (XftTextExtents32() does no kerning), so
+ strings can be measured from this cache without calling Xft.
+ */
+static int fl_xft_char_width(Fl_Xlib_Font_Descriptor *desc, unsigned c) {
+  if (c > 0xFFFF) return (int)fl_xft_width(desc, (FcChar32 *)&c, 1);
+  if (!desc->width) {
+    desc->width = new int*[64];
+    memset(desc->width, 0, 64*sizeof(int*));
+  }
+  int *page = desc->width[c >> 10];
+  if (!page) {
+    page = desc->width[c >> 10] = new int[0x0400];
+    for (int i = 0; i < 0x0400; i++) page[i] = NO_WIDTH;
+  }
+  int &w = page[c & 0x03FF];
+  if (w == NO_WIDTH) w = (int)fl_xft_width(desc, (FcChar32 *)&c, 1);
+  return w;
+}
+
+double Fl_Xlib_Graphics_Driver::width_unscaled(const char* str, int n) {
+  if (!font_descriptor()) return -1.0;
+  Fl_Xlib_Font_Descriptor *desc = (Fl_Xlib_Font_Descriptor*)font_descriptor();
+  const char *end = str + n;
+  int w = 0;
+  while (str < end) {
+    if (!(*str & 0x80)) { // ASCII
+      w += fl_xft_char_width(desc, (uchar)*str++);
+      continue;
+    }
+    int len;
+    unsigned c = fl_utf8decode(str, end, &len);
+    w += fl_xft_char_width(desc, c);
+    str += len;
+  }
+  return w;
+}
+
 double Fl_Xlib_Graphics_Driver::width_unscaled(unsigned int c) {
   if (!font_descriptor()) return -1.0;
-  return fl_xft_width(font_descriptor(), (FcChar32 *)(&c), 1);
+  return fl_xft_char_width((Fl_Xlib_Font_Descriptor*)font_descriptor(), c);
 }
 
 void Fl_Xlib_Graphics_Driver::text_extents_unscaled(const char *c, int n, int &dx, int &dy, int &w, int &h) {
@@ -959,10 +995,8 @@ const char* Fl_Xlib_Graphics_Driver::get_font_name(Fl_Font fnum, int* ap) {
 Fl_Xlib_Font_Descriptor::~Fl_Xlib_Font_Descriptor() {
   if (this == fl_graphics_driver->font_descriptor()) fl_graphics_driver->font_descriptor(NULL);
   //  XftFontClose(fl_display, font);
-#if USE_PANGO
   if (width) for (int i = 0; i < 64; i++) delete[] width[i];
   delete[] width;
-#endif
 }
 
 
@@ -61,9 +61,16 @@
 #    define RepeatPad  2
 #  endif
 #endif // HAVE_XRENDER
+#if HAVE_XSHM
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#  include <X11/extensions/XShm.h>
+#  include "Fl_Xlib_Shm_Segment.H"
+#endif // HAVE_XSHM
 
 static XImage xi;       // template used to pass info to X
 static int bytes_per_pixel;
+static int scanline_pad;        // scanline_pad of the visual in bytes
 static int scanline_add;
 static int scanline_mask;
 
@@ -310,6 +317,12 @@ static void rrr_converter(const uchar *from, uchar *to, int w, int delta) {
   U32 *t = (U32*)to; for (; w--; from += delta) *t++ = f
 #  endif
 
+// SSE2 versions of the most common converters to 32-bit xrgb on x86
+#  include "Fl_Xlib_Pixel_Converters.H"
+#  if USE_SSSE3
+static int have_ssse3;
+#  endif
+
 static void rgbx_converter(const uchar *from, uchar *to, int w, int delta) {
   INNARDS32((unsigned(from[0])<<24)+(from[1]<<16)+(from[2]<<8));
 }
@@ -319,10 +332,28 @@ static void xbgr_converter(const uchar *from, uchar *to, int w, int delta) {
 }
 
 static void xrgb_converter(const uchar *from, uchar *to, int w, int delta) {
+#  if USE_SSE2
+  int n = 0;
+  if (delta == 4) n = xrgb4_sse2(from, to, w);
+#    if USE_SSSE3
+  else if (delta == 3 && have_ssse3) n = xrgb3_ssse3(from, to, w);
+#    endif
+  from += n * delta;
+  to += n * 4;
+  w -= n;
+#  endif // USE_SSE2
   INNARDS32((from[0]<<16)+(from[1]<<8)+(from[2]));
 }
 
 static void argb_premul_converter(const uchar *from, uchar *to, int w, int delta) {
+#  if USE_SSE2
+  if (delta == 4) {
+    int n = argb4_premul_sse2(from, to, w);
+    from += n * 4;
+    to += n * 4;
+    w -= n;
+  }
+#  endif // USE_SSE2
   INNARDS32((unsigned(from[3]) << 24) +
              (((from[0] * from[3]) / 255) << 16) +
              (((from[1] * from[3]) / 255) << 8) +
@@ -330,6 +361,14 @@ static void argb_premul_converter(const uchar *from, uchar *to, int w, int delta
 }
 
 static void depth2_to_argb_premul_converter(const uchar *from, uchar *to, int w, int delta) {
+#  if USE_SSE2
+  if (delta == 2) {
+    int n = argb2_premul_sse2(from, to, w);
+    from += n * 2;
+    to += n * 4;
+    w -= n;
+  }
+#  endif // USE_SSE2
   INNARDS32((unsigned(from[1]) << 24) +
             (((from[0] * from[1]) / 255) << 16) +
             (((from[0] * from[1]) / 255) << 8) +
@@ -345,6 +384,14 @@ static void rrrx_converter(const uchar *from, uchar *to, int w, int delta) {
 }
 
 static void xrrr_converter(const uchar *from, uchar *to, int w, int delta) {
+#  if USE_SSE2
+  int n = 0;
+  if (delta == 1) n = xrrr1_sse2(from, to, w);
+  else if (delta == 2) n = xrrr2_sse2(from, to, w);
+  from += n * delta;
+  to += n * 4;
+  w -= n;
+#  endif // USE_SSE2
   INNARDS32(*from * 0x10101U);
 }
 
@@ -365,6 +412,9 @@ mono32_converter(const uchar *from,uchar *to,int w, int delta) {
 static void figure_out_visual() {
 
   fl_xpixel(FL_BLACK); // setup fl_redmask, etc, in fl_color.cxx
+#  if USE_SSSE3
+  have_ssse3 = __builtin_cpu_supports("ssse3");
+#  endif
   fl_xpixel(FL_WHITE); // also make sure white is allocated
 
   static XPixmapFormatValues *pfvlist;
@@ -385,6 +435,7 @@ static void figure_out_visual() {
   else bytes_per_pixel = xi.bits_per_pixel/8;
 
   unsigned int n = pfv->scanline_pad/8;
+  scanline_pad = n;
   if (pfv->scanline_pad & 7 || (n&(n-1)))
     Fl::fatal("Can't do scanline_pad of %d",pfv->scanline_pad);
   if (n < sizeof(STORETYPE)) n = sizeof(STORETYPE);
@@ -469,6 +520,67 @@ static void figure_out_visual() {
 
 #  define MAXBUFFER 0x40000 // 256k
 
+#if HAVE_XSHM
+
+////////////////////////////////////////////////////////////////
+// MIT-SHM upload of converted images, see Fl_Xlib_Shm_Segment.H
+
+static int shm_error;
+
+static int shm_error_handler(Display *, XErrorEvent *) {
+  shm_error = 1;
+  return 0;
+}
+
+class Fl_Xlib_Shm : public Fl_Xlib_Shm_Segment {
+public:
+  XShmSegmentInfo info;
+protected:
+  bool query_extension() FL_OVERRIDE {
+    return XShmQueryExtension(fl_display) != False;
+  }
+  char *create_segment(size_t size) FL_OVERRIDE {
+    info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (info.shmid < 0) return NULL;
+    info.shmaddr = (char *)shmat(info.shmid, 0, 0);
+    if (info.shmaddr == (char *)-1) {
+      shmctl(info.shmid, IPC_RMID, 0);
+      return NULL;
+    }
+    info.readOnly = True;
+    return info.shmaddr;
+  }
+  bool attach_segment() FL_OVERRIDE {
+    // XShmAttach() fails asynchronously, e.g. if the server runs on another host
+    XSync(fl_display, False);
+    shm_error = 0;
+    XErrorHandler old_handler = XSetErrorHandler(shm_error_handler);
+    Bool ok = XShmAttach(fl_display, &info);
+    XSync(fl_display, False);
+    XSetErrorHandler(old_handler);
+    // the segment is destroyed when both the server and FLTK detach it
+    shmctl(info.shmid, IPC_RMID, 0);
+    if (!ok || shm_error) {
+      shmdt(info.shmaddr);
+      return false;
+    }
+    return true;
+  }
+  void detach_segment() FL_OVERRIDE {
+    XShmDetach(fl_display, &info);
+    XSync(fl_display, False);
+    shmdt(info.shmaddr);
+  }
+  void sync() FL_OVERRIDE {
+    XSync(fl_display, False);
+  }
+};
+
+static Fl_Xlib_Shm shm;
+
+#endif // HAVE_XSHM
+
+
 static void innards(const uchar *buf, int X, int Y, int W, int H,
                     int delta, int linedelta, int mono,
                     Fl_Draw_Image_Cb cb, void* userdata,
@@ -542,6 +654,35 @@ static void innards(const uchar *buf, int X, int Y, int W, int H,
     }}
     xi.data = (char *)buffer;
     xi.bytes_per_line = linesize*sizeof(STORETYPE);
+#if HAVE_XSHM
+    // Convert the whole image into shared memory if possible
+    char *shm_data = NULL;
+    int total_w = Fl_Xlib_Shm::total_width(w, h, xi.byte_order == ImageByteOrder(fl_display),
+                                           xi.bytes_per_line, bytes_per_pixel,
+                                           alpha ? 4 : scanline_pad);
+    if (total_w) shm_data = shm.get((size_t)xi.bytes_per_line * h);
+    if (shm_data) {
+      STORETYPE* linebuf = buf ? NULL : new STORETYPE[(W*delta+(sizeof(STORETYPE)-1))/sizeof(STORETYPE)];
+      if (buf) buf += delta*dx+linedelta*dy;
+      uchar *to = (uchar *)shm_data;
+      for (int j=0; j<h; j++, to += xi.bytes_per_line) {
+        if (buf) {
+          conv(buf, to, w, delta);
+          buf += linedelta;
+        } else {
+          cb(userdata, dx, dy+j, w, (uchar*)linebuf);
+          conv((uchar*)linebuf, to, w, delta);
+        }
+      }
+      delete[] linebuf;
+      XImage si = xi;
+      si.data = shm_data;
+      si.width = total_w;
+      si.obdata = (char *)&shm.info;
+      XShmPutImage(fl_display, fl_window, gc, &si, 0, 0, X+dx, Y+dy, w, h, False);
+      shm.busy();
+    } else
+#endif // HAVE_XSHM
     if (buf) {
       buf += delta*dx+linedelta*dy;
       for (int j=0; j<h; ) {
@@ -843,7 +984,7 @@ int Fl_Xlib_Graphics_Driver::scale_and_render_pixmap(Fl_Offscreen pixmap, int de
       { XDoubleToFixed( 0 ),       XDoubleToFixed( 0 ),       XDoubleToFixed( 1 ) }
     }};
     XRenderSetPictureTransform(fl_display, src, &mat);
-    if (Fl_Image::scaling_algorithm() == FL_RGB_SCALING_BILINEAR) {
+    if (Fl_Image::scaling_algorithm() != FL_RGB_SCALING_NEAREST) {
       XRenderSetPictureFilter(fl_display, src, FilterBilinear, 0, 0);
       // A note at  https://www.talisman.org/~erlkonig/misc/x11-composite-tutorial/ :
       // "When you use a filter you'll probably want to use PictOpOver as the render op,
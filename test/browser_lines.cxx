@@ -0,0 +1,109 @@
+//
+// Fl_Browser text measuring benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Fills a browser with 100,000 lines of text in several fonts and columns,
+// then measures the time to compute the width of all lines, and scrolls
+// through the browser and reports the average time of a redraw. Both are
+// dominated by measuring text, fl_width() and fl_measure().
+//
+// Usage: browser_lines [fltk options] [number of lines, default 100000]
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Browser.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Box.H>
+#include <FL/fl_draw.H>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int STEPS = 200;           // scroll steps per run
+
+static Fl_Browser *browser;
+static Fl_Box *stats;
+static Fl_Button *run_button;
+static int step;
+static double draw_time, width_time;
+static volatile double sink;            // keeps the measured widths
+
+static void scroll_cb(void *) {
+  browser->vposition(browser->vposition() + browser->h() / 2);
+  Fl_Timestamp start = Fl::now();
+  Fl::flush();
+  draw_time += Fl::seconds_since(start);
+  if (++step < STEPS) {
+    Fl::repeat_timeout(0.0, scroll_cb);
+    return;
+  }
+  static char buf[160];
+  snprintf(buf, sizeof(buf), "%d lines: widths of all lines %.1f ms, redraw %.3f ms",
+           browser->size(), width_time * 1e3, draw_time * 1e3 / STEPS);
+  printf("%s\n", buf);
+  fflush(stdout);
+  stats->label(buf);
+  run_button->activate();
+}
+
+static void run_cb(Fl_Widget *, void *) {
+  step = 0;
+  draw_time = 0.0;
+  stats->label("Measuring...");
+  run_button->deactivate();
+  // measure all lines, as the browser does to find its widest line
+  Fl_Timestamp start = Fl::now();
+  double sum = 0;
+  fl_font(browser->textfont(), browser->textsize());
+  for (int i = 1; i <= browser->size(); i++)
+    sum += fl_width(browser->text(i));
+  width_time = Fl::seconds_since(start);
+  sink = sum;
+  browser->vposition(0);
+  Fl::add_timeout(0.0, scroll_cb);
+}
+
+int main(int argc, char **argv) {
+  int i = 1;
+  Fl::args(argc, argv, i);
+  int lines = (i < argc) ? atoi(argv[i]) : 100000;
+  if (lines < 1) lines = 1;
+
+  Fl_Double_Window *win = new Fl_Double_Window(600, 640, "Fl_Browser lines");
+  browser = new Fl_Browser(10, 10, 580, 550);
+  static int widths[] = { 200, 150, 100, 0 };
+  browser->column_widths(widths);
+  browser->column_char('\t');
+  static const char *formats[] = { "", "@b", "@i", "@C1", "@s", "@f" };
+  static const char *words[] = { "alpha", "Bravo", "charlie", "Delta", "echo",
+                                 "Foxtrot", "golf", "Hotel", "\xc3\xa9t\xc3\xa9", "\xce\xb1\xce\xb2\xce\xb3" };
+  char line[200];
+  for (int n = 0; n < lines; n++) {
+    snprintf(line, sizeof(line), "%s%s %s %d\t%s%s\t%d\t%s %s",
+             formats[n % 6], words[n % 10], words[(n / 10) % 10], n,
+             formats[(n / 6) % 6], words[(n * 7) % 10], n * 13,
+             words[(n * 3) % 10], words[(n / 100) % 10]);
+    browser->add(line);
+  }
+  stats = new Fl_Box(10, 570, 580, 25);
+  stats->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  run_button = new Fl_Button(490, 605, 100, 25, "Run");
+  run_button->callback(run_cb);
+  win->end();
+  win->resizable(browser);
+  win->show(argc, argv);
+  run_cb(run_button, 0);
+  return Fl::run();
+}
@@ -0,0 +1,138 @@
+//
+// Xlib pixel converter benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Converts a frame of each image depth d() to 32-bit xrgb pixels, and to
+// premultiplied argb for depths 2 and 4, like the Xlib driver does when it
+// draws an image, and prints the time per frame of the plain C converters
+// and of the SSE2/SSSE3 converters. No window is opened, so this also runs
+// without a display.
+//
+// Usage: image_convert [width height, default 1920 1080]
+
+#include <FL/Fl.H>
+#include "../src/drivers/Xlib/Fl_Xlib_Pixel_Converters.H"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static const double RUN_TIME = 0.5;     // seconds per measurement
+
+typedef int (*Converter)(const uchar *from, uchar *to, int w);
+
+// The plain C converters of Fl_Xlib_Graphics_Driver_image.cxx on a 64-bit
+// little endian machine, two pixels per store
+#define INNARDS32(f) \
+  uint64_t *t = (uint64_t *)to; \
+  int w1 = w / 2; \
+  for (; w1--; from += delta) { uint64_t i = f; from += delta; *t++ = ((uint64_t)(f) << 32) | i; } \
+  if (w & 1) *t++ = (uint64_t)(f); \
+  return w
+
+static int xrrr_c(const uchar *from, uchar *to, int w, int delta) {
+  INNARDS32(*from * 0x10101U);
+}
+static int xrrr1_c(const uchar *from, uchar *to, int w) { return xrrr_c(from, to, w, 1); }
+static int xrrr2_c(const uchar *from, uchar *to, int w) { return xrrr_c(from, to, w, 2); }
+static int argb2_premul_c(const uchar *from, uchar *to, int w) {
+  const int delta = 2;
+  INNARDS32((unsigned(from[1]) << 24) +
+            (((from[0] * from[1]) / 255) << 16) +
+            (((from[0] * from[1]) / 255) << 8) +
+            ((from[0] * from[1]) / 255));
+}
+static int xrgb_c(const uchar *from, uchar *to, int w, int delta) {
+  INNARDS32((from[0] << 16) + (from[1] << 8) + (from[2]));
+}
+static int xrgb3_c(const uchar *from, uchar *to, int w) { return xrgb_c(from, to, w, 3); }
+static int xrgb4_c(const uchar *from, uchar *to, int w) { return xrgb_c(from, to, w, 4); }
+static int argb4_premul_c(const uchar *from, uchar *to, int w) {
+  const int delta = 4;
+  INNARDS32((unsigned(from[3]) << 24) +
+            (((from[0] * from[3]) / 255) << 16) +
+            (((from[1] * from[3]) / 255) << 8) +
+            ((from[2] * from[3]) / 255));
+}
+
+static int W = 1920, H = 1080;
+static uchar *pixels, *out;
+
+// Converts frames until RUN_TIME has passed, returns milliseconds per frame
+static double measure(Converter conv, int delta) {
+  int runs = 0;
+  Fl_Timestamp start = Fl::now();
+  double t;
+  do {
+    for (int y = 0; y < H; y++) {
+      const uchar *from = pixels + (long)y * W * delta;
+      uchar *to = out + (long)y * W * 4;
+      int n = conv(from, to, W);
+      if (n < W) xrgb_c(from + n * delta, to + n * 4, W - n, delta); // rest, timing only
+    }
+    runs++;
+  } while ((t = Fl::seconds_since(start)) < RUN_TIME);
+  return t * 1e3 / runs;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    W = atoi(argv[1]);
+    H = atoi(argv[2]);
+  }
+  if (W < 1) W = 1;
+  if (H < 1) H = 1;
+  pixels = new uchar[(long)W * H * 4 + 16];
+  out = new uchar[(long)W * H * 4];
+  unsigned seed = 1;
+  for (long i = 0; i < (long)W * H * 4 + 16; i++) {
+    seed = seed * 1103515245 + 12345;
+    pixels[i] = (uchar)(seed >> 16);
+  }
+
+  static const struct { int d; const char *name; Converter c; } cases[] = {
+    { 1, "gray",              xrrr1_c },
+    { 2, "gray+alpha",        xrrr2_c },
+    { 2, "gray+alpha premul", argb2_premul_c },
+    { 3, "RGB",               xrgb3_c },
+    { 4, "RGBA",              xrgb4_c },
+    { 4, "RGBA premul",       argb4_premul_c }
+  };
+  Converter simd[] = { NULL, NULL, NULL, NULL, NULL, NULL };  // same order
+#if USE_SSE2
+  simd[0] = xrrr1_sse2;
+  simd[1] = xrrr2_sse2;
+  simd[2] = argb2_premul_sse2;
+#  if USE_SSSE3
+  if (__builtin_cpu_supports("ssse3")) simd[3] = xrgb3_ssse3;
+#  endif
+  simd[4] = xrgb4_sse2;
+  simd[5] = argb4_premul_sse2;
+#endif // USE_SSE2
+
+  printf("%dx%d frame, milliseconds per frame\n\n", W, H);
+  printf("d  %-20s %8s %8s\n", "input", "C", "SIMD");
+  for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    printf("%d  %-20s %8.2f", cases[i].d, cases[i].name, measure(cases[i].c, cases[i].d));
+    if (simd[i]) printf(" %8.2f", measure(simd[i], cases[i].d));
+    else printf(" %8s", "-");
+    printf("\n");
+    fflush(stdout);
+  }
+  delete[] pixels;
+  delete[] out;
+  return 0;
+}
@@ -0,0 +1,83 @@
+//
+// Fl_RGB_Image scaling benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Scales random images of all depths with each scaling algorithm and prints
+// the throughput in megapixels of the new image per second. No window is
+// opened, so this also runs without a display.
+//
+// Usage: image_scale [source size, default 2048]
+
+#include <FL/Fl.H>
+#include <FL/Fl_Image.H>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const double RUN_TIME = 0.5;     // seconds per measurement
+
+// Scales img to W x H until RUN_TIME has passed, returns megapixels/second
+static double measure(const Fl_RGB_Image &img, int W, int H) {
+  int runs = 0;
+  Fl_Timestamp start = Fl::now();
+  double t;
+  do {
+    delete img.copy(W, H);
+    runs++;
+  } while ((t = Fl::seconds_since(start)) < RUN_TIME);
+  return (double)W * H * runs / t / 1e6;
+}
+
+int main(int argc, char **argv) {
+  int size = (argc > 1) ? atoi(argv[1]) : 2048;
+  if (size < 16) size = 16;
+
+  static const struct { Fl_RGB_Scaling algorithm; const char *name; } algorithms[] = {
+    { FL_RGB_SCALING_NEAREST,  "nearest" },
+    { FL_RGB_SCALING_BILINEAR, "bilinear" },
+    { FL_RGB_SCALING_AREA,     "area" }
+  };
+  static const double factors[] = { 0.3, 0.7, 1.3, 2.0 };
+
+  uchar *pixels = new uchar[(long)size * size * 4];
+  unsigned seed = 1;
+  for (long i = 0; i < (long)size * size * 4; i++) {
+    seed = seed * 1103515245 + 12345;
+    pixels[i] = (uchar)(seed >> 16);
+  }
+
+  printf("source %dx%d, megapixels of the new image per second\n\n", size, size);
+  printf("%-10s %2s", "algorithm", "d");
+  for (unsigned f = 0; f < sizeof(factors) / sizeof(factors[0]); f++)
+    printf("  %7.1fx", factors[f]);
+  printf("\n");
+  Fl_RGB_Scaling keep = Fl_Image::RGB_scaling();
+  for (unsigned a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+    Fl_Image::RGB_scaling(algorithms[a].algorithm);
+    for (int d = 1; d <= 4; d++) {
+      Fl_RGB_Image img(pixels, size, size, d);
+      printf("%-10s %2d", algorithms[a].name, d);
+      for (unsigned f = 0; f < sizeof(factors) / sizeof(factors[0]); f++) {
+        int n = (int)(size * factors[f]);
+        printf("  %8.1f", measure(img, n, n));
+        fflush(stdout);
+      }
+      printf("\n");
+    }
+  }
+  Fl_Image::RGB_scaling(keep);
+  delete[] pixels;
+  return 0;
+}
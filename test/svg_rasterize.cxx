@@ -0,0 +1,93 @@
+//
+// Fl_SVG_Image rasterizing benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Creates 500 different SVG icons and rasterizes all of them with
+// Fl_SVG_Image::rasterize() at three sizes, like an icon theme at display
+// scale factors 100%, 150% and 200%. Each size is rasterized twice: first
+// when it is new, then again after switching from the other sizes, which
+// finds the pixels in the raster cache if they fit into its budget.
+//
+// Usage: svg_rasterize [fltk options] [raster cache budget in MB, default 32]
+
+#include <FL/Fl.H>
+#include <FL/Fl_SVG_Image.H>
+#include <FL/platform.H>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#ifdef FLTK_USE_SVG
+
+static const int ICONS = 500;
+static const int SIZE = 24;             // icon size at 100%
+
+// Returns the SVG text of icon n, a few shapes with colors that depend on n
+static std::string icon_svg(int n) {
+  char buf[512];
+  std::string svg = "<svg xmlns='http://www.w3.org/2000/svg' width='24' height='24'>";
+  for (int i = 0; i < 4; i++) {
+    int v = (n * 7 + i * 13) % 24;
+    snprintf(buf, sizeof(buf),
+             "<circle cx='%d' cy='%d' r='%d' fill='#%02x%02x%02x' stroke='black'/>"
+             "<path d='M2 %d L%d 22 L22 %d Z' fill='none' stroke='#%02x%02x%02x' stroke-width='1.5'/>",
+             4 + v / 2, 20 - v / 2, 3 + i, (n * 37) & 255, (i * 71) & 255, (n * 11 + i) & 255,
+             v, 22 - v, 24 - v, (i * 53) & 255, (n * 29) & 255, 128);
+    svg += buf;
+  }
+  svg += "</svg>";
+  return svg;
+}
+
+int main(int argc, char **argv) {
+  int i = 1;
+  Fl::args(argc, argv, i);
+  if (i < argc) Fl_SVG_Image::raster_cache_budget((size_t)atoi(argv[i]) * 1024 * 1024);
+  fl_open_display();
+
+  Fl_SVG_Image *icons[ICONS];
+  for (int n = 0; n < ICONS; n++)
+    icons[n] = new Fl_SVG_Image(NULL, icon_svg(n).c_str());
+
+  static const double scales[] = { 1.0, 1.5, 2.0 };
+  printf("%d icons, raster cache budget %lu MB\n", ICONS,
+         (unsigned long)(Fl_SVG_Image::raster_cache_budget() / (1024 * 1024)));
+  for (int pass = 0; pass < 2; pass++) {
+    for (int s = 0; s < 3; s++) {
+      int size = (int)(SIZE * scales[s] + 0.5);
+      for (int n = 0; n < ICONS; n++)
+        icons[n]->scale(size, size, 1, 1);
+      Fl_Timestamp start = Fl::now();
+      Fl_SVG_Image::rasterize(icons, ICONS);
+      double t = Fl::seconds_since(start);
+      printf("%s %3.0f%% (%2dx%2d): %7.2f ms, %6.1f us per icon, cache %lu kB\n",
+             pass ? "again" : "new  ", scales[s] * 100, size, size, t * 1e3, t * 1e6 / ICONS,
+             (unsigned long)(Fl_SVG_Image::raster_cache_bytes() / 1024));
+    }
+  }
+  for (int n = 0; n < ICONS; n++)
+    delete icons[n];
+  return 0;
+}
+
+#else // !FLTK_USE_SVG
+
+int main(int, char **) {
+  fprintf(stderr, "svg_rasterize: this FLTK was built without SVG support\n");
+  return 1;
+}
+
+#endif // FLTK_USE_SVG
@@ -0,0 +1,96 @@
+//
+// Fl_Terminal scrolling benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Fills a terminal with colored text, then appends one line per frame so
+// the whole screen scrolls, and reports the frames per second. Each line
+// has a few color and attribute changes, like the output of 'ls --color'.
+//
+// Usage: terminal_scroll [fltk options] [number of frames, default 500]
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Terminal.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Box.H>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static Fl_Terminal *tty;
+static Fl_Box *stats;
+static Fl_Button *run_button;
+static int frames = 500;
+static int frame;
+static double draw_time;
+
+// Appends one line of text with colors
+static void add_line(int n) {
+  static const char *colors[] = { "\033[0m", "\033[31m", "\033[1;32m", "\033[34m", "\033[4;33m" };
+  char line[512];
+  int len = 0;
+  int cols = tty->display_columns();
+  for (int col = 0; col < cols - 12 && len < (int)sizeof(line) - 32; col += 12)
+    len += snprintf(line + len, sizeof(line) - len, "%s%-11d ", colors[(n + col / 12) % 5], n * 1000 + col);
+  snprintf(line + len, sizeof(line) - len, "\033[0m\n");
+  tty->append(line);
+}
+
+static void frame_cb(void *) {
+  add_line(frame);
+  Fl_Timestamp start = Fl::now();
+  Fl::flush();
+  draw_time += Fl::seconds_since(start);
+  if (++frame < frames) {
+    Fl::repeat_timeout(0.0, frame_cb);
+    return;
+  }
+  static char buf[120];
+  snprintf(buf, sizeof(buf), "%d frames: %.1f frames/s, %.3f ms per frame",
+           frames, frames / draw_time, draw_time * 1e3 / frames);
+  printf("%s\n", buf);
+  fflush(stdout);
+  stats->label(buf);
+  run_button->activate();
+}
+
+static void run_cb(Fl_Widget *, void *) {
+  frame = 0;
+  draw_time = 0.0;
+  stats->label("Scrolling...");
+  run_button->deactivate();
+  for (int i = 0; i < tty->display_rows(); i++) add_line(i);
+  Fl::add_timeout(0.0, frame_cb);
+}
+
+int main(int argc, char **argv) {
+  int i = 1;
+  Fl::args(argc, argv, i);
+  if (i < argc) frames = atoi(argv[i]);
+  if (frames < 1) frames = 1;
+
+  Fl_Double_Window *win = new Fl_Double_Window(820, 640, "Fl_Terminal scrolling");
+  tty = new Fl_Terminal(10, 10, 800, 550);
+  tty->ansi(true);
+  stats = new Fl_Box(10, 570, 800, 25);
+  stats->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  run_button = new Fl_Button(710, 605, 100, 25, "Run");
+  run_button->callback(run_cb);
+  win->end();
+  win->resizable(tty);
+  win->show(argc, argv);
+  run_cb(run_button, 0);
+  return Fl::run();
+}
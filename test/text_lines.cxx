@@ -0,0 +1,124 @@
+//
+// Fl_Text_Buffer line lookup benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Loads a large text file with Fl_Text_Buffer::loadfile(), then jumps to
+// random line numbers and back, with and without the line index, and while
+// editing the text. No window is opened, so this also runs without a display.
+//
+// Usage: text_lines [size of the generated file in MB, default 500]
+//        text_lines -f filename
+
+#include <FL/Fl.H>
+#include <FL/Fl_Text_Buffer.H>
+#include <FL/fl_utf8.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static unsigned seed = 1;
+static volatile long sink;              // keeps the results of the lookups
+
+static unsigned random_number(unsigned n) {
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) ^ (seed << 5)) % n;
+}
+
+// Writes a file of random lines, 20 to 120 bytes long, returns false on error
+static bool write_file(const char *name, long bytes) {
+  FILE *f = fl_fopen(name, "wb");
+  if (!f) return false;
+  char line[128];
+  for (long done = 0; done < bytes; ) {
+    int len = 20 + (int)random_number(100);
+    for (int i = 0; i < len; i++) line[i] = (char)('a' + random_number(26));
+    line[len++] = '\n';
+    if (fwrite(line, 1, len, f) != (size_t)len) { fclose(f); return false; }
+    done += len;
+  }
+  return fclose(f) == 0;
+}
+
+// Jumps to 'jumps' random lines and back, returns microseconds per jump
+static double jump(const Fl_Text_Buffer &buf, int lines, int jumps) {
+  long check = 0;
+  Fl_Timestamp start = Fl::now();
+  for (int i = 0; i < jumps; i++) {
+    int pos = buf.skip_lines(0, (int)random_number(lines));
+    check += buf.count_lines(0, pos);
+  }
+  double t = Fl::seconds_since(start);
+  sink = check;
+  return t * 1e6 / jumps;
+}
+
+int main(int argc, char **argv) {
+  std::string name;
+  bool remove_file = false;
+  if (argc > 2 && strcmp(argv[1], "-f") == 0) {
+    name = argv[2];
+  } else {
+    long mb = (argc > 1) ? atol(argv[1]) : 500;
+    if (mb < 1) mb = 1;
+    const char *dir = fl_getenv("TMPDIR");
+    if (!dir) dir = fl_getenv("TEMP");
+    if (!dir) dir = "/tmp";
+    name = std::string(dir) + "/fltk_text_lines.txt";
+    printf("writing %ld MB to %s\n", mb, name.c_str());
+    fflush(stdout);
+    if (!write_file(name.c_str(), mb * 1024 * 1024)) {
+      fprintf(stderr, "text_lines: can't write %s\n", name.c_str());
+      fl_unlink(name.c_str());
+      return 1;
+    }
+    remove_file = true;
+  }
+
+  Fl_Text_Buffer buf;
+  Fl_Timestamp start = Fl::now();
+  int err = buf.loadfile(name.c_str());
+  double t = Fl::seconds_since(start);
+  if (remove_file) fl_unlink(name.c_str());
+  if (err) {
+    fprintf(stderr, "text_lines: can't load %s\n", name.c_str());
+    return 1;
+  }
+  printf("loadfile(): %.1f ms, %.0f MB/s\n", t * 1e3, buf.length() / t / (1024 * 1024));
+
+  start = Fl::now();
+  int lines = buf.count_lines(0, buf.length());
+  printf("%d lines, counted in %.1f ms\n", lines, Fl::seconds_since(start) * 1e3);
+  if (lines < 1) lines = 1;
+
+  printf("random line jump without index: %10.2f us\n", jump(buf, lines, 20));
+  start = Fl::now();
+  buf.line_index(1);
+  printf("line_index(1): %.1f ms\n", Fl::seconds_since(start) * 1e3);
+  printf("random line jump with index:    %10.2f us\n", jump(buf, lines, 100000));
+
+  // Insert and delete lines at random positions, which also moves the gap
+  const int EDITS = 200;
+  start = Fl::now();
+  for (int i = 0; i < EDITS; i++) {
+    int pos = buf.skip_lines(0, (int)random_number(lines));
+    if (i & 1) buf.remove(pos, buf.skip_lines(pos, 1));
+    else buf.insert(pos, "an inserted line\n");
+  }
+  t = Fl::seconds_since(start);
+  printf("random line edit with index:    %10.2f us\n", t * 1e6 / EDITS);
+  return 0;
+}
@@ -0,0 +1,118 @@
+//
+// Fl_Text_Buffer scanning benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Fills a text buffer with random lines, with the gap in the middle, and
+// prints the throughput in GB/s of the functions that scan the text for
+// characters and strings. The first line is a plain loop over byte_at(),
+// which is how the buffer was scanned before. No window is opened, so this
+// also runs without a display.
+//
+// Usage: text_scan [buffer size in MB, default 256]
+
+#include <FL/Fl.H>
+#include <FL/Fl_Text_Buffer.H>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const double RUN_TIME = 0.5;     // seconds per measurement
+
+static Fl_Text_Buffer *buf;
+static volatile long sink;              // keeps the results of the scans
+
+static long byte_loop() {               // counts newlines byte by byte
+  long n = 0;
+  for (int i = 0, len = buf->length(); i < len; i++)
+    if (buf->byte_at(i) == '\n') n++;
+  return n;
+}
+static long count_lines() { return buf->count_lines(0, buf->length()); }
+static long line_ends() {               // walks all lines
+  long n = 0;
+  for (int pos = 0, len = buf->length(); pos < len; pos = buf->line_end(pos) + 1) n++;
+  return n;
+}
+static long findchar_forward() {
+  int pos;
+  return buf->findchar_forward(0, '\t', &pos);
+}
+static long findchar_backward() {
+  int pos;
+  return buf->findchar_backward(buf->length(), '\t', &pos);
+}
+static long search_forward() {
+  int pos;
+  return buf->search_forward(0, "not in the buffer", &pos, 1);
+}
+static long search_all() {
+  std::vector<Fl_Text_Selection> matches;
+  return buf->search_all("fltk", matches, 1);
+}
+
+// Runs a scan until RUN_TIME has passed, returns the scanned GB per second
+static double measure(long (*scan)()) {
+  int runs = 0;
+  Fl_Timestamp start = Fl::now();
+  double t;
+  do {
+    sink = scan();
+    runs++;
+  } while ((t = Fl::seconds_since(start)) < RUN_TIME);
+  return (double)buf->length() * runs / t / 1e9;
+}
+
+int main(int argc, char **argv) {
+  long mb = (argc > 1) ? atol(argv[1]) : 256;
+  if (mb < 1) mb = 1;
+  long size = mb * 1024 * 1024;
+
+  // random lines of 20 to 120 lowercase letters and spaces
+  char *text = new char[size + 1];
+  unsigned seed = 1;
+  for (long i = 0; i < size; ) {
+    seed = seed * 1103515245 + 12345;
+    long len = 20 + (seed >> 16) % 100;
+    for (long j = 0; j < len && i < size; j++, i++) {
+      seed = seed * 1103515245 + 12345;
+      unsigned c = (seed >> 16) % 28;
+      text[i] = (char)(c < 26 ? 'a' + c : ' ');
+    }
+    if (i < size) text[i++] = '\n';
+  }
+  text[size] = 0;
+  buf = new Fl_Text_Buffer();
+  buf->text(text + size / 2);
+  buf->insert(0, text, size / 2);       // moves the gap to the middle
+  delete[] text;
+
+  static const struct { long (*scan)(); const char *name; } scans[] = {
+    { byte_loop,         "byte_at() loop" },
+    { count_lines,       "count_lines()" },
+    { line_ends,         "line_end() of all lines" },
+    { findchar_forward,  "findchar_forward()" },
+    { findchar_backward, "findchar_backward()" },
+    { search_forward,    "search_forward()" },
+    { search_all,        "search_all()" }
+  };
+  printf("%ld MB buffer, %d lines\n\n", mb, buf->count_lines(0, buf->length()));
+  for (unsigned i = 0; i < sizeof(scans) / sizeof(scans[0]); i++) {
+    printf("%-26s %6.2f GB/s\n", scans[i].name, measure(scans[i].scan));
+    fflush(stdout);
+  }
+  delete buf;
+  return 0;
+}
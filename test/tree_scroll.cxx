@@ -0,0 +1,102 @@
+//
+// Fl_Tree scrolling benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Fills a tree with many open items, then scrolls through it and reports
+// the average time of a redraw and of a find_clicked() for each step.
+//
+// Usage: tree_scroll [fltk options] [number of items, default 500000]
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Tree.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Box.H>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int STEPS = 200;           // scroll steps per run
+
+static Fl_Tree *tree;
+static Fl_Box *stats;
+static Fl_Button *run_button;
+static int step;
+static double draw_time, click_time;
+
+static void scroll_cb(void *) {
+  tree->vposition(tree->vposition() + tree->h() / 2);
+  // redraw
+  Fl_Timestamp start = Fl::now();
+  Fl::flush();
+  draw_time += Fl::seconds_since(start);
+  // hit-test the middle of the tree
+  Fl::e_x = tree->x() + tree->w() / 2;
+  Fl::e_y = tree->y() + tree->h() / 2;
+  start = Fl::now();
+  tree->find_clicked();
+  click_time += Fl::seconds_since(start);
+  if (++step < STEPS) {
+    Fl::repeat_timeout(0.0, scroll_cb);
+    return;
+  }
+  static char buf[120];
+  snprintf(buf, sizeof(buf), "%d steps: redraw %.3f ms, find_clicked() %.3f us",
+           STEPS, draw_time * 1e3 / STEPS, click_time * 1e6 / STEPS);
+  printf("%s\n", buf);
+  fflush(stdout);
+  stats->label(buf);
+  run_button->activate();
+}
+
+static void run_cb(Fl_Widget *, void *) {
+  step = 0;
+  draw_time = click_time = 0.0;
+  stats->label("Scrolling...");
+  run_button->deactivate();
+  tree->vposition(0);
+  Fl::add_timeout(0.0, scroll_cb);
+}
+
+int main(int argc, char **argv) {
+  int i = 1;
+  Fl::args(argc, argv, i);
+  int items = (i < argc) ? atoi(argv[i]) : 500000;
+  if (items < 1) items = 1;
+
+  Fl_Double_Window *win = new Fl_Double_Window(500, 600, "Fl_Tree scrolling");
+  tree = new Fl_Tree(10, 10, 480, 510);
+  tree->showroot(0);
+  // groups of 1000 open items each
+  char name[32];
+  Fl_Tree_Item *group = 0;
+  for (int n = 0; n < items; n++) {
+    if (n % 1000 == 0) {
+      snprintf(name, sizeof(name), "Group %d", n / 1000);
+      group = tree->add(tree->root(), name);
+    }
+    snprintf(name, sizeof(name), "Item %d", n);
+    tree->add(group, name);
+  }
+  stats = new Fl_Box(10, 530, 480, 25);
+  stats->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  run_button = new Fl_Button(390, 565, 100, 25, "Run");
+  run_button->callback(run_cb);
+  win->end();
+  win->resizable(tree);
+  win->show(argc, argv);
+  run_cb(run_button, 0);
+  return Fl::run();
+}
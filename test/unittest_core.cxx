@@ -17,14 +17,33 @@
 #include "unittests.h"
 
 #include <FL/Fl_Group.H>
+#include <FL/Fl_Device.H>
+#include <FL/Fl_Graphics_Driver.H>
 #include <FL/Fl_Button.H>
+#include <FL/Fl_Browser.H>
+#include <FL/Fl_Virtual_Browser.H>
+#include <FL/Fl_Tree.H>
+#include <FL/Fl_Table.H>
 #include <FL/Fl_Terminal.H>
 #include <FL/Fl_Preferences.H>
+#include <FL/Fl_Text_Buffer.H>
+#include <FL/Fl_Text_Display.H>
+#include <FL/Fl_Shared_Image.H>
+#include <FL/Fl_PNG_Image.H>
+#include <FL/Fl_JPEG_Image.H>
+#include <FL/Fl_Anim_GIF_Image.H>
+#include <FL/Fl_SVG_Image.H>
 #include <FL/fl_callback_macros.H>
 #include <FL/filename.H>
 #include <FL/fl_utf8.h>
 
 #include <string>
+#include <vector>
+#include <limits.h>
+#include <string.h>
+
+#include "../src/drivers/Xlib/Fl_Xlib_Pixel_Converters.H"
+#include "../src/drivers/Xlib/Fl_Xlib_Shm_Segment.H"
 
 
 /* Test additions to Fl_Preferences. */
@@ -167,6 +186,1382 @@ TEST(Fl_Callback_Macros, FL_INLINE_CALLBACK) {
 
 #endif // FIXME - Fl_String
 
+/* Compare line functions of Fl_Text_Buffer with and without line index. */
+TEST(Fl_Text_Buffer, LineIndex) {
+  Fl_Text_Buffer plain, indexed;
+  indexed.line_index(1);
+  EXPECT_TRUE(indexed.line_index());
+  EXPECT_TRUE(!plain.line_index());
+  static const char *snippets[] = { "\n", "a", "line\n", "\n\n", "two\nlines", "\xc3\xa4\n" };
+  unsigned int seed = 42;
+  for (int i = 0; i < 5000; i++) {
+    seed = seed * 1103515245 + 12345;
+    unsigned int r = seed >> 8;
+    int len = plain.length();
+    if (len > 0 && (r % 4) == 0) {
+      // remove a few bytes, keeping the UTF-8 alignment
+      int start = plain.utf8_align((int)((r >> 4) % len));
+      int end = plain.next_char(start);
+      plain.remove(start, end);
+      indexed.remove(start, end);
+    } else {
+      int pos = len ? plain.utf8_align((int)((r >> 4) % (len + 1))) : 0;
+      if (pos > len) pos = len;
+      const char *t = snippets[(r >> 2) % 6];
+      plain.insert(pos, t);
+      indexed.insert(pos, t);
+    }
+  }
+  EXPECT_EQ(plain.length(), indexed.length());
+  int len = plain.length();
+  for (int pos = 0; pos <= len; pos++) {
+    EXPECT_EQ(plain.count_lines(0, pos), indexed.count_lines(0, pos));
+    EXPECT_EQ(plain.line_start(pos), indexed.line_start(pos));
+    EXPECT_EQ(plain.line_end(pos), indexed.line_end(pos));
+    EXPECT_EQ(plain.skip_lines(pos, 3), indexed.skip_lines(pos, 3));
+    EXPECT_EQ(plain.rewind_lines(pos, 2), indexed.rewind_lines(pos, 2));
+  }
+  int nLines = plain.count_lines(0, len);
+  for (int n = 0; n <= nLines + 1; n++) {
+    EXPECT_EQ(plain.skip_lines(0, n), indexed.skip_lines(0, n));
+  }
+  plain.text("one\ntwo\nthree");
+  indexed.text("one\ntwo\nthree");
+  EXPECT_EQ(indexed.count_lines(0, indexed.length()), 2);
+  EXPECT_EQ(plain.skip_lines(0, 2), indexed.skip_lines(0, 2));
+  return true;
+}
+
+/* Compare character and line searches across the gap with a simple scan. */
+TEST(Fl_Text_Buffer, FindChar) {
+  Fl_Text_Buffer buf;
+  std::string ref;
+  for (int i = 0; i < 300; i++) {
+    std::string t = (i % 7 == 0) ? "\n" : (i % 5 == 0) ? "\xc3\xa4x\n" : "abcdefghij klmnop";
+    int pos = (int)ref.size() / 2;  // keep the gap in the middle of the text
+    buf.insert(pos, t.c_str());
+    ref.insert(pos, t);
+  }
+  int len = (int)ref.size();
+  EXPECT_EQ(buf.length(), len);
+  for (int pos = 0; pos <= len; pos++) {
+    if (pos < len && (ref[pos] & 0xc0) == 0x80) continue;  // not UTF-8 aligned
+    int found, expect;
+    size_t f = ref.find('\n', pos);
+    expect = (f == std::string::npos) ? len : (int)f;
+    EXPECT_EQ(buf.findchar_forward(pos, '\n', &found), f != std::string::npos);
+    EXPECT_EQ(found, expect);
+    f = pos ? ref.rfind('x', pos - 1) : std::string::npos;
+    expect = (f == std::string::npos) ? 0 : (int)f;
+    EXPECT_EQ(buf.findchar_backward(pos, 'x', &found), f != std::string::npos);
+    EXPECT_EQ(found, expect);
+    int n = 0;
+    for (int i = 0; i < pos; i++) if (ref[i] == '\n') n++;
+    EXPECT_EQ(buf.count_lines(0, pos), n);
+  }
+  return true;
+}
+
+/* Compare the soft line break estimate with a character by character count. */
+TEST(Fl_Text_Buffer, EstimateLines) {
+  Fl_Text_Buffer buf;
+  std::string ref;
+  unsigned int seed = 3;
+  for (int i = 0; i < 200; i++) {
+    seed = seed * 1103515245 + 12345;
+    std::string t((seed >> 8) % 150, 'x');
+    t += '\n';
+    int pos = (int)ref.size() / 2;  // keep the gap in the middle of the text
+    buf.insert(pos, t.c_str());
+    ref.insert(pos, t);
+  }
+  int len = (int)ref.size();
+  for (int lineLen = 1; lineLen < 90; lineLen += 11) {
+    for (int start = 0; start < len; start += 97) {
+      for (int end = start; end <= len; end += 389) {
+        int lines = 0, softBreaks = 0, count = lineLen;
+        for (int i = start; i < end; i++) {
+          if (ref[i] == '\n') { count = lineLen; lines++; }
+          if (--count == 0) { count = lineLen; softBreaks++; }
+        }
+        EXPECT_EQ(buf.estimate_lines(start, end, lineLen), lines + softBreaks);
+      }
+    }
+  }
+  return true;
+}
+
+/* Graphics driver without a display: all characters are 8 pixels wide,
+   and each font has a different line height. */
+class Ut_Font_Driver : public Fl_Graphics_Driver {
+public:
+  double width(const char *str, int n) override { return 8 * fl_utf_nb_char((const uchar *)str, n); }
+  int height() override { return size() + font(); }
+};
+
+class Ut_Font_Device : public Fl_Surface_Device {
+public:
+  Ut_Font_Device() : Fl_Surface_Device(new Ut_Font_Driver) { push_current(this); }
+  ~Ut_Font_Device() { pop_current(); delete driver(); }
+};
+
+class Ut_Text_Display : public Fl_Text_Display {
+public:
+  Ut_Text_Display() : Fl_Text_Display(0, 0, 400, 300) { end(); }
+  void recalc() { recalc_display(); }
+  int counting() { return Fl::has_idle(wrap_count_cb, this); }
+  void idle() { wrap_count_cb(this); }
+  int step() { return wrap_count_step(); }
+  int counted() const { return mWrapCheckpoints[2*(mNWrapCheckpoints-1)]; }
+  int buffer_lines() const { return mNBufferLines; }
+  int exact_lines() const {
+    int retPos, retLines, retLineStart, retLineEnd;
+    wrapped_line_counter(buffer(), 0, buffer()->length(), INT_MAX, true, 0,
+                         &retPos, &retLines, &retLineStart, &retLineEnd);
+    return retLines;
+  }
+};
+
+// Runs the background count of wrapped lines to the end. Every step must
+// stop within a chunk plus one display line, also inside huge lines.
+static bool ut_wrap_count(Ut_Text_Display &td) {
+  EXPECT_TRUE(td.counting());
+  int pos = td.counted();
+  while (td.step()) {
+    EXPECT_TRUE(td.counted() > pos);
+    EXPECT_TRUE(td.counted() - pos <= 16384 + 100);
+    pos = td.counted();
+  }
+  td.idle();
+  EXPECT_TRUE(!td.counting());
+  EXPECT_EQ(td.buffer_lines(), td.exact_lines());
+  return true;
+}
+
+/* Compare the wrapped lines counted in idle steps with a synchronous count. */
+TEST(Fl_Text_Display, WrapCount) {
+  Ut_Font_Device dev;
+  Fl_Text_Buffer buf;
+  std::string text;
+  unsigned int seed = 5;
+  for (int i = 0; i < 3000; i++) {
+    seed = seed * 1103515245 + 12345;
+    text += std::string((seed >> 8) % 120, 'a' + i % 26);
+    text += (seed >> 20) % 4 ? ' ' : '\n';
+  }
+  for (int i = 0; i < 30000; i++)     // one huge line of words ...
+    text += "word ";
+  text += std::string(200000, 'x');   // ... followed by one without spaces
+  text += "\nend";
+  buf.text(text.c_str());
+  Ut_Text_Display td;
+  td.buffer(&buf);
+  td.wrap_mode(Fl_Text_Display::WRAP_AT_BOUNDS, 0);
+  td.recalc();
+  EXPECT_TRUE(ut_wrap_count(td));
+  int lines = td.buffer_lines();
+  // a font change restarts the count
+  td.textsize(td.textsize() + 4);
+  EXPECT_TRUE(ut_wrap_count(td));
+  EXPECT_EQ(td.buffer_lines(), lines);  // all characters have the same width
+  // edits inside the huge lines
+  buf.insert(text.size() - 100000, "some more words ");
+  buf.remove(200000, 3000);
+  buf.insert(100, "\n");
+  EXPECT_TRUE(ut_wrap_count(td));
+  td.buffer(0);
+  return true;
+}
+
+/* Compare string searches across the gap with std::string searches. */
+TEST(Fl_Text_Buffer, Search) {
+  Fl_Text_Buffer buf;
+  std::string ref;
+  static const char *words[] = { "abc", "ABC", "ab", "\xc3\xa4" "bc", "\xc3\x84" "BC", " ", "\n", "cab" };
+  unsigned int seed = 7;
+  for (int i = 0; i < 400; i++) {
+    seed = seed * 1103515245 + 12345;
+    const char *t = words[(seed >> 8) % 8];
+    int pos = (int)ref.size() / 3;  // keep the gap inside the text
+    buf.insert(pos, t);
+    ref.insert(pos, t);
+  }
+  // lower case version of ref with the same byte offsets
+  std::string lower = ref;
+  for (size_t i = 0; i < lower.size(); i++) {
+    if (lower[i] >= 'A' && lower[i] <= 'Z') lower[i] += 'a' - 'A';
+    if ((unsigned char)lower[i] == 0x84 && i > 0 && (unsigned char)lower[i-1] == 0xc3) lower[i] = (char)0xa4;
+  }
+  // needles are lower case, so they can be used with the lower case reference
+  static const char *needles[] = { "abc", "bca", "c ", "\xc3\xa4", "b\nc", "cabab", "x" };
+  int len = (int)ref.size();
+  for (int n = 0; n < 7; n++) {
+    for (int pos = 0; pos < len; pos++) {
+      if ((ref[pos] & 0xc0) == 0x80) continue;  // not UTF-8 aligned
+      int found = -1;
+      size_t f = ref.find(needles[n], pos);
+      EXPECT_EQ(buf.search_forward(pos, needles[n], &found, 1), f != std::string::npos);
+      if (f != std::string::npos) { EXPECT_EQ(found, (int)f); }
+      f = ref.rfind(needles[n], pos);
+      EXPECT_EQ(buf.search_backward(pos, needles[n], &found, 1), f != std::string::npos);
+      if (f != std::string::npos) { EXPECT_EQ(found, (int)f); }
+      f = lower.find(needles[n], pos);
+      EXPECT_EQ(buf.search_forward(pos, needles[n], &found, 0), f != std::string::npos);
+      if (f != std::string::npos) { EXPECT_EQ(found, (int)f); }
+      f = lower.rfind(needles[n], pos);
+      EXPECT_EQ(buf.search_backward(pos, needles[n], &found, 0), f != std::string::npos);
+      if (f != std::string::npos) { EXPECT_EQ(found, (int)f); }
+    }
+  }
+  std::vector<Fl_Text_Selection> matches;
+  int count = 0;
+  for (size_t f = lower.find("abc"); f != std::string::npos; f = lower.find("abc", f + 3))
+    count++;
+  EXPECT_EQ(buf.search_all("ABC", matches), count);
+  EXPECT_EQ((int)matches.size(), count);
+  for (size_t i = 0; i < matches.size(); i++) {
+    EXPECT_EQ(matches[i].end() - matches[i].start(), 3);
+    if (i > 0) { EXPECT_GE(matches[i].start(), matches[i-1].end()); }
+  }
+  buf.text("aaaa");
+  EXPECT_EQ(buf.search_all("aa", matches, 1), 2);
+  EXPECT_EQ(buf.search_all("aa", matches, 1, 1), 1);
+  EXPECT_EQ(buf.search_all("aa", matches, 1, 0, 3), 1);
+  return true;
+}
+
+static int ut_modify_calls = 0;
+static void ut_modify_cb(int, int, int, int, const char*, void*) { ut_modify_calls++; }
+
+/* Insert UTF-8 and CP1252 encoded files into a buffer. */
+TEST(Fl_Text_Buffer, InsertFile) {
+  const char *filename = "unittest_text_buffer.txt";
+  std::string utf8;
+  for (int i = 0; i < 20000; i++)
+    utf8 += "line \xc3\xa4\n";
+  FILE *f = fl_fopen(filename, "wb");
+  fwrite(utf8.data(), 1, utf8.size(), f);
+  fclose(f);
+  Fl_Text_Buffer buf;
+  buf.line_index(1);
+  buf.transcoding_warning_action = NULL;
+  buf.text("[]");
+  buf.add_modify_callback(ut_modify_cb, NULL);
+  EXPECT_EQ(buf.insertfile(filename, 1, 1024), 0);
+  EXPECT_EQ(ut_modify_calls, 1);
+  EXPECT_EQ(buf.input_file_was_transcoded, 0);
+  EXPECT_EQ(buf.length(), (int)utf8.size() + 2);
+  EXPECT_TRUE(buf.text_str() == "[" + utf8 + "]");
+  EXPECT_EQ(buf.count_lines(0, buf.length()), 20000);
+  EXPECT_TRUE(buf.can_undo());
+  buf.undo();
+  EXPECT_STREQ(buf.text_str().c_str(), "[]");
+  buf.remove_modify_callback(ut_modify_cb, NULL);
+  // "\xe4" is not valid UTF-8 and must be transcoded from CP1252
+  f = fl_fopen(filename, "wb");
+  fputs("a\xe4\nb", f);
+  fclose(f);
+  EXPECT_EQ(buf.loadfile(filename), 0);
+  EXPECT_EQ(buf.input_file_was_transcoded, 1);
+  EXPECT_STREQ(buf.text_str().c_str(), "a\xc3\xa4\nb");
+  EXPECT_EQ(buf.count_lines(0, buf.length()), 1);
+  fl_unlink(filename);
+  return true;
+}
+
+/* Test the Fl_Shared_Image cache budget. */
+TEST(Fl_Shared_Image, Cache) {
+  uchar *pixels = new uchar[64 * 64 * 3];
+  memset(pixels, 0x80, 64 * 64 * 3);
+  Fl_RGB_Image *rgb = new Fl_RGB_Image(pixels, 64, 64, 3);
+  rgb->alloc_array = 1;
+  int n = Fl_Shared_Image::num_images();
+  size_t bytes = Fl_Shared_Image::cache_bytes();
+  Fl_Shared_Image::reset_cache_stats();
+  Fl_Shared_Image::cache_budget(1000000);
+  Fl_Shared_Image *img = Fl_Shared_Image::get(rgb, 1);
+  std::string name = img->name();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n + 1);
+  EXPECT_EQ(Fl_Shared_Image::cache_bytes(), bytes + 64 * 64 * 3);
+  // a resized copy holds a reference to the original
+  Fl_Shared_Image *copy = Fl_Shared_Image::get(name.c_str(), 32, 32);
+  EXPECT_EQ(Fl_Shared_Image::cache_misses(), 1UL);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n + 2);
+  EXPECT_EQ(img->refcount(), 2);
+  EXPECT_TRUE(Fl_Shared_Image::get(name.c_str(), 32, 32) == copy);
+  EXPECT_EQ(Fl_Shared_Image::cache_hits(), 1UL);
+  copy->release();
+  copy->release();
+  img->release();
+  // unused images stay in the cache and are found again
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n + 2);
+  EXPECT_EQ(img->refcount(), 0);
+  EXPECT_TRUE(Fl_Shared_Image::get(name.c_str(), 32, 32) == copy);
+  EXPECT_EQ(img->refcount(), 1);
+  EXPECT_EQ(Fl_Shared_Image::cache_hits(), 2UL);
+  copy->release();
+  EXPECT_EQ(img->refcount(), 0);
+  // shrinking the budget destroys the least recently released image first
+  Fl_Shared_Image::cache_budget(bytes + 64 * 64 * 3);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n + 1);
+  EXPECT_EQ(Fl_Shared_Image::cache_evictions(), 1UL);
+  EXPECT_TRUE(Fl_Shared_Image::find(name.c_str(), 32, 32) == NULL);
+  EXPECT_TRUE(Fl_Shared_Image::find(name.c_str()) == img);
+  img->release();
+  Fl_Shared_Image::cache_budget(0);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n);
+  EXPECT_EQ(Fl_Shared_Image::cache_bytes(), bytes);
+  EXPECT_EQ(Fl_Shared_Image::cache_evictions(), 2UL);
+  Fl_Shared_Image::reset_cache_stats();
+  return true;
+}
+
+/* Load shared images with get_async() and finish or cancel loading. */
+TEST(Fl_Shared_Image, GetAsync) {
+  const char *filename = "unittest_shared_image.xbm";
+  FILE *f = fl_fopen(filename, "wb");
+  fputs("#define t_width 8\n#define t_height 2\n"
+        "static unsigned char t_bits[] = { 0x01, 0x80 };\n", f);
+  fclose(f);
+  int n = Fl_Shared_Image::num_images();
+  Fl_Shared_Image *img = Fl_Shared_Image::get_async(filename, NULL, 1);
+  EXPECT_TRUE(img != NULL);
+  EXPECT_TRUE(img->loading());
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n + 1);
+  // requesting the image again returns the same placeholder
+  EXPECT_TRUE(Fl_Shared_Image::get_async(filename) == img);
+  EXPECT_EQ(img->refcount(), 2);
+  img->release();
+  // get() needs the data and finishes loading right away
+  Fl_Shared_Image *sync = Fl_Shared_Image::get(filename);
+  EXPECT_TRUE(sync == img);
+  EXPECT_EQ(img->loading(), 0);
+  EXPECT_EQ(img->w(), 8);
+  EXPECT_EQ(img->h(), 2);
+  img->release();
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n);
+  // releasing a placeholder cancels loading
+  img = Fl_Shared_Image::get_async(filename);
+  img->load_priority(5);
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n);
+  // a file that can't be loaded is removed from the pool
+  img = Fl_Shared_Image::get_async("unittest_no_such_image.xbm");
+  EXPECT_TRUE(Fl_Shared_Image::get("unittest_no_such_image.xbm") == NULL);
+  EXPECT_EQ(img->loading(), 0);
+  EXPECT_TRUE(img->image() == NULL);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), n);
+  img->release();
+  fl_unlink(filename);
+  Fl_Shared_Image::reset_cache_stats();
+  return true;
+}
+
+/* Test Fl_RGB_Image scaling with area averaging. */
+TEST(Fl_RGB_Image, ScaleArea) {
+  static const uchar gray[3 * 2] = {
+    0, 30, 90,
+    60, 90, 150
+  };
+  Fl_RGB_Scaling keep = Fl_Image::RGB_scaling();
+  Fl_Image::RGB_scaling(FL_RGB_SCALING_AREA);
+  Fl_RGB_Image src(gray, 3, 2, 1);
+  // every new pixel covers one and a half source pixels horizontally
+  Fl_RGB_Image *img = (Fl_RGB_Image *)src.copy(2, 1);
+  EXPECT_EQ(img->data_w(), 2);
+  EXPECT_EQ(img->data_h(), 1);
+  EXPECT_EQ(img->array[0], 40);  // (0 + 60 + (30 + 90) / 2) / 3
+  EXPECT_EQ(img->array[1], 100); // ((30 + 90) / 2 + 90 + 150) / 3
+  delete img;
+  // all channels of a 2x2 block are averaged
+  uchar rgba[4 * 4 * 4];
+  for (int i = 0; i < 4 * 4 * 4; i++)
+    rgba[i] = (uchar)(i * 4);
+  Fl_RGB_Image src4(rgba, 4, 4, 4);
+  img = (Fl_RGB_Image *)src4.copy(2, 2);
+  EXPECT_EQ(img->array[0], (0 + 16 + 64 + 80) / 4);
+  EXPECT_EQ(img->array[7], (44 + 60 + 108 + 124) / 4);
+  EXPECT_EQ(img->array[15], (172 + 188 + 236 + 252) / 4);
+  delete img;
+  // scaling up falls back to bilinear interpolation
+  img = (Fl_RGB_Image *)src.copy(6, 4);
+  EXPECT_EQ(img->data_w(), 6);
+  EXPECT_EQ(img->array[0], 0);
+  delete img;
+  Fl_Image::RGB_scaling(keep);
+  return true;
+}
+
+// Source position and weight of new pixel i, like Fl_RGB_Image::copy() does
+static void ut_bilinear_pos(int i, int N, int S, int &p0, int &p1, int &w) {
+  float s = ((i + 0.5f) * S) / (float)N - 0.5f;
+  int p = (int)s;
+  if (s < 0.0f && (float)p != s) p--;
+  float f = s - p;
+  if (p < 0) { p = 0; f = 0.0f; }
+  else if (p >= S - 1) { p = S - 1; f = 0.0f; }
+  p0 = p;
+  p1 = (p < S - 1) ? p + 1 : p;
+  w = (int)(f * 256.0f + 0.5f);
+}
+
+/*
+  Bilinear scaling of all depths and several sizes must match a plain
+  interpolation between the four neighbors of each pixel. Sizes are above
+  half the source size, where copy() halves the image first.
+*/
+TEST(Fl_RGB_Image, ScaleBilinear) {
+  static const int sizes[][4] = {   // source and new width and height
+    { 17, 9, 40, 23 }, { 40, 23, 27, 15 }, { 1, 5, 7, 3 }, { 33, 2, 31, 5 }, { 64, 64, 65, 63 }
+  };
+  Fl_RGB_Scaling keep = Fl_Image::RGB_scaling();
+  Fl_Image::RGB_scaling(FL_RGB_SCALING_BILINEAR);
+  unsigned seed = 1;
+  for (int d = 1; d <= 4; d++) {
+    for (unsigned k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+      const int SW = sizes[k][0], SH = sizes[k][1], W = sizes[k][2], H = sizes[k][3];
+      const int ld = SW * d + 3;    // also check a line stride
+      std::string pixels(ld * SH, '\0');
+      for (size_t i = 0; i < pixels.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        pixels[i] = (char)(seed >> 16);
+      }
+      const uchar *src = (const uchar *)pixels.data();
+      Fl_RGB_Image img(src, SW, SH, d, ld);
+      Fl_RGB_Image *copy = (Fl_RGB_Image *)img.copy(W, H);
+      bool same = true;
+      for (int y = 0; y < H && same; y++) {
+        int y0, y1, wy;
+        ut_bilinear_pos(y, H, SH, y0, y1, wy);
+        for (int x = 0; x < W && same; x++) {
+          int x0, x1, wx;
+          ut_bilinear_pos(x, W, SW, x0, x1, wx);
+          for (int c = 0; c < d; c++) {
+            unsigned v = (src[y0 * ld + x0 * d + c] * (256 - wx) * (256 - wy) +
+                          src[y0 * ld + x1 * d + c] * wx * (256 - wy) +
+                          src[y1 * ld + x0 * d + c] * (256 - wx) * wy +
+                          src[y1 * ld + x1 * d + c] * wx * wy + 32768) >> 16;
+            if (copy->array[(y * W + x) * d + c] != v) same = false;
+          }
+        }
+      }
+      delete copy;
+      EXPECT_TRUE(same);
+    }
+  }
+  Fl_Image::RGB_scaling(keep);
+  return true;
+}
+
+#if FLTK_USE_SVG
+
+/*
+  The raster cache of all SVG images keeps to its budget by dropping the
+  least recently used sizes.
+*/
+TEST(Fl_SVG_Image, RasterCacheBudget) {
+  static const char *svg =
+    "<svg width='16' height='16'><rect width='16' height='16' fill='red'/></svg>";
+  const size_t size = 64 * 64 * 4;                 // bytes of a cached size
+  size_t keep = Fl_SVG_Image::raster_cache_budget();
+  Fl_SVG_Image::raster_cache_budget(0);            // start with an empty cache
+  EXPECT_EQ(Fl_SVG_Image::raster_cache_bytes(), (size_t)0);
+  Fl_SVG_Image::raster_cache_budget(3 * size);
+  Fl_SVG_Image *img[4];
+  for (int i = 0; i < 4; i++)
+    img[i] = new Fl_SVG_Image(NULL, svg);
+  for (int i = 0; i < 3; i++)
+    img[i]->resize(64, 64);
+  EXPECT_EQ(Fl_SVG_Image::raster_cache_bytes(), 3 * size);
+  // a copy of img[0] finds its size in the cache, so img[1] is now the oldest
+  Fl_SVG_Image *copy = (Fl_SVG_Image *)img[0]->copy();
+  copy->resize(64, 64);
+  delete copy;
+  img[3]->resize(64, 64);
+  EXPECT_EQ(Fl_SVG_Image::raster_cache_bytes(), 3 * size);
+  delete img[1];                                   // its size was dropped
+  EXPECT_EQ(Fl_SVG_Image::raster_cache_bytes(), 3 * size);
+  delete img[0];
+  EXPECT_EQ(Fl_SVG_Image::raster_cache_bytes(), 2 * size);
+  // a smaller budget drops sizes at once
+  Fl_SVG_Image::raster_cache_budget(size);
+  EXPECT_EQ(Fl_SVG_Image::raster_cache_bytes(), size);
+  delete img[2];
+  delete img[3];
+  EXPECT_EQ(Fl_SVG_Image::raster_cache_bytes(), (size_t)0);
+  Fl_SVG_Image::raster_cache_budget(keep);
+  return true;
+}
+
+#endif // FLTK_USE_SVG
+
+#if USE_SSE2
+
+// One xrgb or argb pixel as the plain C converters make it
+static unsigned ut_xrgb(const uchar *p, int delta, bool premul) {
+  if (delta <= 2) {
+    unsigned a = (delta == 2) ? p[1] : 255;
+    unsigned g = premul ? p[0] * a / 255 : p[0];
+    return (premul ? a << 24 : 0) + g * 0x10101U;
+  }
+  if (!premul) return (p[0] << 16) + (p[1] << 8) + p[2];
+  return (unsigned(p[3]) << 24) + ((p[0] * p[3] / 255) << 16) +
+         ((p[1] * p[3] / 255) << 8) + (p[2] * p[3] / 255);
+}
+
+/*
+  Checks an SSE2 converter of the Xlib image path against the plain C code
+  for rows of 0 to 99 pixels. The converter must do all but a few pixels.
+*/
+static bool ut_converter(int (*conv)(const uchar *, uchar *, int), int delta, bool premul) {
+  uchar from[100 * 4 + 16], to[100 * 4];
+  unsigned seed = 7;
+  for (int w = 0; w < 100; w++) {
+    for (size_t i = 0; i < sizeof(from); i++) {
+      seed = seed * 1103515245 + 12345;
+      from[i] = (uchar)(seed >> 16);
+    }
+    if (w == 1) memset(from, 255, sizeof(from));   // extremes of the premultiplication
+    if (w == 2) memset(from, 0, sizeof(from));
+    int n = conv(from, to, w);
+    if (n > w || n < w - 15) return false;
+    for (int i = 0; i < n; i++) {
+      unsigned pixel;
+      memcpy(&pixel, to + i * 4, 4);
+      if (pixel != ut_xrgb(from + i * delta, delta, premul)) return false;
+    }
+  }
+  return true;
+}
+
+/* The SSE2 and SSSE3 pixel converters of the Xlib image path match the C code. */
+TEST(Fl_Xlib_Graphics_Driver, PixelConverters) {
+  EXPECT_TRUE(ut_converter(xrrr1_sse2, 1, false));
+  EXPECT_TRUE(ut_converter(xrrr2_sse2, 2, false));
+  EXPECT_TRUE(ut_converter(argb2_premul_sse2, 2, true));
+  EXPECT_TRUE(ut_converter(xrgb4_sse2, 4, false));
+  EXPECT_TRUE(ut_converter(argb4_premul_sse2, 4, true));
+#if USE_SSSE3
+  if (__builtin_cpu_supports("ssse3")) {
+    EXPECT_TRUE(ut_converter(xrgb3_ssse3, 3, false));
+  }
+#endif
+  return true;
+}
+
+#endif // USE_SSE2
+
+/* An MIT-SHM segment on a fake X server that can fail at each step. */
+class Ut_Shm_Segment : public Fl_Xlib_Shm_Segment {
+public:
+  bool has_extension, can_create, can_attach;
+  int queries, creates, attaches, detaches, syncs;
+  std::vector<char> memory;
+  Ut_Shm_Segment() : has_extension(true), can_create(true), can_attach(true),
+    queries(0), creates(0), attaches(0), detaches(0), syncs(0) { }
+protected:
+  bool query_extension() override { queries++; return has_extension; }
+  char *create_segment(size_t size) override {
+    creates++;
+    if (!can_create) return NULL;
+    memory.assign(size, 0);
+    return &memory[0];
+  }
+  bool attach_segment() override {
+    attaches++;
+    if (!can_attach) memory.clear();
+    return can_attach;
+  }
+  void detach_segment() override { detaches++; memory.clear(); }
+  void sync() override { syncs++; }
+};
+
+/* The Xlib image path falls back to XPutImage() if MIT-SHM can't be used. */
+TEST(Fl_Xlib_Graphics_Driver, ShmFallback) {
+  const size_t M = Fl_Xlib_Shm_Segment::MIN_SIZE;
+
+  // the segment is created on first use, reused, and grows in powers of two
+  Ut_Shm_Segment seg;
+  EXPECT_EQ(seg.state(), 0);
+  char *mem = seg.get(5000);
+  EXPECT_TRUE(mem != NULL);
+  EXPECT_EQ(seg.state(), 1);
+  EXPECT_EQ((int)seg.size(), (int)M);
+  EXPECT_TRUE(seg.get(M) == mem);
+  EXPECT_EQ(seg.creates, 1);
+  EXPECT_EQ(seg.queries, 1);
+  EXPECT_EQ(seg.syncs, 0);
+  seg.busy();                                   // wait for the server once
+  EXPECT_TRUE(seg.get(100) == mem);
+  EXPECT_TRUE(seg.get(100) == mem);
+  EXPECT_EQ(seg.syncs, 1);
+  EXPECT_TRUE(seg.get(3 * M) != NULL);
+  EXPECT_EQ((int)seg.size(), (int)(4 * M));
+  EXPECT_EQ(seg.detaches, 1);
+  EXPECT_EQ(seg.creates, 2);
+  // too large for SHM, but SHM stays usable for the next image
+  EXPECT_TRUE(seg.get(Fl_Xlib_Shm_Segment::MAX_SIZE + 1) == NULL);
+  EXPECT_EQ(seg.state(), 1);
+  EXPECT_TRUE(seg.get(Fl_Xlib_Shm_Segment::MAX_SIZE) != NULL);
+  EXPECT_EQ((int)seg.size(), (int)Fl_Xlib_Shm_Segment::MAX_SIZE);
+  seg.release();
+  EXPECT_EQ((int)seg.size(), 0);
+  EXPECT_EQ(seg.detaches, 3);
+
+  // no MIT-SHM extension: asked once, then never again
+  Ut_Shm_Segment noext;
+  noext.has_extension = false;
+  EXPECT_TRUE(noext.get(5000) == NULL);
+  EXPECT_TRUE(noext.get(5000) == NULL);
+  EXPECT_EQ(noext.state(), -1);
+  EXPECT_EQ(noext.queries, 1);
+  EXPECT_EQ(noext.creates, 0);
+
+  // shmget() or shmat() fails: SHM is disabled for the session
+  Ut_Shm_Segment nomem;
+  nomem.can_create = false;
+  EXPECT_TRUE(nomem.get(5000) == NULL);
+  EXPECT_TRUE(nomem.get(5000) == NULL);
+  EXPECT_EQ(nomem.state(), -1);
+  EXPECT_EQ(nomem.creates, 1);
+  EXPECT_EQ(nomem.attaches, 0);
+
+  // a remote server can't attach the segment
+  Ut_Shm_Segment remote;
+  remote.can_attach = false;
+  EXPECT_TRUE(remote.get(5000) == NULL);
+  EXPECT_TRUE(remote.get(5000) == NULL);
+  EXPECT_EQ(remote.state(), -1);
+  EXPECT_EQ(remote.creates, 1);
+  EXPECT_EQ(remote.attaches, 1);
+  EXPECT_EQ((int)remote.size(), 0);
+  remote.release();
+  EXPECT_EQ(remote.detaches, 0);
+
+  // attaching a larger segment fails after the first one worked
+  Ut_Shm_Segment grow;
+  EXPECT_TRUE(grow.get(M) != NULL);
+  grow.can_attach = false;
+  EXPECT_TRUE(grow.get(2 * M) == NULL);
+  EXPECT_EQ(grow.detaches, 1);
+  EXPECT_EQ(grow.state(), -1);
+  EXPECT_TRUE(grow.get(100) == NULL);
+  EXPECT_EQ(grow.creates, 2);
+
+  // which images can be described to XShmPutImage()
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(100, 100, true, 400, 4, 4), 100);
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(100, 100, true, 416, 4, 4), 104);
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(64, 63, true, 256, 4, 4), 0);   // too small
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(64, 64, true, 256, 4, 4), 64);
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(100, 100, false, 400, 4, 4), 0); // byte order
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(101, 100, true, 204, 2, 4), 102);
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(101, 100, true, 208, 2, 4), 104);
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(101, 100, true, 206, 2, 4), 0);  // padding
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(100, 100, true, 304, 3, 4), 101);
+  EXPECT_EQ(Fl_Xlib_Shm_Segment::total_width(100, 100, true, 404, 4, 8), 0);  // no width
+  return true;
+}
+
+// Rows received by ut_png_row()
+struct Ut_PNG_Rows {
+  std::string pixels;
+  int rows, row_size, stop;
+};
+
+static int ut_png_row(const uchar *row, int y, void *data) {
+  Ut_PNG_Rows *r = (Ut_PNG_Rows *)data;
+  if (y != r->rows) return 1;
+  r->pixels.append((const char *)row, r->row_size);
+  return ++r->rows == r->stop;
+}
+
+/*
+  Compares a rectangle of a PNG file, decoded with the cropping constructor
+  and with read_rows(), to the same pixels of the full image.
+*/
+static bool ut_png_crop(const char *filename, const Fl_RGB_Image &full,
+                        int X, int Y, int W, int H) {
+  const int d = full.d();
+  int cx = X < 0 ? 0 : X, cy = Y < 0 ? 0 : Y;                   // clipped rectangle
+  int cw = (X + W > full.w() ? full.w() : X + W) - cx;
+  int ch = (Y + H > full.h() ? full.h() : Y + H) - cy;
+  std::string ref;
+  for (int y = 0; y < ch; y++)
+    ref.append((const char *)full.array + ((y + cy) * full.w() + cx) * d, cw * d);
+  Fl_PNG_Image crop(filename, X, Y, W, H);
+  EXPECT_EQ(crop.fail(), 0);
+  EXPECT_EQ(crop.w(), cw);
+  EXPECT_EQ(crop.h(), ch);
+  EXPECT_EQ(crop.d(), d);
+  EXPECT_TRUE(ref == std::string((const char *)crop.array, cw * ch * d));
+  // rows stored in a buffer with padding
+  const int ld = cw * d + 3;
+  std::string buf(ld * ch, '\0');
+  EXPECT_EQ(Fl_PNG_Image::read_rows(filename, (uchar *)&buf[0], ld, X, Y, W, H), ch);
+  for (int y = 0; y < ch; y++) {
+    EXPECT_TRUE(buf.compare(y * ld, cw * d, ref, y * cw * d, cw * d) == 0);
+  }
+  // rows in a buffer for the rectangle as passed in (ld = 0): the stride stays W * d
+  std::string wbuf(W * d * H, '\0');
+  EXPECT_EQ(Fl_PNG_Image::read_rows(filename, (uchar *)&wbuf[0], 0, X, Y, W, H), ch);
+  for (int y = 0; y < ch; y++) {
+    EXPECT_TRUE(wbuf.compare(y * W * d, cw * d, ref, y * cw * d, cw * d) == 0);
+  }
+  // rows passed to a callback only
+  Ut_PNG_Rows rows = { std::string(), 0, cw * d, -1 };
+  EXPECT_EQ(Fl_PNG_Image::read_rows(filename, NULL, 0, X, Y, W, H, ut_png_row, &rows), ch);
+  EXPECT_EQ(rows.rows, ch);
+  EXPECT_TRUE(rows.pixels == ref);
+  // a callback that stops early
+  Ut_PNG_Rows part = { std::string(), 0, cw * d, ch / 2 };
+  EXPECT_EQ(Fl_PNG_Image::read_rows(filename, NULL, 0, X, Y, W, H, ut_png_row, &part), ch / 2);
+  EXPECT_EQ(part.rows, ch / 2);
+  EXPECT_TRUE(part.pixels == ref.substr(0, (ch / 2) * cw * d));
+  return true;
+}
+
+// Returns the path of file 'name' in the directory for temporary files
+static std::string ut_temp_file(const char *name) {
+  const char *dir = fl_getenv("TMPDIR");
+  if (!dir || !dir[0]) dir = fl_getenv("TEMP");       // Windows
+  if (!dir || !dir[0]) dir = "/tmp";
+  return std::string(dir) + "/" + name;
+}
+
+/* Decode rectangles of PNG files row by row. */
+TEST(Fl_PNG_Image, ReadRows) {
+  // an image of the test data
+  std::string filename = Ut_Suite::data_file("images/FL200.png");
+  Fl_PNG_Image full(filename.c_str());
+  EXPECT_EQ(full.fail(), 0);
+  int W, H, D;
+  EXPECT_EQ(Fl_PNG_Image::read_header(filename.c_str(), W, H, D), 0);
+  EXPECT_EQ(W, full.w());
+  EXPECT_EQ(H, full.h());
+  EXPECT_EQ(D, full.d());
+  EXPECT_TRUE(ut_png_crop(filename.c_str(), full, 30, 20, 50, 40));      // inside
+  EXPECT_TRUE(ut_png_crop(filename.c_str(), full, 170, 80, 100, 100));   // clipped right and bottom
+  EXPECT_TRUE(ut_png_crop(filename.c_str(), full, -10, -5, 25, 30));     // clipped left and top
+  EXPECT_TRUE(ut_png_crop(filename.c_str(), full, 0, 0, W, H));          // all
+  Fl_PNG_Image outside(filename.c_str(), W, 0, 10, 10);
+  EXPECT_EQ(outside.fail(), Fl_Image::ERR_NO_IMAGE);
+
+  // an interlaced 21x13 gray image
+  static const uchar interlaced[] = {
+    0x89,0x50,0x4e,0x47,0x0d,0x0a,0x1a,0x0a,0x00,0x00,0x00,0x0d,0x49,0x48,0x44,0x52,
+    0x00,0x00,0x00,0x15,0x00,0x00,0x00,0x0d,0x08,0x00,0x00,0x00,0x01,0x14,0xfe,0x4a,
+    0x2a,0x00,0x00,0x01,0x36,0x49,0x44,0x41,0x54,0x78,0xda,0x01,0x2b,0x01,0xd4,0xfe,
+    0x00,0x00,0x60,0xc0,0x00,0x38,0x98,0xf8,0x00,0x30,0x90,0xf0,0x00,0x68,0xc8,0x28,
+    0x00,0x1c,0x4c,0x7c,0xac,0xdc,0x0c,0x00,0x54,0x84,0xb4,0xe4,0x14,0x44,0x00,0x18,
+    0x48,0x78,0xa8,0xd8,0x00,0x34,0x64,0x94,0xc4,0xf4,0x00,0x50,0x80,0xb0,0xe0,0x10,
+    0x00,0x6c,0x9c,0xcc,0xfc,0x2c,0x00,0x0e,0x26,0x3e,0x56,0x6e,0x86,0x9e,0xb6,0xce,
+    0xe6,0xfe,0x00,0x2a,0x42,0x5a,0x72,0x8a,0xa2,0xba,0xd2,0xea,0x02,0x1a,0x00,0x46,
+    0x5e,0x76,0x8e,0xa6,0xbe,0xd6,0xee,0x06,0x1e,0x36,0x00,0x0c,0x24,0x3c,0x54,0x6c,
+    0x84,0x9c,0xb4,0xcc,0xe4,0x00,0x1a,0x32,0x4a,0x62,0x7a,0x92,0xaa,0xc2,0xda,0xf2,
+    0x00,0x28,0x40,0x58,0x70,0x88,0xa0,0xb8,0xd0,0xe8,0x00,0x00,0x36,0x4e,0x66,0x7e,
+    0x96,0xae,0xc6,0xde,0xf6,0x0e,0x00,0x44,0x5c,0x74,0x8c,0xa4,0xbc,0xd4,0xec,0x04,
+    0x1c,0x00,0x52,0x6a,0x82,0x9a,0xb2,0xca,0xe2,0xfa,0x12,0x2a,0x00,0x60,0x78,0x90,
+    0xa8,0xc0,0xd8,0xf0,0x08,0x20,0x38,0x00,0x07,0x13,0x1f,0x2b,0x37,0x43,0x4f,0x5b,
+    0x67,0x73,0x7f,0x8b,0x97,0xa3,0xaf,0xbb,0xc7,0xd3,0xdf,0xeb,0xf7,0x00,0x15,0x21,
+    0x2d,0x39,0x45,0x51,0x5d,0x69,0x75,0x81,0x8d,0x99,0xa5,0xb1,0xbd,0xc9,0xd5,0xe1,
+    0xed,0xf9,0x05,0x00,0x23,0x2f,0x3b,0x47,0x53,0x5f,0x6b,0x77,0x83,0x8f,0x9b,0xa7,
+    0xb3,0xbf,0xcb,0xd7,0xe3,0xef,0xfb,0x07,0x13,0x00,0x31,0x3d,0x49,0x55,0x61,0x6d,
+    0x79,0x85,0x91,0x9d,0xa9,0xb5,0xc1,0xcd,0xd9,0xe5,0xf1,0xfd,0x09,0x15,0x21,0x00,
+    0x3f,0x4b,0x57,0x63,0x6f,0x7b,0x87,0x93,0x9f,0xab,0xb7,0xc3,0xcf,0xdb,0xe7,0xf3,
+    0xff,0x0b,0x17,0x23,0x2f,0x00,0x4d,0x59,0x65,0x71,0x7d,0x89,0x95,0xa1,0xad,0xb9,
+    0xc5,0xd1,0xdd,0xe9,0xf5,0x01,0x0d,0x19,0x25,0x31,0x3d,0xa3,0x49,0x88,0xc3,0x03,
+    0xa9,0xff,0x08,0x00,0x00,0x00,0x00,0x49,0x45,0x4e,0x44,0xae,0x42,0x60,0x82
+  };
+  std::string tmpname = ut_temp_file("unittest_interlaced.png");
+  const char *ilname = tmpname.c_str();
+  FILE *f = fl_fopen(ilname, "wb");
+  EXPECT_TRUE(f != NULL);
+  size_t written = fwrite(interlaced, 1, sizeof(interlaced), f);
+  fclose(f);
+  EXPECT_EQ((int)written, (int)sizeof(interlaced));
+  Fl_PNG_Image il(ilname);
+  EXPECT_EQ(il.fail(), 0);
+  EXPECT_EQ(il.w(), 21);
+  EXPECT_EQ(il.h(), 13);
+  EXPECT_EQ(((const uchar *)il.array)[3 * 21 + 5], 5 * 12 + 3 * 7);
+  EXPECT_TRUE(ut_png_crop(ilname, il, 3, 2, 11, 7));
+  EXPECT_TRUE(ut_png_crop(ilname, il, 15, 9, 10, 10));
+  fl_unlink(ilname);
+  return true;
+}
+
+/* Compare a reduced size JPEG with the mean of each block of the full size
+   image. The DCT scaling and the mean differ a little at block edges. */
+static bool ut_jpeg_reduced(const char *filename, int max_w, int max_h, int rw, int rh, int rd) {
+  Fl_JPEG_Image full(filename);
+  Fl_JPEG_Image small(filename, max_w, max_h);
+  EXPECT_EQ(full.fail(), 0);
+  EXPECT_EQ(small.fail(), 0);
+  EXPECT_EQ(small.w(), rw);
+  EXPECT_EQ(small.h(), rh);
+  EXPECT_EQ(small.d(), rd);
+  EXPECT_EQ(full.d(), 3);
+  const int s = full.w() / small.w();
+  EXPECT_EQ(full.h() / small.h(), s);
+  const uchar *fp = (const uchar *)full.array;
+  const uchar *sp = (const uchar *)small.array;
+  for (int y = 0; y < rh; y++) {
+    for (int x = 0; x < rw; x++) {
+      for (int c = 0; c < rd; c++) {
+        int sum = 0;
+        for (int j = 0; j < s; j++)
+          for (int i = 0; i < s; i++)
+            sum += fp[((y * s + j) * full.w() + x * s + i) * 3 + c];
+        int diff = sp[(y * rw + x) * rd + c] - sum / (s * s);
+        if (diff < -4 || diff > 4) {
+          EXPECT_EQ(sp[(y * rw + x) * rd + c], sum / (s * s));
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* Decode JPEG files at a reduced size. */
+TEST(Fl_JPEG_Image, ReducedSize) {
+  // a 64x48 RGB gradient
+  static const uchar rgb[] = {
+    0xff,0xd8,0xff,0xe0,0x00,0x10,0x4a,0x46,0x49,0x46,0x00,0x01,0x01,0x00,0x00,0x01,
+    0x00,0x01,0x00,0x00,0xff,0xdb,0x00,0x43,0x00,0x08,0x06,0x06,0x07,0x06,0x05,0x08,
+    0x07,0x07,0x07,0x09,0x09,0x08,0x0a,0x0c,0x14,0x0d,0x0c,0x0b,0x0b,0x0c,0x19,0x12,
+    0x13,0x0f,0x14,0x1d,0x1a,0x1f,0x1e,0x1d,0x1a,0x1c,0x1c,0x20,0x24,0x2e,0x27,0x20,
+    0x22,0x2c,0x23,0x1c,0x1c,0x28,0x37,0x29,0x2c,0x30,0x31,0x34,0x34,0x34,0x1f,0x27,
+    0x39,0x3d,0x38,0x32,0x3c,0x2e,0x33,0x34,0x32,0xff,0xdb,0x00,0x43,0x01,0x09,0x09,
+    0x09,0x0c,0x0b,0x0c,0x18,0x0d,0x0d,0x18,0x32,0x21,0x1c,0x21,0x32,0x32,0x32,0x32,
+    0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,
+    0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,
+    0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0xff,0xc0,
+    0x00,0x11,0x08,0x00,0x30,0x00,0x40,0x03,0x01,0x22,0x00,0x02,0x11,0x01,0x03,0x11,
+    0x01,0xff,0xc4,0x00,0x16,0x00,0x01,0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x04,0x06,0x07,0xff,0xc4,0x00,0x17,0x10,0x00,0x03,
+    0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,
+    0x04,0x61,0xff,0xc4,0x00,0x18,0x01,0x01,0x01,0x01,0x01,0x01,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x04,0x05,0x03,0x07,0x06,0xff,0xc4,0x00,0x17,
+    0x11,0x00,0x03,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x02,0x04,0x03,0xff,0xda,0x00,0x0c,0x03,0x01,0x00,0x02,0x11,0x03,0x11,
+    0x00,0x3f,0x00,0xc7,0x17,0x36,0x0a,0x5c,0xd8,0x39,0x73,0x60,0x95,0xcd,0x87,0xa9,
+    0x7d,0xc2,0xcf,0x40,0x15,0xcd,0x82,0x97,0x36,0x0e,0x5c,0xd8,0x25,0x73,0x60,0x67,
+    0xdc,0xbb,0x3d,0x00,0x57,0x36,0x0a,0x5c,0xd8,0x39,0x73,0x60,0x95,0xcd,0x81,0x5f,
+    0x72,0xe4,0xf4,0x01,0x5c,0xd8,0x29,0x73,0x60,0xe5,0xcd,0x82,0x97,0x36,0x06,0x7d,
+    0xcb,0x93,0xd0,0x49,0xae,0x6c,0x14,0xb9,0xb0,0x6a,0xe6,0xc1,0x4b,0x9b,0x0d,0x5f,
+    0x73,0x86,0x4f,0x40,0x15,0xcd,0x82,0x97,0x36,0x0e,0x5c,0xd8,0x25,0x73,0x60,0x57,
+    0xdc,0xbb,0x3d,0x00,0x57,0x36,0x0a,0x5c,0xd8,0x39,0x73,0x60,0x95,0xcd,0x81,0x9f,
+    0x72,0xe4,0xf4,0x01,0x5c,0xd8,0x29,0x73,0x60,0xe5,0xcd,0x82,0x57,0x36,0x05,0x7d,
+    0xcb,0xb3,0xd0,0x4a,0x2e,0x6c,0x14,0xb9,0xb0,0x6a,0xe6,0xc1,0x4b,0x9b,0x0d,0x5f,
+    0x73,0x86,0x4f,0x48,0x15,0xcd,0x82,0x97,0x36,0x0e,0x5c,0xd8,0x25,0x73,0x60,0x67,
+    0xdc,0xb9,0x3d,0x20,0x57,0x36,0x0a,0x5c,0xd8,0x39,0x73,0x60,0x95,0xcd,0x81,0x5f,
+    0x72,0xe4,0xf4,0x81,0x5c,0xd8,0x29,0x73,0x60,0xe5,0xcd,0x82,0x57,0x36,0x05,0x7d,
+    0xcb,0xb3,0xd2,0x7f,0xff,0xd9
+  };
+  // a 64x48 grayscale gradient
+  static const uchar gray[] = {
+    0xff,0xd8,0xff,0xe0,0x00,0x10,0x4a,0x46,0x49,0x46,0x00,0x01,0x01,0x00,0x00,0x01,
+    0x00,0x01,0x00,0x00,0xff,0xdb,0x00,0x43,0x00,0x08,0x06,0x06,0x07,0x06,0x05,0x08,
+    0x07,0x07,0x07,0x09,0x09,0x08,0x0a,0x0c,0x14,0x0d,0x0c,0x0b,0x0b,0x0c,0x19,0x12,
+    0x13,0x0f,0x14,0x1d,0x1a,0x1f,0x1e,0x1d,0x1a,0x1c,0x1c,0x20,0x24,0x2e,0x27,0x20,
+    0x22,0x2c,0x23,0x1c,0x1c,0x28,0x37,0x29,0x2c,0x30,0x31,0x34,0x34,0x34,0x1f,0x27,
+    0x39,0x3d,0x38,0x32,0x3c,0x2e,0x33,0x34,0x32,0xff,0xc0,0x00,0x0b,0x08,0x00,0x30,
+    0x00,0x40,0x01,0x01,0x11,0x00,0xff,0xc4,0x00,0x15,0x00,0x01,0x01,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x05,0x07,0xff,0xc4,0x00,
+    0x16,0x10,0x01,0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x03,0x00,0x61,0xff,0xda,0x00,0x08,0x01,0x01,0x00,0x00,0x3f,0x00,0x86,
+    0x88,0xe4,0x80,0x8e,0x48,0x08,0xe4,0x80,0x8e,0x48,0x08,0xe4,0x80,0x8e,0x48,0x08,
+    0xe4,0x80,0x8e,0x51,0xf1,0x1c,0x90,0x11,0xc9,0x01,0x1c,0x90,0x11,0xc9,0x01,0x1c,
+    0x90,0x11,0xc9,0x01,0x1c,0x90,0x11,0xca,0x3e,0x23,0x92,0x02,0x39,0x20,0x23,0x92,
+    0x02,0x39,0x20,0x23,0x92,0x02,0x39,0x20,0x23,0x92,0x02,0x39,0x47,0xc4,0x72,0x40,
+    0x47,0x24,0x04,0x72,0x40,0x47,0x24,0x04,0x72,0x40,0x47,0x24,0x04,0x72,0x40,0x47,
+    0x28,0xf8,0x8e,0x48,0x08,0xe4,0x80,0x8e,0x48,0x08,0xe4,0x80,0x8e,0x48,0x08,0xe4,
+    0x80,0x8e,0x48,0x08,0xe5,0x1f,0x11,0xc9,0x01,0x1c,0x90,0x11,0xc9,0x01,0x1c,0x90,
+    0x11,0xc9,0x01,0x1c,0x90,0x11,0xc9,0x01,0x1c,0xbf,0xff,0xd9
+  };
+  std::string rgbname = ut_temp_file("unittest_rgb.jpg");
+  std::string grayname = ut_temp_file("unittest_gray.jpg");
+  FILE *f = fl_fopen(rgbname.c_str(), "wb");
+  EXPECT_TRUE(f != NULL);
+  size_t written = fwrite(rgb, 1, sizeof(rgb), f);
+  fclose(f);
+  EXPECT_EQ((int)written, (int)sizeof(rgb));
+  f = fl_fopen(grayname.c_str(), "wb");
+  EXPECT_TRUE(f != NULL);
+  written = fwrite(gray, 1, sizeof(gray), f);
+  fclose(f);
+  EXPECT_EQ((int)written, (int)sizeof(gray));
+
+  // the largest reduction that is not smaller than requested
+  bool ok = ut_jpeg_reduced(rgbname.c_str(), 64, 48, 64, 48, 3)
+         && ut_jpeg_reduced(rgbname.c_str(), 20, 12, 32, 24, 3)
+         && ut_jpeg_reduced(rgbname.c_str(), 16, 12, 16, 12, 3)
+         && ut_jpeg_reduced(rgbname.c_str(), 16, 13, 32, 24, 3)
+         && ut_jpeg_reduced(rgbname.c_str(), 0, 0, 8, 6, 3)
+         && ut_jpeg_reduced(grayname.c_str(), 16, 0, 16, 12, 1)
+         && ut_jpeg_reduced(grayname.c_str(), 100, 100, 64, 48, 1);
+  fl_unlink(rgbname.c_str());
+  fl_unlink(grayname.c_str());
+  EXPECT_TRUE(ok);
+
+  Fl_JPEG_Image missing(rgbname.c_str(), 16, 12);
+  EXPECT_EQ(missing.fail(), Fl_Image::ERR_FILE_ACCESS);
+  return true;
+}
+
+/* Append one GIF image block with 2 bit pixels to out. The LZW stream sends
+   a clear code before every two pixels, so the code size stays at 3 bits. */
+static void ut_gif_image(std::vector<uchar> &out, int x, int y, int w, int h, const uchar *px) {
+  const uchar desc[] = { 0x2c, (uchar)x, 0, (uchar)y, 0, (uchar)w, 0, (uchar)h, 0, 0, 2 };
+  out.insert(out.end(), desc, desc + sizeof(desc));
+  std::vector<uchar> codes;
+  for (int i = 0; i < w * h; i++) {
+    if (!(i & 1)) codes.push_back(4);           // clear code
+    codes.push_back(px[i]);
+  }
+  codes.push_back(5);                           // end of information
+  std::vector<uchar> lzw;
+  unsigned bits = 0, nbits = 0;
+  for (size_t i = 0; i < codes.size(); i++) {
+    bits |= codes[i] << nbits;
+    nbits += 3;
+    for (; nbits >= 8; nbits -= 8, bits >>= 8) lzw.push_back((uchar)bits);
+  }
+  if (nbits) lzw.push_back((uchar)bits);
+  out.push_back((uchar)lzw.size());             // one sub-block is enough here
+  out.insert(out.end(), lzw.begin(), lzw.end());
+  out.push_back(0);
+}
+
+/* Decode an animated GIF to RGBA frames, without XPM data in the base image. */
+TEST(Fl_Anim_GIF_Image, DirectDecode) {
+  // a 4x2 canvas with red, green, blue and black
+  static const uchar head[] = {
+    'G','I','F','8','9','a', 4,0, 2,0, 0xf1, 0, 0,
+    0xff,0,0, 0,0xff,0, 0,0,0xff, 0,0,0
+  };
+  std::vector<uchar> gif(head, head + sizeof(head));
+  // frame 0: the full canvas, 10/100 s, no disposal
+  static const uchar gce0[] = { 0x21, 0xf9, 4, 0x04, 10, 0, 0, 0 };
+  static const uchar px0[] = { 0, 1, 2, 3,  3, 2, 1, 0 };
+  gif.insert(gif.end(), gce0, gce0 + sizeof(gce0));
+  ut_gif_image(gif, 0, 0, 4, 2, px0);
+  // frame 1: 3x1 at 1/1 with transparent black, 20/100 s
+  static const uchar gce1[] = { 0x21, 0xf9, 4, 0x05, 20, 0, 3, 0 };
+  static const uchar px1[] = { 0, 3, 1 };
+  gif.insert(gif.end(), gce1, gce1 + sizeof(gce1));
+  ut_gif_image(gif, 1, 1, 3, 1, px1);
+  gif.push_back(0x3b);
+
+  Fl_Anim_GIF_Image anim("unittest.gif", &gif[0], gif.size(), NULL, Fl_Anim_GIF_Image::DONT_START);
+  EXPECT_TRUE(anim.valid());
+  EXPECT_EQ(anim.frames(), 2);
+  EXPECT_EQ(anim.w(), 4);
+  EXPECT_EQ(anim.h(), 2);
+  EXPECT_EQ(anim.fail(), 0);
+  EXPECT_EQ(anim.count(), 0);                   // no XPM data
+  EXPECT_TRUE(anim.data() == NULL);
+  EXPECT_EQ(anim.frame_x(1), 1);
+  EXPECT_EQ(anim.frame_y(1), 1);
+  EXPECT_EQ(anim.frame_w(1), 3);
+  EXPECT_EQ(anim.frame_h(1), 1);
+  EXPECT_EQ((int)(anim.delay(0) * 100 + 0.5), 10);
+  EXPECT_EQ((int)(anim.delay(1) * 100 + 0.5), 20);
+
+  // expected RGBA canvas after each frame
+  static const uchar pal[4][3] = { {0xff,0,0}, {0,0xff,0}, {0,0,0xff}, {0,0,0} };
+  static const uchar canvas[2][8] = {
+    { 0, 1, 2, 3,  3, 2, 1, 0 },
+    { 0, 1, 2, 3,  3, 0, 1, 1 }                 // pixel 1/5 is transparent
+  };
+  for (int f = 0; f < 2; f++) {
+    Fl_Image *img = anim.image(f);
+    EXPECT_TRUE(img != NULL);
+    EXPECT_EQ(img->d(), 4);
+    EXPECT_EQ(img->data_w(), 4);
+    EXPECT_EQ(img->data_h(), 2);
+    const uchar *rgba = (const uchar *)img->data()[0];
+    for (int i = 0; i < 8; i++) {
+      const uchar *c = pal[canvas[f][i]];
+      EXPECT_EQ(rgba[i * 4 + 0], c[0]);
+      EXPECT_EQ(rgba[i * 4 + 1], c[1]);
+      EXPECT_EQ(rgba[i * 4 + 2], c[2]);
+      EXPECT_EQ(rgba[i * 4 + 3], 0xff);
+    }
+  }
+
+  // a copy has the same frames and no XPM data either
+  Fl_Anim_GIF_Image *copied = (Fl_Anim_GIF_Image *)anim.copy();
+  EXPECT_EQ(copied->frames(), 2);
+  EXPECT_EQ(copied->w(), 4);
+  EXPECT_EQ(copied->fail(), 0);
+  EXPECT_EQ(copied->count(), 0);
+  delete copied;
+  return true;
+}
+
+/* Fl_Browser with fixed line heights, so no font is needed. */
+class Ut_Browser : public Fl_Browser {
+public:
+  Ut_Browser() : Fl_Browser(0, 0, 100, 100) { }
+  int item_height(void *item) const override {
+    return (bline_flags((FL_BLINE*)item) & BLINE_NOTDISPLAYED) ? 0 : 10;
+  }
+  int line_at(int ypos) {
+    int ly;
+    return lineno(item_at_position(ypos, ly));
+  }
+  int position(int line) { return item_position(find_line(line)); }
+  int line_of(int line) { return lineno(find_line(line)); }
+  int total_height() const { return full_height(); }
+};
+
+/* Test the Fl_Browser line index across many blocks. */
+TEST(Fl_Browser, LineIndex) {
+  Ut_Browser b;
+  char buf[32];
+  for (int i = 1; i <= 2000; i++) {
+    snprintf(buf, sizeof(buf), "%d", i);
+    b.add(buf);
+  }
+  EXPECT_EQ(b.size(), 2000);
+  EXPECT_STREQ(b.text(1), "1");
+  EXPECT_STREQ(b.text(1234), "1234");
+  EXPECT_EQ(b.line_of(1777), 1777);
+  EXPECT_EQ(b.position(1001), 10000);
+  EXPECT_EQ(b.line_at(10005), 1001);
+  EXPECT_EQ(b.line_at(99999), 2000); // past the end
+  // insert into and remove from the middle of full blocks
+  for (int i = 0; i < 500; i++) {
+    b.insert(700, "new");
+  }
+  EXPECT_STREQ(b.text(699), "699");
+  EXPECT_STREQ(b.text(1200), "700");
+  EXPECT_EQ(b.line_of(1200), 1200);
+  for (int i = 0; i < 500; i++) {
+    b.remove(700);
+  }
+  EXPECT_STREQ(b.text(700), "700");
+  EXPECT_EQ(b.line_of(2000), 2000);
+  // hidden lines take no space
+  b.hide(1);
+  b.hide(2);
+  EXPECT_EQ(b.line_at(0), 3);
+  EXPECT_EQ(b.position(1001), 9980);
+  EXPECT_EQ(b.total_height(), 19980);
+  b.show(2);
+  EXPECT_EQ(b.line_at(0), 2);
+  b.swap(2, 1999);
+  EXPECT_STREQ(b.text(2), "1999");
+  EXPECT_EQ(b.line_of(1999), 1999);
+  b.move(1, 2000);
+  EXPECT_STREQ(b.text(1), "2000");
+  EXPECT_STREQ(b.text(2), "1");
+  EXPECT_STREQ(b.text(2000), "2");
+  b.clear();
+  EXPECT_EQ(b.size(), 0);
+  EXPECT_EQ(b.total_height(), 0);
+  return true;
+}
+
+/* Fl_Browser with the real line heights, which depend on the font. */
+class Ut_Font_Browser : public Fl_Browser {
+public:
+  Ut_Font_Browser() : Fl_Browser(0, 0, 100, 100) { }
+  int position(int line) { return item_position(find_line(line)); }
+  int line_at(int ypos) {
+    int ly;
+    return lineno(item_at_position(ypos, ly));
+  }
+  int height_of(int line) { return item_height(find_line(line)); }
+  int total_height() const { return full_height(); }
+};
+
+// Compares the cached line positions with the current line heights.
+static bool ut_browser_check(Ut_Font_Browser &b) {
+  int y = 0;
+  for (int line = 1; line <= b.size(); line++) {
+    EXPECT_EQ(b.position(line), y);
+    int hh = b.height_of(line);
+    if (hh > 0) {                     // hidden lines take no space
+      hh += b.linespacing();
+      EXPECT_EQ(b.line_at(y), line);
+      EXPECT_EQ(b.line_at(y + hh - 1), line);
+    }
+    y += hh;
+  }
+  EXPECT_EQ(b.total_height(), y);
+  return true;
+}
+
+/* Test that Fl_Browser line positions follow font and format changes. */
+TEST(Fl_Browser, LineHeights) {
+  Ut_Font_Device dev;
+  Ut_Font_Browser b;
+  char buf[32];
+  for (int i = 0; i < 300; i++) {
+    snprintf(buf, sizeof(buf), i % 7 ? "%03d" : "%03d\t@lbig", i);
+    b.add(buf);
+  }
+  b.hide(5);
+  b.hide(8);
+  EXPECT_TRUE(ut_browser_check(b));
+  b.textfont(FL_COURIER);
+  EXPECT_TRUE(ut_browser_check(b));
+  b.linespacing(3);
+  EXPECT_TRUE(ut_browser_check(b));
+  static const int widths[] = { 40, 0 };
+  b.column_widths(widths);            // "@l" now starts the second column
+  EXPECT_TRUE(ut_browser_check(b));
+  b.format_char(0);
+  EXPECT_TRUE(ut_browser_check(b));
+  b.textsize(20);
+  EXPECT_TRUE(ut_browser_check(b));
+  b.sort(FL_SORT_DESCENDING);
+  EXPECT_STREQ(b.text(1), "299");
+  for (int i = 1; i < b.size(); i++) {
+    EXPECT_TRUE(strcmp(b.text(i), b.text(i + 1)) > 0);
+  }
+  EXPECT_TRUE(ut_browser_check(b));
+  b.sort();
+  EXPECT_STREQ(b.text(1), "000\t@lbig");
+  EXPECT_STREQ(b.text(300), "299");
+  EXPECT_TRUE(ut_browser_check(b));
+  return true;
+}
+
+static const char *ut_line_text(int line, void *data) {
+  snprintf((char *)data, 32, "line %d", line);
+  return (const char *)data;
+}
+
+/* Fl_Virtual_Browser exposing its position mapping. */
+class Ut_Virtual_Browser : public Fl_Virtual_Browser {
+public:
+  Ut_Virtual_Browser() : Fl_Virtual_Browser(0, 0, 100, 100) { }
+  int line_at(int ypos) {
+    int ly;
+    return (int)(fl_intptr_t)item_at_position(ypos, ly);
+  }
+  int position(int line) { return item_position(item_at(line)); }
+  int total_height() const { return full_height(); }
+};
+
+/* Test Fl_Virtual_Browser with many lines and no per-line storage. */
+TEST(Fl_Virtual_Browser, Lines) {
+  char buf[32];
+  Ut_Virtual_Browser b;
+  b.line_height(12);
+  b.linespacing(2);
+  b.text_callback(ut_line_text, buf);
+  b.lines(50000000);
+  EXPECT_EQ(b.lines(), 50000000);
+  EXPECT_EQ(b.total_height(), 50000000 * 14);
+  EXPECT_STREQ(b.text(42000000), "line 42000000");
+  EXPECT_EQ(b.line_at(0), 1);
+  EXPECT_EQ(b.line_at(14 * 1000 + 13), 1001);
+  EXPECT_EQ(b.line_at(2000000000), 50000000); // past the end
+  EXPECT_EQ(b.position(1001), 14 * 1000);
+  b.type(FL_MULTI_BROWSER);
+  b.select(30000000);
+  b.select(7);
+  EXPECT_EQ(b.selected(7), 1);
+  EXPECT_EQ(b.selected(8), 0);
+  EXPECT_EQ(b.selected(30000000), 1);
+  b.select(7, 0);
+  EXPECT_EQ(b.selected(7), 0);
+  b.lines(1000); // drops lines and selections past the end
+  EXPECT_EQ(b.selected(30000000), 0);
+  EXPECT_EQ(b.value(), 0);
+  EXPECT_STREQ(b.text(1001), NULL);
+  return true;
+}
+
+static int ut_populated = 0;
+
+static void ut_populate(Fl_Tree *tree, Fl_Tree_Item *item, void *data) {
+  ut_populated++;
+  for (int i = 0; i < *(int*)data; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "%d", i);
+    tree->add(item, name)->lazy_children(1);
+  }
+}
+
+/* Test lazy population of Fl_Tree items, and pruning of closed items. */
+TEST(Fl_Tree, LazyChildren) {
+  int n = 3;
+  Fl_Tree tree(0, 0, 100, 100);
+  tree.end();
+  tree.populate_callback(ut_populate, &n);
+  Fl_Tree_Item *a = tree.add("a");
+  a->lazy_children(1);
+  EXPECT_EQ(a->lazy_children(), 1);
+  EXPECT_EQ(a->is_close(), 1);
+  EXPECT_EQ(a->children(), 0);
+  EXPECT_EQ(ut_populated, 0);
+  tree.open(a, 0);
+  EXPECT_EQ(ut_populated, 1);
+  EXPECT_EQ(a->lazy_children(), 0);
+  EXPECT_EQ(a->children(), 3);
+  EXPECT_STREQ(a->child(2)->label(), "2");
+  tree.open(a->child(1), 0);          // one more level
+  EXPECT_EQ(a->child(1)->children(), 3);
+  EXPECT_EQ(tree.prune(), 0);         // nothing is closed
+  tree.close(a, 0);
+  tree.open(a, 0);                    // children are kept until pruned
+  EXPECT_EQ(ut_populated, 2);
+  tree.close(a, 0);
+  EXPECT_EQ(tree.prune(), 6);
+  EXPECT_EQ(a->children(), 0);
+  EXPECT_EQ(a->lazy_children(), 1);
+  n = 0;                              // callback adds nothing: item becomes a leaf
+  tree.open(a, 0);
+  EXPECT_EQ(ut_populated, 3);
+  EXPECT_EQ(a->children(), 0);
+  EXPECT_EQ(a->lazy_children(), 0);
+  EXPECT_EQ(tree.prune(), 0);
+  // an item with children made lazy: its children are freed, then created by the callback
+  Fl_Tree_Item *b = tree.add("b");
+  tree.add(b, "x");
+  Fl_Tree_Item *y = tree.add(b, "y");
+  tree.add(y, "z");
+  tree.select(y, 0);                  // tree remembers y as last selected item
+  b->lazy_children(1);
+  EXPECT_EQ(b->children(), 0);
+  EXPECT_EQ(b->is_close(), 1);
+  EXPECT_TRUE(tree.find_item("b/y") == 0);
+  EXPECT_TRUE(tree.get_item_focus() != y);
+  n = 2;
+  tree.open(b, 0);
+  EXPECT_EQ(ut_populated, 4);
+  EXPECT_EQ(b->children(), 2);
+  EXPECT_STREQ(b->child(1)->label(), "1");
+  tree.close(b, 0);
+  EXPECT_EQ(tree.prune(), 2);
+  return true;
+}
+
+class Ut_Tree : public Fl_Tree {
+public:
+  Ut_Tree() : Fl_Tree(0, 0, 200, 300) { end(); }
+  using Fl_Tree::item_y;
+  void scroll(int y) { _vscroll->value(y); }
+  void render() { damage(FL_DAMAGE_ALL); draw(); }
+  int in_view(int y) const { return y >= _tiy && y <= _tiy + _tih; }
+};
+
+// Draws the tree, which only walks the items in view and updates their
+// cached heights, then checks item_y() and find_clicked() for all open
+// items against the positions set by a full walk of the tree.
+static bool ut_tree_check(Ut_Tree &tree) {
+  tree.render();
+  std::vector<Fl_Tree_Item*> items;
+  std::vector<int> ys;
+  std::vector<Fl_Tree_Item*> clicked;
+  for (Fl_Tree_Item *item = tree.first_visible_item(); item;
+       item = tree.next_visible_item(item, FL_Down)) {
+    int y = tree.item_y(item);
+    if (tree.in_view(y)) {                            // drawn items: same as y()
+      EXPECT_EQ(y, item->y());
+    }
+    Fl::e_y = y + 1;
+    items.push_back(item);
+    ys.push_back(y);
+    clicked.push_back(tree.find_clicked(1));
+  }
+  EXPECT_TRUE(items.size() > 0);
+  tree.calc_tree();                                   // full walk sets y() of all items
+  for (size_t i = 0; i < items.size(); i++) {
+    EXPECT_EQ(ys[i], items[i]->y());
+    EXPECT_TRUE(clicked[i] == items[i]);
+  }
+  return true;
+}
+
+/* Test Fl_Tree's cached heights against a full walk of the tree. */
+TEST(Fl_Tree, CachedHeights) {
+  Ut_Font_Device dev;
+  Ut_Tree tree;
+  tree.linespacing(2);
+  char path[32];
+  for (int i = 0; i < 30; i++) {
+    for (int j = 0; j < 4; j++) {
+      snprintf(path, sizeof(path), "%02d/%d", i, j);
+      tree.add(path);
+    }
+    if (i % 3 == 0) {
+      snprintf(path, sizeof(path), "%02d/1/x", i);
+      tree.add(path);
+    }
+  }
+  tree.find_item("03")->labelsize(30);        // rows of different heights
+  EXPECT_TRUE(ut_tree_check(tree));
+  for (int y = 100; y <= 1200; y += 350) {    // scroll, drawing only part of the tree
+    tree.scroll(y);
+    EXPECT_TRUE(ut_tree_check(tree));
+  }
+  tree.close("05", 0);                        // open state changes above and in view
+  tree.close("09/1", 0);
+  tree.close("24", 0);
+  EXPECT_TRUE(ut_tree_check(tree));
+  tree.open("05", 0);
+  EXPECT_TRUE(ut_tree_check(tree));
+  tree.scroll(400);
+  tree.find_item("01/2")->labelsize(40);      // item sizes change above and in view
+  tree.find_item("12/3")->labelsize(6);
+  tree.find_item("27")->labelsize(20);
+  EXPECT_TRUE(ut_tree_check(tree));
+  tree.insert(tree.find_item("12"), "new", 2);
+  tree.insert_above(tree.find_item("20"), "above");
+  EXPECT_TRUE(ut_tree_check(tree));
+  tree.remove(tree.find_item("15"));
+  tree.remove(tree.find_item("00/1/x"));
+  EXPECT_TRUE(ut_tree_check(tree));
+  tree.showroot(0);
+  tree.scroll(0);
+  EXPECT_TRUE(ut_tree_check(tree));
+  Fl::e_y = 0;
+  return true;
+}
+
+class Ut_Table : public Fl_Table {
+public:
+  Ut_Table() : Fl_Table(0, 0, 100, 100) { end(); }
+  void draw_cell(TableContext, int, int, int, int, int, int) override { }
+  int top_row() const { return toprow; }
+  long position(int row) { return row_scroll_position(row); }
+};
+
+/* Test Fl_Table row positions with uniform and individual row heights. */
+TEST(Fl_Table, RowPositions) {
+  Ut_Table t;
+  t.cols(1);
+  t.rows(10000000);                   // uniform: no memory per row
+  t.row_height_all(20);
+  EXPECT_EQ(t.position(10000000), 200000000L);
+  EXPECT_EQ(t.position(123457), 2469140L);
+  t.row_height(5, 50);                // individual heights from here on
+  t.row_height(9999999, 7);
+  EXPECT_EQ(t.row_height(5), 50);
+  EXPECT_EQ(t.row_height(6), 20);
+  EXPECT_EQ(t.position(5), 100L);
+  EXPECT_EQ(t.position(6), 150L);
+  EXPECT_EQ(t.position(10000000), 200000000L + 30 - 13);
+  t.row_position(5000000);
+  EXPECT_EQ(t.top_row(), 5000000);
+  t.rows(100);                        // shrink, then grow with the last height
+  t.rows(200);
+  EXPECT_EQ(t.row_height(150), 20);
+  EXPECT_EQ(t.position(200), 200 * 20L + 30);
+  t.row_height(300, 9);               // past the end: adds rows of that height
+  EXPECT_EQ(t.row_height(299), 9);
+  t.row_height_all(3);
+  EXPECT_EQ(t.position(200), 600L);
+  return true;
+}
+
 //
 //------- test aspects of the FLTK core library ----------
 //
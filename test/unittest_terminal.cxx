@@ -17,8 +17,285 @@
 #include "unittests.h"
 
 #include <time.h>
+#include <string>
+#include <vector>
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Terminal.H>
+#include <FL/Fl_Graphics_Driver.H>
+#include <FL/Fl_Device.H>
+#include <FL/fl_utf8.h>
+
+//
+//------- headless Fl_Terminal tests ----------
+//
+
+// Graphics driver that draws nothing, but records the text drawn.
+//    Chars are 8 pixels wide, except combining marks which are 0.
+//
+class Ut_Text_Driver : public Fl_Graphics_Driver {
+public:
+  std::string text;     // concatenation of all text drawn
+  int max_len;          // longest string passed to a single draw()
+  double char_w;        // width of all chars but combining marks
+  std::vector<int> draw_x, draw_n;  // position and length of each draw()
+  Ut_Text_Driver() : max_len(0), char_w(8) { }
+  void draw(const char *str, int n, int x, int) FL_OVERRIDE {
+    text.append(str, n);
+    if (n > max_len) max_len = n;
+    draw_x.push_back(x);
+    draw_n.push_back(n);
+  }
+  double width(const char *str, int n) FL_OVERRIDE {
+    double w = 0;
+    for (const char *end = str + n; str < end; ) {
+      int len;
+      unsigned c = fl_utf8decode(str, end, &len);
+      w += (c >= 0x300 && c < 0x370) ? 0 : char_w;
+      str += len;
+    }
+    return w;
+  }
+  int height() FL_OVERRIDE { return 16; }
+  int descent() FL_OVERRIDE { return 4; }
+};
+
+// Makes a Ut_Text_Driver current while in scope
+class Ut_Text_Device : public Fl_Surface_Device {
+public:
+  Ut_Text_Driver *text_driver;
+  Ut_Text_Device() : Fl_Surface_Device(text_driver = new Ut_Text_Driver) { push_current(this); }
+  ~Ut_Text_Device() { pop_current(); delete text_driver; }
+};
+
+// Terminal that exposes the protected methods the tests need
+class Ut_Terminal : public Fl_Terminal {
+public:
+  typedef Utf8Char Cell;
+  using Fl_Terminal::hist_use;
+  Ut_Terminal(int rows, int cols)
+    : Fl_Terminal(0, 0, 800, 400, 0, rows, cols, 10) { }
+  void draw_row(int grow) const { Fl_Terminal::draw_row(grow, 0); }
+  void draw_done() { Fl_Terminal::draw_done(); }
+  bool is_dirty(int drow) const { return is_dirty_ring_row(disp_srow() + drow); }
+  int  grow(int drow) const { return disp_srow() + drow; }
+  int  scrolled_rows() const { return Fl_Terminal::scrolled_rows(); }
+  int  cells() const { return ring_rows() * ring_cols(); }
+  Fl_Color fgcolor(int drow, int dcol) const { return utf8_char_at_disp(drow, dcol)->fgcolor(); }
+  static int styles() { return char_styles_count(); }
+  const Cell *cell(int drow, int dcol) const { return utf8_char_at_disp(drow, dcol); }
+  // Return the first ring row that differs from 'o', -1 if none
+  int compare_ring(const Ut_Terminal &o) const {
+    if (offset() != o.offset() || hist_use() != o.hist_use() ||
+        cursor_row() != o.cursor_row() || cursor_col() != o.cursor_col())
+      return ring_rows();
+    for (int row = 0; row < ring_rows(); row++) {
+      const Utf8Char *a = u8c_ring_row(row), *b = o.u8c_ring_row(row);
+      for (int col = 0; col < ring_cols(); col++, a++, b++) {
+        if (a->length() != b->length() ||
+            memcmp(a->text_utf8(), b->text_utf8(), a->length()) != 0 ||
+            a->attrib() != b->attrib() || a->charflags() != b->charflags() ||
+            a->fgcolor() != b->fgcolor() || a->bgcolor() != b->bgcolor())
+          return row;
+      }
+    }
+    return -1;
+  }
+};
+
+/* A long run of zero width combining marks must not overflow the run buffer. */
+TEST(Fl_Terminal, DrawCombiningRun) {
+  Ut_Text_Device dev;
+  Ut_Terminal tty(5, 300);
+  std::string line;
+  for (int i = 0; i < 250; i++) line += "\xcc\x81";   // U+0301 COMBINING ACUTE ACCENT
+  line += "b";
+  tty.append(line.c_str());
+  tty.draw_row(tty.grow(0));
+  EXPECT_STREQ(dev.text_driver->text.c_str(), line.c_str());
+  EXPECT_TRUE(dev.text_driver->max_len <= 256);
+  return true;
+}
+
+/*
+  With a fractional char width, chars are drawn in runs, and fl_draw()
+  places every char of a run within one pixel of its cell.
+*/
+TEST(Fl_Terminal, DrawFractionalRun) {
+  Ut_Text_Device dev;
+  dev.text_driver->char_w = 7.3;          // cells are 7 pixels wide
+  Ut_Terminal tty(5, 100);
+  std::string line(100, 'a');
+  tty.append(line.c_str());
+  tty.draw_row(tty.grow(0));
+  Ut_Text_Driver *drv = dev.text_driver;
+  EXPECT_STREQ(drv->text.c_str(), line.c_str());
+  EXPECT_TRUE(drv->draw_x.size() < 40);  // not one draw() per char
+  bool on_grid = true;
+  int col = 0, x0 = drv->draw_x[0];      // x0: left edge of the first cell
+  for (size_t i = 0; i < drv->draw_x.size(); i++) {
+    if (drv->draw_x[i] != x0 + col * 7) on_grid = false;
+    for (int j = 0; j < drv->draw_n[i]; j++, col++) {
+      double drift = drv->draw_x[i] + j * 7.3 - (x0 + col * 7);
+      if (drift > 1.0 || drift < -1.0) on_grid = false;
+    }
+  }
+  EXPECT_TRUE(on_grid);
+  EXPECT_EQ(col, 100);
+  return true;
+}
+
+/* Only rows modified since the last draw are redrawn. */
+TEST(Fl_Terminal, DirtyRows) {
+  Ut_Text_Device dev;
+  Ut_Terminal tty(5, 40);
+  tty.draw_done();
+  EXPECT_EQ(tty.scrolled_rows(), 0);
+  // writing to one line marks only that row
+  tty.append("\033[3;1Hhello");
+  for (int drow = 0; drow < 5; drow++) {
+    EXPECT_EQ(tty.is_dirty(drow), drow == 2);
+  }
+  EXPECT_EQ(tty.scrolled_rows(), 0);
+  tty.draw_done();
+  // a newline on the last row scrolls the display by one line
+  tty.append("\033[5;1Hbottom\n");
+  EXPECT_EQ(tty.scrolled_rows(), 1);
+  tty.draw_done();
+  // a resize redraws everything
+  tty.display_rows(8);
+  EXPECT_EQ(tty.scrolled_rows(), -1);
+  for (int drow = 0; drow < 8; drow++) {
+    EXPECT_TRUE(tty.is_dirty(drow));
+  }
+  tty.draw_done();
+  tty.display_columns(60);
+  EXPECT_EQ(tty.scrolled_rows(), -1);
+  return true;
+}
+
+/* Styles no longer used by any char are removed from the style table. */
+TEST(Fl_Terminal, StyleTableBound) {
+  Ut_Text_Device dev;
+  Ut_Terminal tty(10, 40);
+  char s[80];
+  // a row of chars with distinct colors
+  for (int i = 0; i < 40; i++) {
+    snprintf(s, sizeof(s), "\033[38;2;%d;1;2mx", i);
+    tty.append(s);
+  }
+  // overwrite a single char with 100000 other colors
+  for (int i = 0; i < 100000; i++) {
+    snprintf(s, sizeof(s), "\033[6;1H\033[38;2;%d;%d;%dmy", (i >> 16) & 255, (i >> 8) & 255, i & 255);
+    tty.append(s);
+  }
+  // default, 40 colors, 'y', and the color of cleared chars
+  EXPECT_TRUE(Ut_Terminal::styles() <= 43);
+  for (int i = 0; i < 40; i++) {
+    EXPECT_EQ((int)tty.fgcolor(0, i), (int)fl_rgb_color(i, 1, 2));
+  }
+  EXPECT_EQ((int)tty.fgcolor(5, 0), (int)fl_rgb_color(1, 134, 159));   // 99999
+  // scroll 100000 chars of distinct colors through display and history:
+  // the table holds at most the styles of all chars
+  tty.append("\033[10;1H");
+  for (int i = 0; i < 99990; i++) {
+    snprintf(s, sizeof(s), "\033[38;2;%d;%d;%dmz", (i >> 16) & 255, (i >> 8) & 255, i & 255);
+    tty.append(s);
+  }
+  EXPECT_TRUE(Ut_Terminal::styles() <= tty.cells() + 3);
+  EXPECT_EQ(tty.cursor_col(), 99990 % 40);
+  EXPECT_EQ((int)tty.fgcolor(tty.cursor_row(), tty.cursor_col() - 1), (int)fl_rgb_color(1, 134, 149)); // 99989
+  return true;
+}
+
+/* A full style table falls back to the default style, and is freed with the last terminal. */
+TEST(Fl_Terminal, StyleTableFull) {
+  Ut_Text_Device dev;
+  {
+    Ut_Terminal tty(300, 250);                  // more chars than the 65536 styles
+    char s[80];
+    for (int i = 0; i < 70000; i++) {
+      snprintf(s, sizeof(s), "\033[38;2;%d;%d;%dmz", (i >> 16) & 255, (i >> 8) & 255, i & 255);
+      tty.append(s);
+    }
+    EXPECT_EQ(Ut_Terminal::styles(), 65536);
+    EXPECT_EQ((int)tty.fgcolor(0, 1), (int)fl_rgb_color(0, 0, 1));
+    // the last chars didn't get a style of their own
+    EXPECT_EQ((int)tty.fgcolor(tty.cursor_row(), tty.cursor_col() - 1), (int)Ut_Terminal::Cell().fgcolor());
+    // clearing screen and history frees the entries for new styles
+    tty.append("\033[0m\033[2J\033[3J\033[H\033[38;2;1;2;3mw");
+    EXPECT_TRUE(Ut_Terminal::styles() <= 3);   // default, cleared chars, 1;2;3
+    EXPECT_EQ((int)tty.fgcolor(0, 0), (int)fl_rgb_color(1, 2, 3));
+  }
+  EXPECT_EQ(Ut_Terminal::styles(), 1);           // only the default style is left
+  return true;
+}
+
+/* Chars keep their attributes and colors through the style table. */
+TEST(Fl_Terminal, StyleRoundTrip) {
+  Ut_Text_Device dev;
+  Ut_Terminal tty(5, 40);
+  for (int a = 0; a < 256; a++) {
+    tty.textattrib((uchar)a);
+    if (a & 1) tty.textfgcolor_xterm((uchar)(a % 8));
+    else       tty.textfgcolor(fl_rgb_color((uchar)a, 2, 3));
+    if (a & 2) tty.textbgcolor_xterm((uchar)(a / 8 % 8));
+    else       tty.textbgcolor(fl_rgb_color(4, (uchar)a, 5));
+    uchar flags = ((a & 1) ? Fl_Terminal::FG_XTERM : 0) | ((a & 2) ? Fl_Terminal::BG_XTERM : 0);
+    tty.plot_char('p', 0, 0);                     // per char path
+    tty.append("\033[2;1Hbulk");                  // bulk path
+    for (int col = -1; col < 4; col++) {
+      const Ut_Terminal::Cell *u8c = col < 0 ? tty.cell(0, 0) : tty.cell(1, col);
+      EXPECT_EQ(u8c->attrib(), a);
+      EXPECT_EQ(u8c->charflags() & Fl_Terminal::COLORMASK, flags);
+      EXPECT_EQ((int)u8c->fgcolor(), (int)tty.textfgcolor());
+      EXPECT_EQ((int)u8c->bgcolor(), (int)tty.textbgcolor());
+    }
+  }
+  return true;
+}
+
+/* Bulk ASCII output must leave the ring exactly as char by char output does. */
+TEST(Fl_Terminal, BulkAscii) {
+  Ut_Text_Device dev;
+  Ut_Terminal bulk(6, 40), single(6, 40);
+  std::string text;
+  char s[100];
+  for (int i = 0; i < 400; i++) {
+    // lines of 0..119 chars: shorter, as long as, and longer than a row,
+    // with color changes inside, so the display wraps and scrolls
+    snprintf(s, sizeof(s), "\033[3%dm", i % 8);
+    int len = (i * 7) % 120;
+    for (int j = 0; j < len; j++) {
+      text += (char)('!' + (i + j) % 94);
+      if (j == len / 2) text += s;
+    }
+    text += (i % 5 == 0) ? "\033[0m\r\n" : "\n";
+  }
+  bulk.append(text.c_str());
+  for (size_t i = 0; i < text.size(); i++) single.print_char(text[i]);
+  EXPECT_EQ(bulk.compare_ring(single), -1);
+  EXPECT_TRUE(bulk.hist_use() > 0);
+
+  // Throughput
+  std::string lines;
+  for (int i = 0; i < 2000; i++) lines += "The quick brown fox jumps over the lazy dog. 0123456789\n";
+  Ut_Terminal tty(24, 80);
+  const int reps = 10;
+  Fl_Timestamp start = Fl::now();
+  for (int i = 0; i < reps; i++) tty.append(lines.c_str());
+  double bulk_secs = Fl::seconds_since(start);
+  start = Fl::now();
+  for (int i = 0; i < reps; i++)
+    for (size_t j = 0; j < lines.size(); j++) tty.print_char(lines[j]);
+  double single_secs = Fl::seconds_since(start);
+  double mb = double(lines.size()) * reps / (1024 * 1024);
+  Ut_Suite::printf("             append(): %.0f MB/s, print_char(): %.0f MB/s\n",
+                   mb / (bulk_secs + 1e-9), mb / (single_secs + 1e-9));
+  // the scrollbar must still cover the whole history, which filled up long ago
+  EXPECT_EQ(tty.history_use(), tty.history_rows());
+  EXPECT_EQ((int)tty.scrollbar->minimum(), tty.history_use());
+  return true;
+}
 
 //
 //------- test the Fl_Terminal drawing capabilities ----------
@@ -38,6 +38,8 @@
 #include <FL/fl_ask.H>                // fl_message()
 #include <FL/filename.H>              // fl_filename_name
 #include <stdlib.h>                   // malloc, free
+#include <stdio.h>                    // snprintf
+#include <string.h>                   // strstr
 
 class Ut_Main_Window *mainwin = NULL;
 class Fl_Hold_Browser *browser = NULL;
@@ -184,6 +186,7 @@ const char *Ut_Suite::red = "\033[31m";
 const char *Ut_Suite::green = "\033[32m";
 const char *Ut_Suite::normal = "\033[0m";
 Fl_Terminal *Ut_Suite::tty = NULL;
+char Ut_Suite::data_path_[FL_PATH_MAX] = "";
 
 /** Switch the user of color escape sequnces in the log text. */
 void Ut_Suite::color(int v) {
@@ -198,6 +201,29 @@ void Ut_Suite::color(int v) {
   }
 }
 
+/** Find the test data files from the path of the test program, like test/demo does.
+ The build copies them to build/data, and the test programs are in build/bin/test
+ or build/bin/test/<config>. Otherwise they are expected next to the program.
+ */
+void Ut_Suite::data_path(const char *argv0) {
+  if (!argv0 || !argv0[0]) return;              // use the working directory
+  fl_filename_absolute(data_path_, FL_PATH_MAX, argv0);
+#ifdef _WIN32
+  for (char *p = data_path_; *p; p++)
+    if (*p == '\\') *p = '/';
+#endif
+  *(char *)fl_filename_name(data_path_) = 0;    // keep the trailing '/'
+  char *pos = strstr(data_path_, "/bin/test/");
+  if (pos) strcpy(pos, "/data/");
+}
+
+/** Return the path of the test data file \p name, e.g. "images/FL200.png". */
+const char *Ut_Suite::data_file(const char *name) {
+  static char path[FL_PATH_MAX];
+  snprintf(path, sizeof(path), "%s%s", data_path_, name);
+  return path;
+}
+
 /** Create a suite that will group tests by the suite name.
 
  Ut_Suite is automatically instantiated by using the TEST(SUITE, NAME) macro.
@@ -424,6 +450,7 @@ static int arg(int argc, char** argv, int& i) {
 int main(int argc, char** argv) {
   int i;
   Fl::args_to_utf8(argc, argv); // for MSYS2/MinGW
+  Ut_Suite::data_path(argc > 0 ? argv[0] : NULL);
   if ( Fl::args(argc,argv,i,arg) == 0 ) {   // unsupported argument found
     static const char *msg =
       "usage: %s <switches>\n"
@@ -127,6 +127,7 @@ class Ut_Suite {
   static int num_tests_;
   static int num_passed_;
   static int num_failed_;
+  static char data_path_[];
 
   Ut_Test **test_list_;
   int test_list_size_;
@@ -150,6 +151,8 @@ public:
   static void print_epilog();
   static void color(int);
   static int failed() { return num_failed_; }
+  static void data_path(const char *argv0);
+  static const char *data_file(const char *name);
   static const char *red;
   static const char *green;
   static const char *normal;
@@ -165,7 +168,7 @@ public:
  */
 #define TEST(SUITE, CASE) \
   static bool UT_CONCAT(test_call_, __LINE__)(); \
-  Ut_Test UT_CONCAT(test__, __LINE__)(#SUITE, #CASE, UT_CONCAT(test_call_, __LINE__)); \
+  static Ut_Test UT_CONCAT(test__, __LINE__)(#SUITE, #CASE, UT_CONCAT(test_call_, __LINE__)); \
   static bool UT_CONCAT(test_call_, __LINE__)()
 
 /** Create a test case where the result is expected to be a boolena with the value true */